@@ -0,0 +1,14 @@
+#include "libdevcore/SHA3.h"
+#include "libdevcore/TrieHash.h"
+#include "libdevcore/RLP.h"
+#include <iostream>
+using namespace dev;
+int main(){
+
+  std::vector<bytes> receipts;
+  for (unsigned i = 0; i < 300; i++) receipts.push_back(rlpList(i, bytes(i % 70, (byte)i)));
+  std::cout << orderedTrieRoot(receipts) << "\n";
+  std::vector<bytes> small; for(unsigned i=0;i<20;i++) small.push_back(rlpList(i));
+  std::cout << orderedTrieRoot(small) << "\n";
+  return 0;
+}
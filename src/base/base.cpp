@@ -29,6 +29,7 @@ using namespace appbase;
 
 std::unique_ptr<CArgsManager> appbase::IBaseApp::pArgs = std::make_unique<CArgsManager>();
 std::unique_ptr<CChainParams> appbase::IBaseApp::pChainParams = std::make_unique<CChainParams>();
+IComponent *appbase::IBaseApp::componentSlots[MAX_COMPONENT_SLOTS] = {};
 
 const CArgsManager &Args()
 {
@@ -193,6 +194,16 @@ IComponent *IBaseApp::FindComponent(int id) const
     return nullptr;
 }
 
+bool IBaseApp::SetComponentSlot(int id, IComponent *component)
+{
+    if (id <= 0 || (id & (id - 1)) != 0 || ComponentSlot(id) >= MAX_COMPONENT_SLOTS)
+    {
+        return false;
+    }
+    componentSlots[ComponentSlot(id)] = component;
+    return true;
+}
+
 CScheduler &IBaseApp::GetScheduler()
 {
     assert(false); // This method should never be called.
@@ -45,13 +45,27 @@ namespace appbase
         template<typename Component>
         Component *FindComponent() const
         {
-            if (auto ic = FindComponent(Component::ID))
-            {
-                return static_cast<Component*>(ic);
-            }
-            return nullptr;
+            return GetComponent<Component>();
         };
 
+        //! Component ids are single bits, a component's slot is the index of its bit
+        static constexpr int ComponentSlot(int id)
+        {
+            return id <= 1 ? 0 : 1 + ComponentSlot(id >> 1);
+        }
+
+        static const int MAX_COMPONENT_SLOTS = 16;
+
+        /** The registered component of type Component, nullptr if there is none. The slot is resolved at compile time */
+        template<typename Component>
+        static Component *GetComponent()
+        {
+            static_assert(Component::ID > 0 && (Component::ID & (Component::ID - 1)) == 0,
+                          "component ids are single bits");
+            static_assert(ComponentSlot(Component::ID) < MAX_COMPONENT_SLOTS, "component id out of the slot range");
+            return static_cast<Component *>(componentSlots[ComponentSlot(Component::ID)]);
+        }
+
         uint64_t nVersion;
         static std::unique_ptr<CArgsManager> pArgs;
         static std::unique_ptr<CChainParams> pChainParams;
@@ -63,7 +77,16 @@ namespace appbase
 
         virtual IComponent *FindComponent(int id) const;
 
+        /**
+         * Puts component in the slot of id, for GetComponent. Done at registration, before any other
+         * thread looks components up; nullptr empties the slot again.
+         */
+        static bool SetComponentSlot(int id, IComponent *component);
+
         volatile bool bShutdown;
+
+    private:
+        static IComponent *componentSlots[MAX_COMPONENT_SLOTS];
     };
 }
 
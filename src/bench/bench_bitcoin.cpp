@@ -5,6 +5,7 @@
 #include "bench.h"
 
 #include "crypto/sha256.h"
+#include "contract/libdevcore/SHA3.h"
 #include "wallet/key.h"
 #include "block/validation.h"
 #include "utils/util.h"
@@ -14,10 +15,10 @@ int
 main(int argc, char **argv)
 {
     SHA256AutoDetect();
+    dev::sha3AutoDetect();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
-    fPrintToDebugLog = false; // don't want to write to debug.log file
 
     benchmark::BenchRunner::RunAll();
 
@@ -0,0 +1,138 @@
+#include "bench.h"
+#include "base/base.hpp"
+#include "framework/component.hpp"
+#include "interface/componentid.h"
+
+#include <cassert>
+#include <map>
+#include <memory>
+
+namespace
+{
+template<int nID>
+class BenchComponent : public appbase::TComponent<BenchComponent<nID>>
+{
+public:
+    enum
+    {
+        ID = nID
+    };
+
+    int GetID() const override
+    {
+        return ID;
+    }
+
+    bool ComponentInitialize()
+    {
+        return true;
+    }
+
+    bool ComponentStartup()
+    {
+        return true;
+    }
+
+    bool ComponentShutdown()
+    {
+        return true;
+    }
+};
+
+typedef BenchComponent<CID_BLOCK_CHAIN> BenchChain;
+typedef BenchComponent<CID_CONTRACT> BenchContract;
+typedef BenchComponent<CID_TX_MEMPOOL> BenchMempool;
+typedef BenchComponent<CID_P2P_NET> BenchNet;
+
+// The lookup GET_*_INTERFACE used to do: a virtual call into a map of the registered components.
+class MapRegistry
+{
+public:
+    virtual ~MapRegistry()
+    {
+    }
+
+    void Register(appbase::IComponent *component)
+    {
+        mapComponents.emplace(component->GetID(), std::unique_ptr<appbase::IComponent>(component));
+    }
+
+    virtual appbase::IComponent *FindComponent(int id) const
+    {
+        auto it = mapComponents.find(id);
+        if (it != mapComponents.end())
+            return it->second.get();
+        return nullptr;
+    }
+
+    template<typename Component>
+    Component *FindComponent() const
+    {
+        return static_cast<Component *>(FindComponent(Component::ID));
+    }
+
+private:
+    std::map<int, std::unique_ptr<appbase::IComponent>> mapComponents;
+};
+
+// Only for its access to the slot registration.
+class SlotRegistry : public appbase::IBaseApp
+{
+public:
+    using appbase::IBaseApp::SetComponentSlot;
+};
+
+void AddComponents(MapRegistry &registry)
+{
+    registry.Register(new BenchChain);
+    registry.Register(new BenchContract);
+    registry.Register(new BenchMempool);
+    registry.Register(new BenchNet);
+    registry.Register(new BenchComponent<CID_HTTP_RPC>);
+    registry.Register(new BenchComponent<CID_WALLET>);
+    registry.Register(new BenchComponent<CID_MINER>);
+}
+}
+
+// A ConnectBlock-like mix of lookups, four per iteration.
+static void ComponentLookupMap(benchmark::State &state)
+{
+    MapRegistry registry;
+    AddComponents(registry);
+    MapRegistry *pregistry = &registry;
+    uint64_t n = 0;
+    while (state.KeepRunning())
+    {
+        n += (uintptr_t)pregistry->FindComponent<BenchChain>();
+        n += (uintptr_t)pregistry->FindComponent<BenchContract>();
+        n += (uintptr_t)pregistry->FindComponent<BenchMempool>();
+        n += (uintptr_t)pregistry->FindComponent<BenchNet>();
+    }
+    assert(n != 0);
+}
+
+static void ComponentLookupSlot(benchmark::State &state)
+{
+    BenchChain chain;
+    BenchContract contract;
+    BenchMempool mempool;
+    BenchNet net;
+    SlotRegistry::SetComponentSlot(CID_BLOCK_CHAIN, &chain);
+    SlotRegistry::SetComponentSlot(CID_CONTRACT, &contract);
+    SlotRegistry::SetComponentSlot(CID_TX_MEMPOOL, &mempool);
+    SlotRegistry::SetComponentSlot(CID_P2P_NET, &net);
+    uint64_t n = 0;
+    while (state.KeepRunning())
+    {
+        n += (uintptr_t)appbase::IBaseApp::GetComponent<BenchChain>();
+        n += (uintptr_t)appbase::IBaseApp::GetComponent<BenchContract>();
+        n += (uintptr_t)appbase::IBaseApp::GetComponent<BenchMempool>();
+        n += (uintptr_t)appbase::IBaseApp::GetComponent<BenchNet>();
+    }
+    assert(n != 0);
+    for (int id : {CID_BLOCK_CHAIN, CID_CONTRACT, CID_TX_MEMPOOL, CID_P2P_NET})
+        SlotRegistry::SetComponentSlot(id, nullptr);
+}
+
+BENCHMARK(ComponentLookupMap);
+BENCHMARK(ComponentLookupSlot);
@@ -0,0 +1,132 @@
+#include "bench.h"
+#include "eventmanager/eventmanager.h"
+
+#include <boost/any.hpp>
+
+namespace
+{
+// The dispatch CEventManager used to do: handlers stored as boost::any behind one mutex,
+// any_cast and copied on every send, and a newly allocated queue item per posted handler.
+class LegacyEventManager
+{
+public:
+    template<typename... TArgs, typename TFunctor>
+    void RegisterEventHandler(int eventID, const TFunctor &functor)
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        mapEventHandlers[eventID].emplace(-EHP_MEDIAN, std::function<void(TArgs...)>(functor));
+    }
+
+    template<typename... TArgs>
+    int SendEvent(int eventID, TArgs... args)
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        auto it = mapEventHandlers.find(eventID);
+        if (it == mapEventHandlers.end())
+            return -1;
+        for (auto &eachHandler : it->second)
+        {
+            std::function<void(TArgs...)> callback = boost::any_cast<std::function<void(TArgs...)>>(eachHandler.second);
+            callback(args...);
+        }
+        return 0;
+    }
+
+    template<typename... TArgs>
+    int PostEvent(CEventDispatcher &dispatcher, int eventID, TArgs... args)
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        auto it = mapEventHandlers.find(eventID);
+        if (it == mapEventHandlers.end())
+            return -1;
+        for (auto &eachHandler : it->second)
+        {
+            std::unique_ptr<EventQueuedItem> queueItem(new EventQueuedItem);
+            queueItem->flags = EHF_NOTHING;
+            queueItem->postID = std::this_thread::get_id();
+            queueItem->syncObj = nullptr;
+            std::function<void(TArgs...)> callback = boost::any_cast<std::function<void(TArgs...)>>(eachHandler.second);
+            queueItem->handler = [callback, args...]() { callback(args...); };
+            dispatcher.AddAsyncEvent(std::move(queueItem));
+        }
+        return 0;
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_map<int, std::multimap<int, boost::any>> mapEventHandlers;
+};
+
+struct EventCounter
+{
+    std::atomic<int64_t> total{0};
+
+    void operator()(int64_t nodeID, bool, int)
+    {
+        total.fetch_add(nodeID, std::memory_order_relaxed);
+    }
+};
+
+// Blocks until the dispatcher has run everything posted before.
+void WaitDispatcher(CEventDispatcher &dispatcher)
+{
+    CMultiWaiter waiter(1);
+    dispatcher.AddAsyncEvent(EHF_NOTHING, &waiter, []() {});
+    waiter.Wait();
+}
+}
+
+static void EventSendLegacy(benchmark::State &state)
+{
+    EventCounter counter;
+    LegacyEventManager eventManager;
+    eventManager.RegisterEventHandler<int64_t, bool, int>(EID_NODE_CONNECTED, std::ref(counter));
+    eventManager.RegisterEventHandler<int64_t, bool, int>(EID_NODE_CONNECTED, std::ref(counter));
+    while (state.KeepRunning())
+    {
+        eventManager.SendEvent(EID_NODE_CONNECTED, (int64_t)1, true, 0);
+    }
+}
+
+static void EventSend(benchmark::State &state)
+{
+    EventCounter counter;
+    CEventManager eventManager;
+    eventManager.RegisterEventHandler<int64_t, bool, int>(EID_NODE_CONNECTED, std::ref(counter));
+    eventManager.RegisterEventHandler<int64_t, bool, int>(EID_NODE_CONNECTED, std::ref(counter));
+    while (state.KeepRunning())
+    {
+        eventManager.SendEvent(EID_NODE_CONNECTED, (int64_t)1, true, 0);
+    }
+}
+
+static void EventPostLegacy(benchmark::State &state)
+{
+    EventCounter counter;
+    CEventDispatcher dispatcher;
+    LegacyEventManager eventManager;
+    eventManager.RegisterEventHandler<int64_t, bool, int>(EID_NODE_CONNECTED, std::ref(counter));
+    while (state.KeepRunning())
+    {
+        eventManager.PostEvent(dispatcher, EID_NODE_CONNECTED, (int64_t)1, true, 0);
+    }
+    WaitDispatcher(dispatcher);
+    dispatcher.Interrupt();
+}
+
+static void EventPost(benchmark::State &state)
+{
+    EventCounter counter;
+    CEventManager eventManager;
+    eventManager.RegisterEventHandler<int64_t, bool, int>(EID_NODE_CONNECTED, std::ref(counter));
+    while (state.KeepRunning())
+    {
+        eventManager.PostEvent(EID_NODE_CONNECTED, (int64_t)1, true, 0);
+    }
+    eventManager.PostEventAndWait(EID_NODE_CONNECTED, (int64_t)0, true, 0);
+}
+
+BENCHMARK(EventSendLegacy);
+BENCHMARK(EventSend);
+BENCHMARK(EventPostLegacy);
+BENCHMARK(EventPost);
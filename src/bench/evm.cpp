@@ -0,0 +1,100 @@
+#include "bench.h"
+#include <libevm/VMFactory.h>
+#include <libdevcore/SHA3.h>
+
+#include <cassert>
+#include <map>
+
+using namespace dev;
+using namespace dev::eth;
+
+namespace
+{
+// Minimal host: storage lives in a map, every account exists and calls return nothing.
+class BenchExtVM : public ExtVMFace
+{
+public:
+    BenchExtVM(EnvInfo const &_envInfo, bytes const &_code)
+            : ExtVMFace(_envInfo, Address(0x1000), Address(0x2000), Address(0x2000), 0, 1, bytesConstRef(), _code,
+                        sha3(_code), 0)
+    {
+    }
+
+    u256 store(u256 _n) override
+    {
+        auto it = m_store.find(_n);
+        return it == m_store.end() ? 0 : it->second;
+    }
+
+    void setStore(u256 _n, u256 _v) override
+    {
+        m_store[_n] = _v;
+    }
+
+    bool exists(Address) override
+    {
+        return true;
+    }
+
+    boost::optional<owning_bytes_ref> call(CallParameters &) override
+    {
+        return owning_bytes_ref();
+    }
+
+private:
+    std::map<u256, u256> m_store;
+};
+
+// PUSH2 _n; JUMPDEST; <_body>; PUSH1 1; SWAP1; SUB; DUP1; PUSH1 3; JUMPI; STOP
+// _body has to leave the stack as it found it, with the loop counter on top.
+bytes LoopCode(uint16_t _n, bytes const &_body)
+{
+    bytes code = {0x61, byte(_n >> 8), byte(_n), 0x5b};
+    code += _body;
+    code += bytes{0x60, 0x01, 0x90, 0x03, 0x80, 0x60, 0x03, 0x57, 0x00};
+    return code;
+}
+
+void RunLoop(benchmark::State &state, bytes const &_body)
+{
+    const EnvInfo envInfo;
+    const bytes code = LoopCode(1000, _body);
+    while (state.KeepRunning())
+    {
+        BenchExtVM ext(envInfo, code);
+        u256 gas = 100000000;
+        VMFactory::create(VMKind::Interpreter)->exec(gas, ext, OnOpFunc());
+        assert(gas > 0);
+    }
+}
+}
+
+// DUP1 DUP1 MUL PUSH1 7 ADD PUSH1 3 SWAP1 DIV POP
+static void EVMArithmeticLoop(benchmark::State &state)
+{
+    RunLoop(state, bytes{0x80, 0x80, 0x02, 0x60, 0x07, 0x01, 0x60, 0x03, 0x90, 0x04, 0x50});
+}
+
+// DUP1 DUP1 SSTORE DUP1 SLOAD POP
+static void EVMStorageLoop(benchmark::State &state)
+{
+    RunLoop(state, bytes{0x80, 0x80, 0x55, 0x80, 0x54, 0x50});
+}
+
+// DUP1 PUSH1 0 MSTORE PUSH1 32 PUSH1 0 SHA3 POP
+static void EVMKeccakLoop(benchmark::State &state)
+{
+    RunLoop(state, bytes{0x80, 0x60, 0x00, 0x52, 0x60, 0x20, 0x60, 0x00, 0x20, 0x50});
+}
+
+// PUSH1 0 (x5) PUSH1 0x30 PUSH2 0x1000 CALL POP
+static void EVMCallLoop(benchmark::State &state)
+{
+    RunLoop(state, bytes{0x60, 0x00, 0x60, 0x00, 0x60, 0x00, 0x60, 0x00, 0x60, 0x00, 0x60, 0x30, 0x61, 0x10, 0x00,
+                         0xf1, 0x50});
+}
+
+BENCHMARK(EVMArithmeticLoop);
+BENCHMARK(EVMStorageLoop);
+BENCHMARK(EVMKeccakLoop);
+BENCHMARK(EVMCallLoop);
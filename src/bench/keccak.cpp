@@ -0,0 +1,90 @@
+#include "bench.h"
+#include "contract/libdevcore/RLP.h"
+#include "contract/libdevcore/SHA3.h"
+#include "contract/libdevcore/TrieHash.h"
+
+#include <vector>
+
+// Chained 32 byte hashes, the size of trie keys and of the children of trie nodes.
+static void Keccak256_32b(benchmark::State &state, const char *implementation)
+{
+    if (!dev::sha3UseImplementation(implementation))
+        return;
+    dev::h256 hash;
+    while (state.KeepRunning())
+    {
+        for (int i = 0; i < 1000; i++)
+            hash = dev::sha3(hash.ref());
+    }
+    dev::sha3AutoDetect();
+}
+
+static void Keccak256_32b_Batch(benchmark::State &state, const char *implementation)
+{
+    if (!dev::sha3UseImplementation(implementation))
+        return;
+    std::vector<dev::h256> hashes(1000);
+    std::vector<dev::bytesConstRef> inputs;
+    for (dev::h256 &hash : hashes)
+        inputs.push_back(hash.ref());
+    std::vector<dev::h256> outputs(hashes.size());
+    while (state.KeepRunning())
+        dev::sha3(inputs.data(), outputs.data(), inputs.size());
+    dev::sha3AutoDetect();
+}
+
+// The receipts root of a block of 1000 transactions.
+static void Keccak256_TrieRoot(benchmark::State &state, const char *implementation)
+{
+    if (!dev::sha3UseImplementation(implementation))
+        return;
+    std::vector<dev::bytes> receipts;
+    for (unsigned i = 0; i < 1000; i++)
+        receipts.push_back(dev::rlpList(i, dev::h256(i), dev::bytes(100, (byte)i)));
+    while (state.KeepRunning())
+        dev::orderedTrieRoot(receipts);
+    dev::sha3AutoDetect();
+}
+
+static void Keccak256_32b_Standard(benchmark::State &state)
+{
+    Keccak256_32b(state, "standard");
+}
+
+static void Keccak256_32b_Unrolled(benchmark::State &state)
+{
+    Keccak256_32b(state, "unrolled");
+}
+
+static void Keccak256_32b_BMI2(benchmark::State &state)
+{
+    Keccak256_32b(state, "bmi2");
+}
+
+static void Keccak256_32b_Batch_Standard(benchmark::State &state)
+{
+    Keccak256_32b_Batch(state, "standard");
+}
+
+static void Keccak256_32b_Batch_AVX2(benchmark::State &state)
+{
+    Keccak256_32b_Batch(state, "avx2");
+}
+
+static void Keccak256_TrieRoot_Standard(benchmark::State &state)
+{
+    Keccak256_TrieRoot(state, "standard");
+}
+
+static void Keccak256_TrieRoot_AVX2(benchmark::State &state)
+{
+    Keccak256_TrieRoot(state, "avx2");
+}
+
+BENCHMARK(Keccak256_32b_Standard);
+BENCHMARK(Keccak256_32b_Unrolled);
+BENCHMARK(Keccak256_32b_BMI2);
+BENCHMARK(Keccak256_32b_Batch_Standard);
+BENCHMARK(Keccak256_32b_Batch_AVX2);
+BENCHMARK(Keccak256_TrieRoot_Standard);
+BENCHMARK(Keccak256_TrieRoot_AVX2);
@@ -0,0 +1,180 @@
+#include "bench.h"
+#include "compat/compat.h"
+
+#include <cassert>
+#include <string.h>
+#include <vector>
+
+#if defined(HAVE_SYS_EPOLL_H) && !defined(WIN32)
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+namespace
+{
+// nPeers loopback TCP connections. The accepted ends are what the socket handler waits on, the
+// connecting ends play the remote peers.
+class LoopbackPeers
+{
+public:
+    explicit LoopbackPeers(size_t nPeers)
+    {
+        // both ends of every connection live in this process
+        struct rlimit limitFD;
+        getrlimit(RLIMIT_NOFILE, &limitFD);
+        if (limitFD.rlim_cur < nPeers * 2 + 64)
+        {
+            limitFD.rlim_cur = std::min<rlim_t>(nPeers * 2 + 64, limitFD.rlim_max);
+            setrlimit(RLIMIT_NOFILE, &limitFD);
+        }
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        SOCKET hListen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        assert(hListen != INVALID_SOCKET);
+        int nRet = bind(hListen, (struct sockaddr *)&addr, len);
+        if (nRet == 0)
+            nRet = listen(hListen, SOMAXCONN);
+        if (nRet == 0)
+            nRet = getsockname(hListen, (struct sockaddr *)&addr, &len);
+        assert(nRet == 0);
+
+        for (size_t i = 0; i < nPeers; i++)
+        {
+            SOCKET hPeer = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            assert(hPeer != INVALID_SOCKET);
+            nRet = connect(hPeer, (struct sockaddr *)&addr, len);
+            assert(nRet == 0);
+            SOCKET hAccepted = accept(hListen, nullptr, nullptr);
+            assert(hAccepted != INVALID_SOCKET);
+            fcntl(hAccepted, F_SETFL, fcntl(hAccepted, F_GETFL, 0) | O_NONBLOCK);
+            vPeer.push_back(hPeer);
+            vHandler.push_back(hAccepted);
+        }
+        close(hListen);
+    }
+
+    ~LoopbackPeers()
+    {
+        for (SOCKET hSocket : vPeer)
+            close(hSocket);
+        for (SOCKET hSocket : vHandler)
+            close(hSocket);
+    }
+
+    // One peer in turn sends a byte; the handler has to find it among all connections.
+    void SendFromNextPeer()
+    {
+        char ch = 0;
+        ssize_t nBytes = send(vPeer[nNext++ % vPeer.size()], &ch, 1, MSG_NOSIGNAL);
+        assert(nBytes == 1);
+    }
+
+    std::vector<SOCKET> vHandler;
+    std::vector<SOCKET> vPeer;
+
+private:
+    size_t nNext = 0;
+};
+
+// What the select() socket handler does per wakeup: rebuild the fd_set over every connection,
+// then test every connection for readiness.
+void SelectPeers(benchmark::State &state, size_t nPeers)
+{
+    LoopbackPeers peers(nPeers);
+    char buf[256];
+    while (state.KeepRunning())
+    {
+        peers.SendFromNextPeer();
+
+        fd_set fdsetRecv;
+        FD_ZERO(&fdsetRecv);
+        SOCKET hSocketMax = 0;
+        for (SOCKET hSocket : peers.vHandler)
+        {
+            assert(IsSelectableSocket(hSocket));
+            FD_SET(hSocket, &fdsetRecv);
+            hSocketMax = std::max(hSocketMax, hSocket);
+        }
+        int nSelect = select(hSocketMax + 1, &fdsetRecv, nullptr, nullptr, nullptr);
+        assert(nSelect > 0);
+        for (SOCKET hSocket : peers.vHandler)
+            if (FD_ISSET(hSocket, &fdsetRecv))
+                recv(hSocket, buf, sizeof(buf), MSG_DONTWAIT);
+    }
+}
+
+// The epoll socket handler: connections are registered edge-triggered once, and a wakeup only
+// returns the ones that became ready.
+void EpollPeers(benchmark::State &state, size_t nPeers)
+{
+    LoopbackPeers peers(nPeers);
+    int hEpoll = epoll_create1(EPOLL_CLOEXEC);
+    assert(hEpoll != -1);
+    for (SOCKET hSocket : peers.vHandler)
+    {
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = hSocket;
+        int nRet = epoll_ctl(hEpoll, EPOLL_CTL_ADD, hSocket, &event);
+        assert(nRet == 0);
+    }
+    // drain the initial writable edges
+    struct epoll_event events[1024];
+    while (epoll_wait(hEpoll, events, 1024, 0) > 0)
+    {
+    }
+
+    char buf[256];
+    while (state.KeepRunning())
+    {
+        peers.SendFromNextPeer();
+
+        int nEvents = epoll_wait(hEpoll, events, 1024, -1);
+        assert(nEvents > 0);
+        for (int i = 0; i < nEvents; i++)
+            if (events[i].events & EPOLLIN)
+                while (recv(events[i].data.fd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+                {
+                }
+    }
+    close(hEpoll);
+}
+}
+
+// select() cannot go past FD_SETSIZE descriptors, and both ends of each connection count here.
+static void SocketEventsSelect100(benchmark::State &state)
+{
+    SelectPeers(state, 100);
+}
+
+static void SocketEventsSelect500(benchmark::State &state)
+{
+    SelectPeers(state, 500);
+}
+
+static void SocketEventsEpoll100(benchmark::State &state)
+{
+    EpollPeers(state, 100);
+}
+
+static void SocketEventsEpoll500(benchmark::State &state)
+{
+    EpollPeers(state, 500);
+}
+
+static void SocketEventsEpoll4000(benchmark::State &state)
+{
+    EpollPeers(state, 4000);
+}
+
+BENCHMARK(SocketEventsSelect100);
+BENCHMARK(SocketEventsSelect500);
+BENCHMARK(SocketEventsEpoll100);
+BENCHMARK(SocketEventsEpoll500);
+BENCHMARK(SocketEventsEpoll4000);
+
+#endif
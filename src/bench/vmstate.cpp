@@ -0,0 +1,76 @@
+#include "bench.h"
+#include "block/block.h"
+#include "script/interpreter.h"
+#include "utils/utilstrencodings.h"
+
+#include <cassert>
+
+static CBlock BuildVMStateBlock()
+{
+    CScript scriptPubKey = CScript() << ParseHex(DEFAULT_HASH_STATE_ROOT.GetHex().c_str())
+                                     << ParseHex(DEFAULT_HASH_UTXO_ROOT.GetHex().c_str()) << OP_VM_STATE;
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vout.resize(1);
+
+    CMutableTransaction coinbase2;
+    coinbase2.vin.resize(2);
+    coinbase2.vin[0].prevout.SetNull();
+    coinbase2.vin[1].prevout.SetNull();
+    coinbase2.vout.resize(1);
+    coinbase2.vout[0].scriptPubKey = scriptPubKey;
+    coinbase2.vout[0].nValue = 0;
+
+    CBlock block;
+    block.nVersion = ((uint32_t)1) << VERSIONBITS_SBTC_CONTRACT;
+    block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+    block.vtx.push_back(MakeTransactionRef(std::move(coinbase2)));
+    return block;
+}
+
+// The decoding GetVMState used to do: interpret the script, then HexStr/uint256S each push.
+static void VMStateDecodeLegacy(benchmark::State &state)
+{
+    const CBlock block = BuildVMStateBlock();
+    const CScript &script = block.vtx[1]->vout[0].scriptPubKey;
+    uint256 hashStateRoot, hashUTXORoot;
+    while (state.KeepRunning())
+    {
+        std::vector<std::vector<unsigned char> > stack;
+        EvalScript(stack, script, SCRIPT_EXEC_BYTE_CODE, BaseSignatureChecker(), SIGVERSION_BASE, nullptr);
+        stack.pop_back();
+        hashUTXORoot = uint256S(HexStr(stack.back()));
+        stack.pop_back();
+        hashStateRoot = uint256S(HexStr(stack.back()));
+    }
+    assert(hashStateRoot == DEFAULT_HASH_STATE_ROOT && hashUTXORoot == DEFAULT_HASH_UTXO_ROOT);
+}
+
+static void VMStateDecode(benchmark::State &state)
+{
+    const CBlock block = BuildVMStateBlock();
+    const CScript &script = block.vtx[1]->vout[0].scriptPubKey;
+    uint256 hashStateRoot, hashUTXORoot;
+    while (state.KeepRunning())
+    {
+        DecodeVMStateScript(script, hashStateRoot, hashUTXORoot);
+    }
+    assert(hashStateRoot == DEFAULT_HASH_STATE_ROOT && hashUTXORoot == DEFAULT_HASH_UTXO_ROOT);
+}
+
+static void VMStateCached(benchmark::State &state)
+{
+    const CBlock block = BuildVMStateBlock();
+    uint256 hashStateRoot, hashUTXORoot;
+    while (state.KeepRunning())
+    {
+        block.GetVMState(hashStateRoot, hashUTXORoot);
+    }
+    assert(hashStateRoot == DEFAULT_HASH_STATE_ROOT && hashUTXORoot == DEFAULT_HASH_UTXO_ROOT);
+}
+
+BENCHMARK(VMStateDecodeLegacy);
+BENCHMARK(VMStateDecode);
+BENCHMARK(VMStateCached);
@@ -11,6 +11,7 @@
 #include "utils/utilstrencodings.h"
 #include "sbtccore/streams.h"
 #include "sbtccore/clientversion.h"
+#include "config/consensus.h"
 
 SET_CPP_SCOPED_LOG_CATEGORY(CID_BLOCK_CHAIN);
 
@@ -103,6 +104,99 @@ bool ReadBlockFromDisk(CBlock &block, const CBlockIndex *pindex, const Consensus
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<unsigned char> &block, const CDiskBlockPos &pos,
+                          const CMessageHeader::MessageStartChars &messageStart)
+{
+    if (pos.nPos < CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int))
+    {
+        ELogFormat("ReadRawBlockFromDisk: no index header before %s", pos.ToString());
+        return false;
+    }
+
+    // Open history file at the index header, see WriteBlockToDisk
+    CDiskBlockPos hpos = pos;
+    hpos.nPos -= CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+    {
+        ELogFormat("ReadRawBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+        return false;
+    }
+
+    try
+    {
+        CMessageHeader::MessageStartChars blkStart;
+        unsigned int nSize;
+        filein >> FLATDATA(blkStart) >> nSize;
+        if (memcmp(blkStart, messageStart, CMessageHeader::MESSAGE_START_SIZE) || nSize < 80 ||
+            nSize > MAX_BLOCK_SERIALIZED_SIZE)
+        {
+            ELogFormat("ReadRawBlockFromDisk: Bad index header at %s", pos.ToString());
+            return false;
+        }
+        block.resize(nSize);
+        filein.read((char *)block.data(), nSize);
+    }
+    catch (const std::exception &e)
+    {
+        ELogFormat("Deserialize or I/O error - %s at %s", e.what(), pos.ToString());
+        return false;
+    }
+    return true;
+}
+
+CRawBlockCache::RawBlock CRawBlockCache::Get(const uint256 &hash)
+{
+    LOCK(cs);
+    auto it = mapBlocks.find(hash);
+    if (it == mapBlocks.end())
+        return nullptr;
+    lruBlocks.splice(lruBlocks.begin(), lruBlocks, it->second);
+    return it->second->second;
+}
+
+void CRawBlockCache::Insert(const uint256 &hash, const RawBlock &block)
+{
+    if (block->size() > nMaxBytes)
+        return;
+
+    LOCK(cs);
+    if (mapBlocks.count(hash))
+        return;
+    lruBlocks.emplace_front(hash, block);
+    mapBlocks.emplace(hash, lruBlocks.begin());
+    nBytes += block->size();
+    while (nBytes > nMaxBytes)
+    {
+        nBytes -= lruBlocks.back().second->size();
+        mapBlocks.erase(lruBlocks.back().first);
+        lruBlocks.pop_back();
+    }
+}
+
+VM_STATE_ROOT ReadVMStateFromIndex(const CBlockIndex *pindex, uint256 &hashStateRoot, uint256 &hashUTXORoot,
+                                   const Consensus::Params &consensusParams)
+{
+    if (pindex->HaveVMState())
+    {
+        if (pindex->hashStateRoot.IsNull() || pindex->hashUTXORoot.IsNull())
+            return RET_CONTRACT_UNENBALE;
+        hashStateRoot = pindex->hashStateRoot;
+        hashUTXORoot = pindex->hashUTXORoot;
+        return RET_VM_STATE_OK;
+    }
+
+    // connected by a version that did not store the roots in the index
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, consensusParams))
+    {
+        ELogFormat("ReadVMStateFromIndex: ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight,
+                   pindex->GetBlockHash().ToString());
+        return RET_VM_STATE_ERR;
+    }
+    return block.GetVMState(hashStateRoot, hashUTXORoot);
+}
+
 bool UndoReadFromDisk(CBlockUndo &blockundo, const CDiskBlockPos &pos, const uint256 &hashBlock)
 {
     // Open history file to read
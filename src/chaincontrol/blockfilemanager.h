@@ -8,6 +8,10 @@
 #ifndef __SBTC_BLOCKFILEMANAGER_H__
 #define __SBTC_BLOCKFILEMANAGER_H__
 
+#include <list>
+#include <memory>
+#include <map>
+#include <vector>
 #include "framework/sync.h"
 #include "chain.h"
 #include "utils/fs.h"
@@ -30,6 +34,42 @@ bool ReadBlockFromDisk(CBlock &block, const CDiskBlockPos &pos, const Consensus:
 
 bool ReadBlockFromDisk(CBlock &block, const CBlockIndex *pindex, const Consensus::Params &consensusParams);
 
+/**
+ * Reads the bytes of a block exactly as stored in its blk file, checking the index header written before them.
+ * Blocks are stored serialized with witness, the same bytes the network serialization gives.
+ */
+bool ReadRawBlockFromDisk(std::vector<unsigned char> &block, const CDiskBlockPos &pos,
+                          const CMessageHeader::MessageStartChars &messageStart);
+
+//! Default budget of the raw block cache used to serve historical blocks
+static const size_t DEFAULT_RAW_BLOCK_CACHE_SIZE = 32 * 1024 * 1024;
+
+/** LRU of raw blocks read from disk, so peers downloading the same blocks share one read */
+class CRawBlockCache
+{
+public:
+    typedef std::shared_ptr<const std::vector<unsigned char>> RawBlock;
+
+    explicit CRawBlockCache(size_t nMaxBytesIn) : nMaxBytes(nMaxBytesIn), nBytes(0)
+    {
+    }
+
+    RawBlock Get(const uint256 &hash);
+
+    void Insert(const uint256 &hash, const RawBlock &block);
+
+private:
+    CCriticalSection cs;
+    size_t nMaxBytes;
+    size_t nBytes;
+    std::list<std::pair<uint256, RawBlock>> lruBlocks;
+    std::map<uint256, std::list<std::pair<uint256, RawBlock>>::iterator> mapBlocks;
+};
+
+/** Contract state roots of a block, taken from the block index if stored there and read from disk otherwise */
+VM_STATE_ROOT ReadVMStateFromIndex(const CBlockIndex *pindex, uint256 &hashStateRoot, uint256 &hashUTXORoot,
+                                   const Consensus::Params &consensusParams);
+
 bool UndoReadFromDisk(CBlockUndo &blockundo, const CDiskBlockPos &pos, const uint256 &hashBlock);
 
 bool WriteBlockToDisk(const CBlock &block, CDiskBlockPos &pos, const CMessageHeader::MessageStartChars &messageStart);
@@ -0,0 +1,262 @@
+///////////////////////////////////////////////////////////
+//  blockimport.cpp
+//  Implementation of the Class CBlockImportPipeline
+///////////////////////////////////////////////////////////
+#include "utils/util.h"
+#include "blockimport.h"
+#include "sbtccore/streams.h"
+#include "sbtccore/clientversion.h"
+#include "sbtccore/block/validation.h"
+#include "config/consensus.h"
+
+SET_CPP_SCOPED_LOG_CATEGORY(CID_BLOCK_CHAIN);
+
+CBlockImportPipeline::CBlockImportPipeline(FILE *fileIn, const CMessageHeader::MessageStartChars &messageStartIn,
+                                           int nDecodeThreads, std::function<void(const CBlock &)> fnCheckIn)
+        : messageStart(messageStartIn), fnCheck(std::move(fnCheckIn)), nFileStart(0), nFileSize(0), nBytesRead(0),
+          fStop(false), fReadDone(false), fRestart(false), nRestartPos(0), nEpoch(0), nReadSeq(0), nNextSeq(0),
+          nInFlightBytes(0)
+{
+    long nStart = ftell(fileIn);
+    if (nStart >= 0 && fseek(fileIn, 0, SEEK_END) == 0)
+    {
+        long nEnd = ftell(fileIn);
+        if (nEnd > nStart)
+            nFileSize = nEnd - nStart;
+        fseek(fileIn, nStart, SEEK_SET);
+        nFileStart = nStart;
+    }
+
+    readThread = std::thread(&CBlockImportPipeline::ThreadRead, this, fileIn);
+    for (int i = 0; i < std::max(nDecodeThreads, 1); i++)
+    {
+        decodeThreads.emplace_back(&CBlockImportPipeline::ThreadDecode, this);
+    }
+}
+
+CBlockImportPipeline::~CBlockImportPipeline()
+{
+    Stop();
+    readThread.join();
+    for (std::thread &thread : decodeThreads)
+    {
+        thread.join();
+    }
+}
+
+void CBlockImportPipeline::Stop()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    fStop = true;
+    condRead.notify_all();
+    condDecode.notify_all();
+    condNext.notify_all();
+}
+
+void CBlockImportPipeline::Restart(uint64_t nPos)
+{
+    // the jobs being decoded right now belong to the former epoch, the decoders drop them
+    nEpoch++;
+    jobs.clear();
+    decoded.clear();
+    nReadSeq = nNextSeq;
+    nInFlightBytes = 0;
+    fReadDone = false;
+    fRestart = true;
+    nRestartPos = nPos;
+    condRead.notify_all();
+}
+
+std::string CBlockImportPipeline::GetError()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return strError;
+}
+
+bool CBlockImportPipeline::Next(Item &item)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        auto it = decoded.find(nNextSeq);
+        if (it != decoded.end())
+        {
+            Decoded result = std::move(it->second);
+            nInFlightBytes -= result.nSize;
+            decoded.erase(it);
+            nNextSeq++;
+            condRead.notify_one();
+
+            if (!result.item.pblock)
+                ELogFormat("Deserialize or I/O error - %s", result.strError);
+            // a torn record, or a block shorter than its record: what was read after it is not aligned
+            if (result.nNext != result.item.nPos + result.nSize && strError.empty())
+                Restart(result.nNext);
+            if (!result.item.pblock)
+                continue;
+
+            item = std::move(result.item);
+            return true;
+        }
+        if (fStop || (fReadDone && nNextSeq == nReadSeq))
+        {
+            return false;
+        }
+        condNext.wait(lock);
+    }
+}
+
+void CBlockImportPipeline::ThreadRead(FILE *fileIn)
+{
+    try
+    {
+        uint64_t nStartPos = 0;
+        while (true)
+        {
+            // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
+            CBufferedFile blkdat(fileIn, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8, SER_DISK,
+                                 CLIENT_VERSION);
+            // the positions of blkdat count from nStartPos
+            uint64_t nRewind = 0;
+            while (!blkdat.eof())
+            {
+                blkdat.SetPos(nRewind);
+                nRewind++; // start one byte further next time, in case of failure
+                blkdat.SetLimit(); // remove former limit
+                unsigned int nSize = 0;
+                try
+                {
+                    // locate a header
+                    unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
+                    blkdat.FindByte(messageStart[0]);
+                    nRewind = blkdat.GetPos() + 1;
+                    blkdat >> FLATDATA(buf);
+                    if (memcmp(buf, messageStart, CMessageHeader::MESSAGE_START_SIZE))
+                        continue;
+                    // read size
+                    blkdat >> nSize;
+                    if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                        continue;
+                } catch (const std::exception &)
+                {
+                    // no valid block header found; don't complain
+                    break;
+                }
+
+                Job job;
+                try
+                {
+                    // read the record, it is deserialized by the decode threads
+                    job.nPos = nStartPos + blkdat.GetPos();
+                    job.nResync = nStartPos + nRewind;
+                    blkdat.SetLimit(blkdat.GetPos() + nSize);
+                    // the last record can claim more bytes than the file has, its block may still be whole
+                    if (nFileSize > 0 && job.nPos + nSize > nFileSize && job.nPos < nFileSize)
+                        nSize = nFileSize - job.nPos;
+                    job.data.resize(nSize);
+                    blkdat.read(&job.data[0], nSize);
+                    nRewind = blkdat.GetPos();
+                    nBytesRead = nStartPos + nRewind;
+                } catch (const std::exception &e)
+                {
+                    // a truncated record, scan again for a header from the byte after this one
+                    ELogFormat("Deserialize or I/O error - %s", e.what());
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                // always let one block through, whatever its size
+                while (!fStop && !fRestart && nInFlightBytes > 0 && nInFlightBytes + nSize > MAX_IMPORT_INFLIGHT_BYTES)
+                {
+                    condRead.wait(lock);
+                }
+                if (fStop || fRestart)
+                    break;
+                job.nSeq = nReadSeq++;
+                job.nEpoch = nEpoch;
+                nInFlightBytes += nSize;
+                jobs.emplace_back(std::move(job));
+                condDecode.notify_one();
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!fStop && !fRestart)
+            {
+                // the whole file is read, but Next() can still find a torn record and restart the scan
+                fReadDone = true;
+                condDecode.notify_all();
+                condNext.notify_all();
+                while (!fStop && !fRestart)
+                {
+                    condRead.wait(lock);
+                }
+            }
+            if (fStop)
+                break;
+            fRestart = false;
+            nStartPos = nRestartPos;
+            fileIn = blkdat.release();
+            if (fseek(fileIn, nFileStart + nStartPos, SEEK_SET))
+            {
+                fclose(fileIn);
+                throw std::runtime_error("CBlockImportPipeline::ThreadRead: fseek failed");
+            }
+        }
+    } catch (const std::runtime_error &e)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        strError = e.what();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    fReadDone = true;
+    condDecode.notify_all();
+    condNext.notify_all();
+}
+
+void CBlockImportPipeline::ThreadDecode()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // the reader can still be restarted once it is done, so wait for jobs until the pipeline stops
+            while (!fStop && jobs.empty())
+            {
+                condDecode.wait(lock);
+            }
+            if (fStop)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        Decoded result;
+        result.item.nPos = job.nPos;
+        result.nSize = job.data.size();
+        try
+        {
+            result.item.pblock = std::make_shared<CBlock>();
+            job.data >> *result.item.pblock;
+            result.nNext = job.nPos + result.nSize - job.data.size();
+        } catch (const std::exception &e)
+        {
+            result.item.pblock.reset();
+            result.nNext = job.nResync;
+            result.strError = e.what();
+        }
+        if (result.item.pblock)
+        {
+            result.item.hash = result.item.pblock->GetHash();
+            fnCheck(*result.item.pblock);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (job.nEpoch != nEpoch)
+            continue;
+        decoded.emplace(job.nSeq, std::move(result));
+        if (job.nSeq == nNextSeq)
+            condNext.notify_one();
+    }
+}
@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////
+//  blockimport.h
+//  Implementation of the Class CBlockImportPipeline
+///////////////////////////////////////////////////////////
+
+#ifndef __SBTC_BLOCKIMPORT_H__
+#define __SBTC_BLOCKIMPORT_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "p2p/protocol.h"
+#include "sbtccore/block/block.h"
+#include "sbtccore/clientversion.h"
+#include "sbtccore/streams.h"
+
+//! Max number of threads decoding the blocks of an imported file
+static const int MAX_IMPORT_DECODE_THREADS = 4;
+//! Serialized blocks read ahead of the block being accepted
+static const uint64_t MAX_IMPORT_INFLIGHT_BYTES = 64 * 1024 * 1024;
+
+/**
+ * Reads the blocks of a blk*.dat or bootstrap file in three stages: a reader thread scans the file
+ * for records and reads their bytes, a pool of threads deserializes them, computes their hash and
+ * runs the context-free checks given as fnCheck, and Next() hands them back in file order.
+ * A record that fails to deserialize is skipped by Next(), which restarts the reader on the byte after
+ * its message start and drops what was read past it, so the blocks after a torn write are still found.
+ */
+class CBlockImportPipeline
+{
+public:
+    struct Item
+    {
+        uint64_t nPos;                  //!< file position of the serialized block
+        uint256 hash;
+        std::shared_ptr<CBlock> pblock;
+    };
+
+    /** Takes over fileIn, which is closed once the reader is done with it */
+    CBlockImportPipeline(FILE *fileIn, const CMessageHeader::MessageStartChars &messageStart, int nDecodeThreads,
+                         std::function<void(const CBlock &)> fnCheck);
+
+    ~CBlockImportPipeline();
+
+    /** Waits for the next block of the file. Returns false once the whole file has been handed out */
+    bool Next(Item &item);
+
+    uint64_t GetFileSize() const
+    {
+        return nFileSize;
+    }
+
+    uint64_t GetBytesRead() const
+    {
+        return nBytesRead;
+    }
+
+    /** Set if reading the file failed with a system error */
+    std::string GetError();
+
+private:
+    struct Job
+    {
+        uint64_t nSeq;
+        uint64_t nEpoch;
+        uint64_t nPos;
+        uint64_t nResync;               //!< where the scan goes on if the record fails to deserialize
+        CDataStream data{SER_DISK, CLIENT_VERSION};
+    };
+
+    struct Decoded
+    {
+        Item item;                      //!< pblock is null if the record failed to deserialize
+        unsigned int nSize;
+        uint64_t nNext;                 //!< where the scan goes on after this record
+        std::string strError;
+    };
+
+    void ThreadRead(FILE *fileIn);
+
+    void ThreadDecode();
+
+    void Stop();
+
+    /** Drops the records read past the one just handed out and rescans the file from nPos */
+    void Restart(uint64_t nPos);
+
+    const CMessageHeader::MessageStartChars &messageStart;
+    std::function<void(const CBlock &)> fnCheck;
+    long nFileStart;
+    uint64_t nFileSize;
+    std::atomic<uint64_t> nBytesRead;
+
+    std::mutex mutex;
+    std::condition_variable condRead;    //!< the reader waits for the in-flight bytes to drop
+    std::condition_variable condDecode;  //!< the decoders wait for jobs
+    std::condition_variable condNext;    //!< Next() waits for the next block
+    bool fStop;
+    bool fReadDone;
+    bool fRestart;                       //!< the reader has to rescan from nRestartPos
+    uint64_t nRestartPos;
+    uint64_t nEpoch;                     //!< counts the restarts, the jobs of an earlier one are dropped
+    uint64_t nReadSeq;
+    uint64_t nNextSeq;
+    uint64_t nInFlightBytes;
+    std::string strError;
+    std::deque<Job> jobs;
+    std::map<uint64_t, Decoded> decoded;
+
+    std::thread readThread;
+    std::vector<std::thread> decodeThreads;
+};
+
+#endif //__SBTC_BLOCKIMPORT_H__
@@ -324,6 +324,7 @@ int CBlockIndexManager::LoadLogEvents()
     if (!Args().GetArg<bool>("-logevents", DEFAULT_LOGEVENTS))
     {
         pBlcokTreee->WipeHeightIndex();
+        pBlcokTreee->WipeLogIndex();
         bLogEvents = false;
         pBlcokTreee->WriteFlag("logevents", bLogEvents);
     } else
@@ -340,6 +341,7 @@ void CBlockIndexManager::UnLoadBlockIndex()
     LOCK(cs_main);
     setBlockIndexCandidates.clear();
     cChainActive.SetTip(nullptr);
+    PublishChainView();
     pIndexBestInvalid = nullptr;
     pIndexBestHeader = nullptr;
     mBlocksUnlinked.clear();
@@ -504,6 +506,16 @@ CChain &CBlockIndexManager::GetChain()
     return cChainActive;
 }
 
+void CBlockIndexManager::PublishChainView()
+{
+    cChainViewPublisher.Publish(cChainActive);
+}
+
+std::shared_ptr<const CChainView> CBlockIndexManager::GetChainView() const
+{
+    return cChainViewPublisher.GetView();
+}
+
 bool CBlockIndexManager::Flush()
 {
     std::vector<std::pair<int, const CBlockFileInfo *> > vFiles;
@@ -940,11 +952,13 @@ void CBlockIndexManager::RewindBlockIndex(const Consensus::Params &params)
             pIndexIter->nStatus = std::min<unsigned int>(pIndexIter->nStatus & BLOCK_VALID_MASK, BLOCK_VALID_TREE) |
                                   (pIndexIter->nStatus & ~BLOCK_VALID_MASK);
             // Remove have-data flags.
-            pIndexIter->nStatus &= ~(BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO);
+            pIndexIter->nStatus &= ~(BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO | BLOCK_HAVE_VM_STATE);
             // Remove storage location.
             pIndexIter->nFile = 0;
             pIndexIter->nDataPos = 0;
             pIndexIter->nUndoPos = 0;
+            pIndexIter->hashStateRoot.SetNull();
+            pIndexIter->hashUTXORoot.SetNull();
             // Remove various other things
             pIndexIter->nTx = 0;
             pIndexIter->nChainTx = 0;
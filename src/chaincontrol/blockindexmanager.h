@@ -114,6 +114,11 @@ public:
 
     CChain &GetChain();
 
+    /** Publishes the active chain as it is now to the readers of GetChainView. Requires cs_main */
+    void PublishChainView();
+
+    std::shared_ptr<const CChainView> GetChainView() const;
+
     bool Flush();
 
     int GetLastBlockFile();
@@ -203,6 +208,7 @@ private:
     CBlockIndex *pIndexBestForkBase = nullptr;
 
     CChain cChainActive;
+    CChainViewPublisher cChainViewPublisher;
 
     bool fCheckBlockIndex = false;
 
@@ -77,6 +77,93 @@ CBlockIndex *CChain::FindEarliestAtLeast(int64_t nTime) const
     return (lower == vChain.end() ? nullptr : *lower);
 }
 
+/**
+ * CChainView implementation
+ */
+CBlockLocator CChainView::GetLocator(const CBlockIndex *pindex) const
+{
+    int nStep = 1;
+    std::vector<uint256> vHave;
+    vHave.reserve(32);
+
+    if (!pindex)
+        pindex = Tip();
+    while (pindex)
+    {
+        vHave.push_back(pindex->GetBlockHash());
+        if (pindex->nHeight == 0)
+            break;
+        int nHeightStep = std::max(pindex->nHeight - nStep, 0);
+        if (Contains(pindex))
+            pindex = (*this)[nHeightStep];
+        else
+            pindex = pindex->GetAncestor(nHeightStep);
+        if (vHave.size() > 10)
+            nStep *= 2;
+    }
+
+    return CBlockLocator(vHave);
+}
+
+const CBlockIndex *CChainView::FindFork(const CBlockIndex *pindex) const
+{
+    if (pindex == nullptr)
+    {
+        return nullptr;
+    }
+    if (pindex->nHeight > Height())
+        pindex = pindex->GetAncestor(Height());
+    while (pindex && !Contains(pindex))
+        pindex = pindex->pprev;
+    return pindex;
+}
+
+void CChainViewPublisher::Publish(const CChain &chain)
+{
+    std::shared_ptr<const CChainView> pOld = pView;
+    int nHeight = chain.Height();
+    int nFork = std::min(pOld->Height(), nHeight);
+    while (nFork >= 0 && (*pOld)[nFork] != chain[nFork])
+        nFork--;
+
+    // the directory is copied once something changes in it
+    static const CChainView::Directory emptyDirectory;
+    const CChainView::Directory *pDirectory = pOld->pDirectory ? pOld->pDirectory.get() : &emptyDirectory;
+    std::shared_ptr<CChainView::Directory> pNewDirectory;
+    for (int h = nFork + 1; h <= nHeight; h++)
+    {
+        size_t nChunk = h / CChainView::CHUNK_SIZE;
+        int nEntry = h % CChainView::CHUNK_SIZE;
+        if (nChunk >= pDirectory->size() || nEntry < (*pDirectory)[nChunk]->nVisible)
+        {
+            if (!pNewDirectory)
+            {
+                pNewDirectory = std::make_shared<CChainView::Directory>(*pDirectory);
+                pDirectory = pNewDirectory.get();
+            }
+            if (nChunk >= pNewDirectory->size())
+            {
+                pNewDirectory->push_back(std::make_shared<CChainView::Chunk>());
+            } else
+            {
+                std::shared_ptr<CChainView::Chunk> pChunk = std::make_shared<CChainView::Chunk>(
+                        *(*pNewDirectory)[nChunk]);
+                pChunk->nVisible = 0;
+                (*pNewDirectory)[nChunk] = pChunk;
+            }
+        }
+        CChainView::Chunk &chunk = *(*pDirectory)[nChunk];
+        chunk.vIndex[nEntry] = chain[h];
+        chunk.nVisible = std::max(chunk.nVisible, nEntry + 1);
+    }
+
+    std::shared_ptr<CChainView> pNew = std::make_shared<CChainView>();
+    pNew->pDirectory = pNewDirectory ? pNewDirectory : pOld->pDirectory;
+    pNew->nHeight = nHeight;
+    pNew->nVersion = pOld->nVersion + 1;
+    std::atomic_store(&pView, std::shared_ptr<const CChainView>(pNew));
+}
+
 /** Turn the lowest '1' bit in the binary representation of a number into a '0'. */
 int static inline InvertLowestOne(int n)
 {
@@ -13,6 +13,7 @@
 #include "tinyformat.h"
 #include "uint256.h"
 
+#include <memory>
 #include <vector>
 
 /**
@@ -185,6 +186,8 @@ enum BlockStatus : uint32_t
     BLOCK_FAILED_MASK = BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
     BLOCK_OPT_WITNESS = 128, //!< block data in blk*.data was received with a witness-enforcing client
+
+    BLOCK_HAVE_VM_STATE = 256, //!< hashStateRoot/hashUTXORoot of the connected block are stored in the index
 };
 
 /** The block chain is a tree shaped structure starting with the
@@ -243,6 +246,11 @@ public:
     //! (memory only) Maximum nTime in the chain upto and including this block.
     unsigned int nTimeMax;
 
+    //! Contract state roots committed by this block's coinbase. Only valid if nStatus & BLOCK_HAVE_VM_STATE,
+    //! null if the contract is not enabled at this block.
+    uint256 hashStateRoot;
+    uint256 hashUTXORoot;
+
     void SetNull()
     {
         phashBlock = nullptr;
@@ -258,6 +266,8 @@ public:
         nStatus = 0;
         nSequenceId = 0;
         nTimeMax = 0;
+        hashStateRoot = uint256();
+        hashUTXORoot = uint256();
 
         nVersion = 0;
         hashMerkleRoot = uint256();
@@ -322,6 +332,11 @@ public:
         return (nVersion & (((uint32_t)1) << VERSIONBITS_SBTC_CONTRACT));
     }
 
+    bool HaveVMState() const
+    {
+        return (nStatus & BLOCK_HAVE_VM_STATE) != 0;
+    }
+
 
     uint256 GetBlockHash() const
     {
@@ -450,6 +465,13 @@ public:
         READWRITE(nTime);
         READWRITE(nBits);
         READWRITE(nNonce);
+
+        // sbtc-vm, appended last so that older versions still read the entry
+        if (nStatus & BLOCK_HAVE_VM_STATE)
+        {
+            READWRITE(hashStateRoot);
+            READWRITE(hashUTXORoot);
+        }
     }
 
     uint256 GetBlockHash() const
@@ -544,4 +566,102 @@ public:
     CBlockIndex *FindEarliestAtLeast(int64_t nTime) const;
 };
 
+/**
+ * Immutable view of a chain at one tip, published by CChainViewPublisher. Holding a view needs no lock,
+ * and taking one copies no block index pointers: the entries live in fixed-size chunks that views share.
+ */
+class CChainView
+{
+public:
+    static const int CHUNK_SIZE = 4096;
+
+    CChainView() : nHeight(-1), nVersion(0)
+    {
+    }
+
+    CBlockIndex *Genesis() const
+    {
+        return (*this)[0];
+    }
+
+    CBlockIndex *Tip() const
+    {
+        return (*this)[nHeight];
+    }
+
+    CBlockIndex *operator[](int nHeightIn) const
+    {
+        if (nHeightIn < 0 || nHeightIn > nHeight)
+            return nullptr;
+        return (*pDirectory)[nHeightIn / CHUNK_SIZE]->vIndex[nHeightIn % CHUNK_SIZE];
+    }
+
+    bool Contains(const CBlockIndex *pindex) const
+    {
+        return (*this)[pindex->nHeight] == pindex;
+    }
+
+    CBlockIndex *Next(const CBlockIndex *pindex) const
+    {
+        if (Contains(pindex))
+            return (*this)[pindex->nHeight + 1];
+        else
+            return nullptr;
+    }
+
+    int Height() const
+    {
+        return nHeight;
+    }
+
+    /** Incremented by every publication, two views with the same version are the same chain */
+    uint64_t GetVersion() const
+    {
+        return nVersion;
+    }
+
+    CBlockLocator GetLocator(const CBlockIndex *pindex = nullptr) const;
+
+    const CBlockIndex *FindFork(const CBlockIndex *pindex) const;
+
+private:
+    friend class CChainViewPublisher;
+
+    struct Chunk
+    {
+        CBlockIndex *vIndex[CHUNK_SIZE];
+        //! entries below this one may be read through a published view, and are never written again
+        int nVisible = 0;
+    };
+
+    typedef std::vector<std::shared_ptr<Chunk>> Directory;
+
+    std::shared_ptr<const Directory> pDirectory;
+    int nHeight;
+    uint64_t nVersion;
+};
+
+/**
+ * Publishes the views of one chain. The entries that published views can read are copied on
+ * write: extending the tip writes in place, a reorganization copies the chunks it rewrites.
+ */
+class CChainViewPublisher
+{
+public:
+    CChainViewPublisher() : pView(std::make_shared<CChainView>())
+    {
+    }
+
+    /** Publishes the current state of chain. Calls must be serialized by the lock guarding chain */
+    void Publish(const CChain &chain);
+
+    std::shared_ptr<const CChainView> GetView() const
+    {
+        return std::atomic_load(&pView);
+    }
+
+private:
+    std::shared_ptr<const CChainView> pView;
+};
+
 #endif // BITCOIN_CHAIN_H
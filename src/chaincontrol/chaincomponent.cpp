@@ -180,7 +180,7 @@ bool CChainComponent::ComponentInitialize()
             }
 
 
-            bReIndex |= cIndexManager.IsReIndexing();
+            bReIndex = bReIndex || cIndexManager.IsReIndexing();
             if (!bReIndex && cIndexManager.NeedInitGenesisBlock(Params()))
             {
                 if (!LoadGenesisBlock(Params()))
@@ -341,9 +341,18 @@ bool CChainComponent::ComponentStartup()
     NLogStream() << "startup chain component";
     bRequestShutdown = false;
 
-    ThreadImport();
-    //    std::thread t(&CChainComponent::ThreadImport, this);
-    //    t.detach();
+    // reindexing and -loadblock imports run in the background, the node is usable once the genesis block is connected
+    bImportRunning = true;
+    threadGroup.create_thread(boost::bind(&CChainComponent::ThreadImport, this));
+    while (bImportRunning && !GetApp()->ShutdownRequested())
+    {
+        {
+            LOCK(cs_main);
+            if (cIndexManager.GetChain().Tip() != nullptr)
+                break;
+        }
+        MilliSleep(10);
+    }
     return true;
 }
 
@@ -383,6 +392,12 @@ bool CChainComponent::IsReindexing() const
     return bReIndex;
 }
 
+CImportProgress CChainComponent::GetImportProgress()
+{
+    LOCK(cs_import);
+    return importProgress;
+}
+
 bool CChainComponent::IsTxIndex() const
 {
     return cIndexManager.IsTxIndex();
@@ -466,6 +481,11 @@ CChain &CChainComponent::GetActiveChain()
     return cIndexManager.GetChain();
 }
 
+std::shared_ptr<const CChainView> CChainComponent::GetActiveChainView()
+{
+    return cIndexManager.GetChainView();
+}
+
 std::set<const CBlockIndex *, CompareBlocksByHeight> CChainComponent::GetTips()
 {
     return cIndexManager.GetTips();
@@ -479,6 +499,7 @@ CBlockIndex *CChainComponent::Tip()
 void CChainComponent::SetTip(CBlockIndex *pIndexTip)
 {
     cIndexManager.GetChain().SetTip(pIndexTip);
+    cIndexManager.PublishChainView();
 }
 
 bool CChainComponent::ReplayBlocks()
@@ -616,6 +637,15 @@ bool CChainComponent::FlushStateToDisk(CValidationState &state, FlushStateMode m
     // Combine all conditions that result in a full cache flush.
     bool bDoFullFlush = (mode == FLUSH_STATE_ALWAYS) || bCacheLarge || bCacheCritical || bPeriodicFlush;
 
+    // The nodes of the flushed best block are never pruned (see CStatePruner), so the coins on disk always
+    // find their contract state and writing trie nodes ahead of the coins is safe: only the contract state
+    // is written when it alone is over its budget.
+    GET_CONTRACT_INTERFACE(ifContractObj);
+    if (!bDoFullFlush && mode != FLUSH_STATE_NONE)
+    {
+        ifContractObj->FlushState(false);
+    }
+
     // Write blocks and block index to disk.
     if (bDoFullFlush || bPeriodicWrite)
     {
@@ -656,6 +686,10 @@ bool CChainComponent::FlushStateToDisk(CValidationState &state, FlushStateMode m
             return state.Error("out of disk space");
         }
 
+        // the coins record the tip whose state root the contract state is reopened at, so its trie
+        // nodes have to be on disk first
+        ifContractObj->FlushState(true);
+
         // view flush
         if (!cViewManager.Flush())
         {
@@ -722,6 +756,12 @@ void CChainComponent::UpdateTip(CBlockIndex *pindexNew, const CChainParams &chai
     CChain &chainActive = cIndexManager.GetChain();
 
     chainActive.SetTip(pindexNew);
+    cIndexManager.PublishChainView();
+
+    // the mempool and the miner read the DGP parameters of the next block, during the initial download
+    // nothing asks for them until the next block is connected
+    GET_CONTRACT_INTERFACE(ifContractObj);
+    ifContractObj->UpdateDGPCache(pindexNew, !IsInitialBlockDownload());
 
     GET_TXMEMPOOL_INTERFACE(ifMemPoolObj);
     // New best block
@@ -1307,6 +1347,7 @@ CChainComponent::ConnectBlock(const CBlock &block, CValidationState &state, CBlo
 
     ///////////////////////////////////////////////////////// // sbtc-vm
     std::map<dev::Address, std::pair<CHeightTxIndexKey, std::vector<uint256>>> heightIndexes;
+    std::vector<std::pair<dev::h160, CContractRegistryEntry>> createdContracts;
 //    CAmount gasRefunds = 0;
 
     uint64_t nValueOut = 0;
@@ -1370,10 +1411,12 @@ CChainComponent::ConnectBlock(const CBlock &block, CValidationState &state, CBlo
 
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
+            // Script checks only depend on the tx, its spent outputs and txdata, so OP_SPEND and
+            // create/call txs are deferred to the check queue as well. The EVM execution below
+            // still runs in block order on this thread; a failing signature is caught by
+            // control.Wait() and the caller restores the contract state roots.
             if (!tx.CheckInputs(state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i],
-                    //                                nScriptCheckThreads ? &vChecks : nullptr))
-                                (hasOpSpend || tx.HasCreateOrCall()) ? nullptr : (nScriptCheckThreads ? &vChecks
-                                                                                                      : nullptr)))
+                                nScriptCheckThreads ? &vChecks : nullptr))
             {
                 return rLogError("CheckInputs on %s failed with %s",
                                  tx.GetHash().ToString(), FormatStateMessage(state));
@@ -1436,6 +1479,13 @@ CChainComponent::ConnectBlock(const CBlock &block, CValidationState &state, CBlo
             {
                 checkBlock.vtx.push_back(MakeTransactionRef(std::move(t)));
             }
+            for (const auto &e : bcer.createdContracts)
+            {
+                CContractRegistryEntry entry;
+                entry.hashCode = e.second;
+                entry.txid = tx.GetHash();
+                createdContracts.push_back(std::make_pair(e.first, entry));
+            }
             if(nFeesContract < gasRefunds)
             {
                 return state.DoS(100, false, REJECT_INVALID, "contract tx nFee is error");
@@ -1585,16 +1635,13 @@ CChainComponent::ConnectBlock(const CBlock &block, CValidationState &state, CBlo
 
         uint256 hashStateRoot;
         uint256 hashUTXORoot;
-        CBlock prevblock;
-        if (ReadBlockFromDisk(prevblock, pindex->pprev, Params().GetConsensus())) {
-            if(prevblock.GetVMState(hashStateRoot, hashUTXORoot) == RET_VM_STATE_ERR)
-            {
-                ILogFormat("GetVMState err");
-                return false;
-            }
+        if (ReadVMStateFromIndex(pindex->pprev, hashStateRoot, hashUTXORoot, chainparams.GetConsensus()) ==
+            RET_VM_STATE_ERR)
+        {
+            ILogFormat("GetVMState err");
+            return false;
         }
 
-//        if (pindex->pprev->hashStateRoot != uint256() && pindex->pprev->hashUTXORoot != uint256())
         if (hashStateRoot != uint256() && hashUTXORoot != uint256()) {
             prevHashStateRoot = hashStateRoot;
             prevHashUTXORoot = hashUTXORoot;
@@ -1627,13 +1674,52 @@ CChainComponent::ConnectBlock(const CBlock &block, CValidationState &state, CBlo
         cIndexManager.SetDirtyIndex(pindex);
     }
     //sbtc-vm
+    if (!pindex->HaveVMState())
+    {
+        pindex->hashStateRoot = blockhashStateRoot;
+        pindex->hashUTXORoot = blockhashUTXORoot;
+        pindex->nStatus |= BLOCK_HAVE_VM_STATE;
+        cIndexManager.SetDirtyIndex(pindex);
+    }
     if (IsLogEvents())
     {
+        CBlockLogIndex logIndex;
         for (const auto &e: heightIndexes)
         {
             if (!GetBlockTreeDB()->WriteHeightIndex(e.second.first, e.second.second))
                 return AbortNode(state, "Failed to write height index");
+
+            bool fHaveLogs = false;
+            for (const uint256 &hashTx : e.second.second)
+            {
+                for (const TransactionReceiptInfo &receipt : ifContractObj->GetResult(hashTx))
+                {
+                    for (const dev::eth::LogEntry &log : receipt.logs)
+                    {
+                        fHaveLogs = true;
+                        logIndex.bloom |= log.bloom();
+                        if (log.topics.empty())
+                            continue;
+                        std::vector<uint256> &hashes = logIndex.topics[std::make_pair(e.first, log.topics[0])];
+                        if (hashes.empty() || hashes.back() != hashTx)
+                            hashes.push_back(hashTx);
+                    }
+                }
+            }
+            if (fHaveLogs)
+                logIndex.bloom.shiftBloom<3>(dev::sha3(e.first.ref()));
         }
+        if (logIndex.bloom)
+        {
+            if (!GetBlockTreeDB()->WriteLogIndex(pindex->nHeight, logIndex))
+                return AbortNode(state, "Failed to write log index");
+        }
+    }
+
+    if (!createdContracts.empty())
+    {
+        if (!GetBlockTreeDB()->WriteContractRegistry(pindex->nHeight, createdContracts))
+            return AbortNode(state, "Failed to write contract registry");
     }
 
     if (IsTxIndex())
@@ -2218,6 +2304,41 @@ void CChainComponent::ThreadImport()
 {
     RenameThread("bitcoin-loadblk");
 
+    struct CImportingNow
+    {
+        CChainComponent &chain;
+
+        explicit CImportingNow(CChainComponent &chainIn) : chain(chainIn)
+        {
+            fImporting = true;
+        }
+
+        ~CImportingNow()
+        {
+            fImporting = false;
+            chain.bImportRunning = false;
+            LOCK(chain.cs_import);
+            chain.importProgress.fActive = false;
+        }
+    } importing(*this);
+
+    // hardcoded $DATADIR/bootstrap.dat
+    fs::path pathBootstrap = GetDataDir() / "bootstrap.dat";
+    std::vector<std::string> vLoadBlocks = Args().GetArgs("-loadblock");
+    {
+        int nBlockFiles = 0;
+        while (bReIndex && fs::exists(GetBlockPosFilename(CDiskBlockPos(nBlockFiles, 0), "blk")))
+            nBlockFiles++;
+
+        // one progress for the whole import, it stays until the best chain is activated at the end
+        LOCK(cs_import);
+        importProgress = CImportProgress();
+        importProgress.fActive = true;
+        importProgress.fReindex = bReIndex;
+        importProgress.nFiles = nBlockFiles + (int)vLoadBlocks.size() + (fs::exists(pathBootstrap) ? 1 : 0);
+        importProgress.nStartTime = GetTime();
+    }
+
     if (bReIndex)
     {
         int iFile = 0;
@@ -2230,6 +2351,11 @@ void CChainComponent::ThreadImport()
             if (!file)
                 break; // This error is logged in OpenBlockFile
             NLogFormat("Reindexing block file blk%05u.dat...", (unsigned int)iFile);
+            {
+                LOCK(cs_import);
+                importProgress.strFile = GetBlockPosFilename(pos, "blk").string();
+                importProgress.nFile++;
+            }
             LoadExternalBlockFile(Params(), file, &pos);
             iFile++;
         }
@@ -2246,8 +2372,6 @@ void CChainComponent::ThreadImport()
         }
     }
 
-    // hardcoded $DATADIR/bootstrap.dat
-    fs::path pathBootstrap = GetDataDir() / "bootstrap.dat";
     if (fs::exists(pathBootstrap))
     {
         FILE *file = fsbridge::fopen(pathBootstrap, "rb");
@@ -2255,6 +2379,11 @@ void CChainComponent::ThreadImport()
         {
             fs::path pathBootstrapOld = GetDataDir() / "bootstrap.dat.old";
             NLogFormat("Importing bootstrap.dat...");
+            {
+                LOCK(cs_import);
+                importProgress.strFile = pathBootstrap.string();
+                importProgress.nFile++;
+            }
             LoadExternalBlockFile(Params(), file, nullptr);
             RenameOver(pathBootstrap, pathBootstrapOld);
         } else
@@ -2263,12 +2392,17 @@ void CChainComponent::ThreadImport()
         }
     }
 
-    for (const std::string &strFile : Args().GetArgs("-loadblock"))
+    for (const std::string &strFile : vLoadBlocks)
     {
         FILE *file = fsbridge::fopen(strFile, "rb");
         if (file)
         {
             NLogFormat("Importing blocks file %s...", strFile);
+            {
+                LOCK(cs_import);
+                importProgress.strFile = strFile;
+                importProgress.nFile++;
+            }
             LoadExternalBlockFile(Params(), file, nullptr);
         } else
         {
@@ -2287,6 +2421,7 @@ void CChainComponent::ThreadImport()
     if (Args().GetArg<bool>("-stopafterblockimport", false))
     {
         NLogFormat("Stopping after block import");
+        GetApp()->RequestShutdown();
         return;
     }
 }
@@ -2322,132 +2457,123 @@ bool CChainComponent::LoadExternalBlockFile(const CChainParams &chainParams, FIL
     int64_t nStart = GetTimeMillis();
 
     int nLoaded = 0;
-    try
+    int nDecodeThreads = std::min(std::max(GetNumCores() - 1, 1), MAX_IMPORT_DECODE_THREADS);
+    // the context-free checks run on the decode threads, AcceptBlock skips them for the blocks that passed
+    CBlockImportPipeline blkdat(fileIn, chainParams.MessageStart(), nDecodeThreads,
+                                [this, &chainParams](const CBlock &block)
+                                {
+                                    CValidationState state;
+                                    CheckBlock(block, state, chainParams.GetConsensus(), true, true);
+                                });
+    {
+        LOCK(cs_import);
+        importProgress.nFileBytesRead = 0;
+        importProgress.nFileSize = blkdat.GetFileSize();
+    }
+
+    CBlockImportPipeline::Item item;
+    while (blkdat.Next(item))
     {
-        // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
-        CBufferedFile blkdat(fileIn, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8, SER_DISK,
-                             CLIENT_VERSION);
-        uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof())
+        boost::this_thread::interruption_point();
+
         {
-            boost::this_thread::interruption_point();
+            LOCK(cs_import);
+            importProgress.nFileBytesRead = blkdat.GetBytesRead();
+            importProgress.nBlocksRead++;
+        }
 
-            blkdat.SetPos(nRewind);
-            nRewind++; // start one byte further next time, in case of failure
-            blkdat.SetLimit(); // remove former limit
-            unsigned int nSize = 0;
-            try
-            {
-                // locate a header
-                unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
-                blkdat.FindByte(chainParams.MessageStart()[0]);
-                nRewind = blkdat.GetPos() + 1;
-                blkdat >> FLATDATA(buf);
-                if (memcmp(buf, chainParams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE))
-                    continue;
-                // read size
-                blkdat >> nSize;
-                if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
-                    continue;
-            } catch (const std::exception &)
-            {
-                // no valid block header found; don't complain
-                break;
-            }
-            try
+        try
+        {
+            if (dbp)
+                dbp->nPos = item.nPos;
+            std::shared_ptr<CBlock> pblock = item.pblock;
+            CBlock &block = *pblock;
+
+            // detect out of order blocks, and store them for later
+            const uint256 &hash = item.hash;
+            bool bParentNotFound = (cIndexManager.GetBlockIndex(block.hashPrevBlock) == nullptr) ? true : false;
+            if (hash != chainParams.GetConsensus().hashGenesisBlock && bParentNotFound)
             {
-                // read block
-                uint64_t nBlockPos = blkdat.GetPos();
+                NLogFormat("%s: Out of order block %s, parent %s not known", __func__,
+                           hash.ToString(),
+                           block.hashPrevBlock.ToString());
                 if (dbp)
-                    dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                blkdat.SetPos(nBlockPos);
-                std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock &block = *pblock;
-                blkdat >> block;
-                nRewind = blkdat.GetPos();
-
-                // detect out of order blocks, and store them for later
-                uint256 hash = block.GetHash();
-                bool bParentNotFound = (cIndexManager.GetBlockIndex(block.hashPrevBlock) == nullptr) ? true : false;
-                if (hash != chainParams.GetConsensus().hashGenesisBlock && bParentNotFound)
-                {
-                    NLogFormat("%s: Out of order block %s, parent %s not known", __func__,
-                               hash.ToString(),
-                               block.hashPrevBlock.ToString());
-                    if (dbp)
-                        mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                    continue;
-                }
+                    mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+                continue;
+            }
 
-                // process in case the block isn't known yet
-                if ((cIndexManager.GetBlockIndex(hash) == nullptr) ||
-                    (cIndexManager.GetBlockIndex(hash)->nStatus & BLOCK_HAVE_DATA) == 0)
-                {
-                    LOCK(cs_main);
-                    CValidationState state;
-                    if (AcceptBlock(pblock, state, chainParams, nullptr, true, dbp, nullptr))
-                        nLoaded++;
-                    if (state.IsError())
-                        break;
-                } else if (hash != chainParams.GetConsensus().hashGenesisBlock &&
-                           cIndexManager.GetBlockIndex(hash)->nHeight % 1000 == 0)
-                {
-                    NLogFormat("Block Import: already had block %s at height %d", hash.ToString(),
-                               cIndexManager.GetBlockIndex(hash)->nHeight);
-                }
+            // process in case the block isn't known yet
+            if ((cIndexManager.GetBlockIndex(hash) == nullptr) ||
+                (cIndexManager.GetBlockIndex(hash)->nStatus & BLOCK_HAVE_DATA) == 0)
+            {
+                LOCK(cs_main);
+                CValidationState state;
+                if (AcceptBlock(pblock, state, chainParams, nullptr, true, dbp, nullptr))
+                    nLoaded++;
+                if (state.IsError())
+                    break;
+            } else if (hash != chainParams.GetConsensus().hashGenesisBlock &&
+                       cIndexManager.GetBlockIndex(hash)->nHeight % 1000 == 0)
+            {
+                NLogFormat("Block Import: already had block %s at height %d", hash.ToString(),
+                           cIndexManager.GetBlockIndex(hash)->nHeight);
+            }
 
-                // Activate the genesis block so normal node progress can continue
-                if (hash == chainParams.GetConsensus().hashGenesisBlock)
+            // Activate the genesis block so normal node progress can continue
+            if (hash == chainParams.GetConsensus().hashGenesisBlock)
+            {
+                CValidationState state;
+                if (!ActivateBestChain(state, chainParams, nullptr))
                 {
-                    CValidationState state;
-                    if (!ActivateBestChain(state, chainParams, nullptr))
-                    {
-                        break;
-                    }
+                    break;
                 }
+            }
 
-                NotifyHeaderTip();
+            NotifyHeaderTip();
 
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty())
+            // Recursively process earlier encountered successors of this block
+            std::deque<uint256> queue;
+            queue.push_back(hash);
+            while (!queue.empty())
+            {
+                uint256 head = queue.front();
+                queue.pop_front();
+                std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(
+                        head);
+                while (range.first != range.second)
                 {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(
-                            head);
-                    while (range.first != range.second)
+                    std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+                    std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+                    if (ReadBlockFromDisk(*pblockrecursive, it->second, chainParams.GetConsensus()))
                     {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, chainParams.GetConsensus()))
+                        ILogFormat("%s: Processing out of order child %s of %s", __func__,
+                                   pblockrecursive->GetHash().ToString(),
+                                   head.ToString());
+                        LOCK(cs_main);
+                        CValidationState dummy;
+                        if (AcceptBlock(pblockrecursive, dummy, chainParams, nullptr, true, &it->second, nullptr))
                         {
-                            ILogFormat("%s: Processing out of order child %s of %s", __func__,
-                                       pblockrecursive->GetHash().ToString(),
-                                       head.ToString());
-                            LOCK(cs_main);
-                            CValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, chainParams, nullptr, true, &it->second, nullptr))
-                            {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
+                            nLoaded++;
+                            queue.push_back(pblockrecursive->GetHash());
                         }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        NotifyHeaderTip();
                     }
+                    range.first++;
+                    mapBlocksUnknownParent.erase(it);
+                    NotifyHeaderTip();
                 }
-            } catch (const std::exception &e)
-            {
-                ELogFormat("Deserialize or I/O error - %s", e.what());
             }
+        } catch (const std::exception &e)
+        {
+            ELogFormat("Deserialize or I/O error - %s", e.what());
         }
-    } catch (const std::runtime_error &e)
+    }
+
+    std::string strError = blkdat.GetError();
+    if (!strError.empty())
+        AbortNode(std::string("System error: ") + strError);
     {
-        AbortNode(std::string("System error: ") + e.what());
+        LOCK(cs_import);
+        importProgress.nBlocksLoaded += nLoaded;
     }
     if (nLoaded > 0)
         NLogFormat("Loaded %i blocks from external file in %dms", nLoaded, GetTimeMillis() - nStart);
@@ -2566,6 +2692,7 @@ bool CChainComponent::LoadCheckPoint()
 
     if (cCheckPointDB.LoadCheckPoint(values))
     {
+        LOCK(cs_main);
         std::map<int, Checkpoints::CCheckData>::iterator it = values.begin();
         while (it != values.end())
         {
@@ -2606,6 +2733,7 @@ bool CChainComponent::VerifyDB(const CChainParams &chainparams, CCoinsView *coin
     uint256 oldHashStateRoot, oldHashUTXORoot;
     GET_CONTRACT_INTERFACE(ifContractObj);
     ifContractObj->GetState(oldHashStateRoot, oldHashUTXORoot);//sbtc-vm
+    int nStateHistoryDepth = ifContractObj->GetStateHistoryDepth();
 
     ILogFormat("[0%%]...");
     for (CBlockIndex *pindex = chainActive.Tip(); pindex && pindex->pprev; pindex = pindex->pprev)
@@ -2628,6 +2756,13 @@ bool CChainComponent::VerifyDB(const CChainParams &chainparams, CCoinsView *coin
             NLogFormat("VerifyDB(): block verification stopping at height %d (pruning, no data)", pindex->nHeight);
             break;
         }
+        if (nStateHistoryDepth > 0 && pindex->nHeight <= chainActive.Height() - nStateHistoryDepth)
+        {
+            // Disconnecting it would need the contract state of its parent, which may be pruned.
+            NLogFormat("VerifyDB(): block verification stopping at height %d (contract state pruned)",
+                       pindex->nHeight);
+            break;
+        }
         CBlock block;
         // check level 0: read from disk
         if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
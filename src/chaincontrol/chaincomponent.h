@@ -2,11 +2,13 @@
 
 #include <set>
 #include <map>
+#include <atomic>
 #include <log4cpp/Category.hh>
 #include "interface/ichaincomponent.h"
 #include "blockfilemanager.h"
 #include "blockindexmanager.h"
 #include "viewmanager.h"
+#include "blockimport.h"
 #include "mempool/txmempool.h"
 #include "sbtccore/checkqueue.h"
 #include "sbtccore/block/blockencodings.h"
@@ -178,6 +180,8 @@ public:
 
     bool IsReindexing() const override;
 
+    CImportProgress GetImportProgress() override;
+
     bool IsTxIndex() const override;
 
     bool IsLogEvents() override;
@@ -194,6 +198,8 @@ public:
 
     CChain &GetActiveChain() override;
 
+    std::shared_ptr<const CChainView> GetActiveChainView() override;
+
     std::set<const CBlockIndex *, CompareBlocksByHeight> GetTips() override;
 
     CBlockIndex *FindForkInGlobalIndex(const CChain &chain, const CBlockLocator &locator) override;
@@ -279,8 +285,11 @@ private:
 
 private:
     database _db;
-    bool bReIndex;
+    std::atomic<bool> bReIndex;
     bool bRequestShutdown;
+    std::atomic<bool> bImportRunning{false};
+    CCriticalSection cs_import;
+    CImportProgress importProgress;
     CBlockIndexManager &cIndexManager = CBlockIndexManager::Instance();
     CViewManager &cViewManager = CViewManager::Instance();
 
@@ -30,6 +30,9 @@ static std::shared_ptr<const CBlockHeaderAndShortTxIDs> most_recent_compact_bloc
 static uint256 most_recent_block_hash;
 static bool fWitnessesPresentInMostRecentCompactBlock;
 
+// Historical blocks recently served from their blk file bytes
+static CRawBlockCache rawBlockCache(DEFAULT_RAW_BLOCK_CACHE_SIZE);
+
 void CChainComponent::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock> &pblock)
 {
     GetMainSignals().NewPoWValidBlock(pindex, pblock);
@@ -68,7 +71,10 @@ bool CChainComponent::NetRequestCheckPoint(ExNode *xnode, int height)
 
     std::vector<Checkpoints::CCheckData> vSendData;
     std::vector<Checkpoints::CCheckData> vnHeight;
-    Checkpoints::GetCheckpointByHeight(height, vnHeight);
+    {
+        LOCK(cs_main);
+        Checkpoints::GetCheckpointByHeight(height, vnHeight);
+    }
     {
         LOCK(cs_xnodeGuard);
         std::set<int> &checkpointKnown = m_nodeCheckPointKnown[xnode->nodeID];
@@ -103,26 +109,30 @@ bool CChainComponent::NetReceiveCheckPoint(ExNode *xnode, CDataStream &stream)
     Checkpoints::CCheckPointDB cCheckPointDB;
     std::vector<int> toInsertCheckpoints;
     std::vector<Checkpoints::CCheckData> vIndex;
-    for (const auto &point : vdata)
     {
-        if (point.CheckSignature(Params().GetCheckPointPKey()))
+        // mapCheckpoints is guarded by cs_main, like the header checks reading it
+        LOCK(cs_main);
+        for (const auto &point : vdata)
         {
-            if (!cCheckPointDB.ExistCheckpoint(point.getHeight()))
+            if (point.CheckSignature(Params().GetCheckPointPKey()))
+            {
+                if (!cCheckPointDB.ExistCheckpoint(point.getHeight()))
+                {
+                    cCheckPointDB.WriteCheckpoint(point.getHeight(), point);
+                    /*
+                     * add the check point to chainparams
+                     */
+                    Params().AddCheckPoint(point.getHeight(), point.getHash());
+                    toInsertCheckpoints.push_back(point.getHeight());
+                    vIndex.push_back(point);
+                }
+            } else
             {
-                cCheckPointDB.WriteCheckpoint(point.getHeight(), point);
-                /*
-                 * add the check point to chainparams
-                 */
-                Params().AddCheckPoint(point.getHeight(), point.getHash());
-                toInsertCheckpoints.push_back(point.getHeight());
-                vIndex.push_back(point);
+                ELogFormat("check point signature check failed");
+                break;
             }
-        } else
-        {
-            ELogFormat("check point signature check failed");
-            break;
+            NLogFormat("block height=%d, block hash=%s", point.getHeight(), point.getHash().ToString());
         }
-        NLogFormat("block height=%d, block hash=%s", point.getHeight(), point.getHash().ToString());
     }
 
     if (!toInsertCheckpoints.empty())
@@ -233,6 +243,9 @@ bool CChainComponent::NetRequestHeaders(ExNode *xnode, CDataStream &stream)
     uint256 hashStop;
     stream >> locator >> hashStop;
 
+    // the message handler threads do not hold cs_main, the block index and chainActive are read under it
+    LOCK(cs_main);
+
     const CBlockIndex *pindex = nullptr;
     if (locator.IsNull())
     {
@@ -551,124 +564,175 @@ bool CChainComponent::NetRequestBlockData(ExNode *xnode, uint256 blockHash, int
         fWitnessesPresentInARecentCompactBlock = fWitnessesPresentInMostRecentCompactBlock;
     }
 
-    CBlockIndex *bi = cIndexManager.GetBlockIndex(blockHash);
-    if (bi != nullptr)
+    // Serving a block from the blk files does not need cs_main, only choosing it does.
+    bool fSendRaw = false;
+    CDiskBlockPos rawBlockPos;
+    uint256 rawBlockHash;
     {
-        if (bi->nChainTx && !bi->IsValid(BLOCK_VALID_SCRIPTS) && bi->IsValid(BLOCK_VALID_TREE))
+        LOCK(cs_main);
+        CBlockIndex *bi = cIndexManager.GetBlockIndex(blockHash);
+        if (bi != nullptr)
         {
-            // If we have the block and all of its parents, but have not yet validated it,
-            // we might be in the middle of connecting it (ie in the unlock of cs_main
-            // before ActivateBestChain but after AcceptBlock).
-            // In this case, we need to run ActivateBestChain prior to checking the relay
-            // conditions below.
-            CValidationState dummy;
-            ActivateBestChain(dummy, Params(), a_recent_block);
-        }
+            if (bi->nChainTx && !bi->IsValid(BLOCK_VALID_SCRIPTS) && bi->IsValid(BLOCK_VALID_TREE))
+            {
+                // If we have the block and all of its parents, but have not yet validated it,
+                // we might be in the middle of connecting it (ie in the unlock of cs_main
+                // before ActivateBestChain but after AcceptBlock).
+                // In this case, we need to run ActivateBestChain prior to checking the relay
+                // conditions below.
+                CValidationState dummy;
+                ActivateBestChain(dummy, Params(), a_recent_block);
+            }
 
-        if (cIndexManager.GetChain().Contains(bi))
-        {
-            isOK = true;
-        } else
-        {
-            static const int nOneMonth = 30 * 24 * 60 * 60;
-            // To prevent fingerprinting attacks, only send blocks outside of the active
-            // chain if they are valid, and no more than a month older (both in time, and in
-            // best equivalent proof of work) than the best header chain we know about.
-            isOK = bi->IsValid(BLOCK_VALID_SCRIPTS) && (GetIndexBestHeader() != nullptr) &&
-                   (GetIndexBestHeader()->GetBlockTime() - bi->GetBlockTime() < nOneMonth) &&
-                   (GetBlockProofEquivalentTime(*GetIndexBestHeader(), *bi, *GetIndexBestHeader(),
-                                                consensusParams) < nOneMonth);
-            if (!isOK)
+            if (cIndexManager.GetChain().Contains(bi))
+            {
+                isOK = true;
+            } else
             {
-                WLogFormat("ignoring request from peer=%i for old block that isn't in the main chain", xnode->nodeID);
+                static const int nOneMonth = 30 * 24 * 60 * 60;
+                // To prevent fingerprinting attacks, only send blocks outside of the active
+                // chain if they are valid, and no more than a month older (both in time, and in
+                // best equivalent proof of work) than the best header chain we know about.
+                isOK = bi->IsValid(BLOCK_VALID_SCRIPTS) && (GetIndexBestHeader() != nullptr) &&
+                       (GetIndexBestHeader()->GetBlockTime() - bi->GetBlockTime() < nOneMonth) &&
+                       (GetBlockProofEquivalentTime(*GetIndexBestHeader(), *bi, *GetIndexBestHeader(),
+                                                    consensusParams) < nOneMonth);
+                if (!isOK)
+                {
+                    WLogFormat("ignoring request from peer=%i for old block that isn't in the main chain", xnode->nodeID);
+                }
             }
         }
-    }
-    // disconnect node in case we have reached the outbound limit for serving historical blocks
-    // never disconnect whitelisted nodes
-    static const int nOneWeek = 7 * 24 * 60 * 60; // assume > 1 week = historical
-    if (isOK && ifNetObj->OutboundTargetReached(true) && (((GetIndexBestHeader() != nullptr) &&
-                                                           (GetIndexBestHeader()->GetBlockTime() -
-                                                            bi->GetBlockTime() > nOneWeek)) ||
-                                                          blockType == MSG_FILTERED_BLOCK) &&
-        !IsFlagsBitOn(xnode->flags, NF_WHITELIST))
-    {
-        WLogFormat("historical block serving limit reached, disconnect peer=%d", xnode->nodeID);
-
-        //disconnect node
-        SetFlagsBit(xnode->retFlags, NF_DISCONNECT);
-        isOK = false;
-    }
-    // Pruned nodes may have deleted the block, so check whether
-    // it's available before trying to send.
-    if (isOK && (bi->nStatus & BLOCK_HAVE_DATA))
-    {
-        std::shared_ptr<const CBlock> pblock;
-        if (a_recent_block && a_recent_block->GetHash() == bi->GetBlockHash())
+        // disconnect node in case we have reached the outbound limit for serving historical blocks
+        // never disconnect whitelisted nodes
+        static const int nOneWeek = 7 * 24 * 60 * 60; // assume > 1 week = historical
+        if (isOK && ifNetObj->OutboundTargetReached(true) && (((GetIndexBestHeader() != nullptr) &&
+                                                               (GetIndexBestHeader()->GetBlockTime() -
+                                                                bi->GetBlockTime() > nOneWeek)) ||
+                                                              blockType == MSG_FILTERED_BLOCK) &&
+            !IsFlagsBitOn(xnode->flags, NF_WHITELIST))
         {
-            pblock = a_recent_block;
-        } else
-        {
-            // Send block from disk
-            std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-            if (!ReadBlockFromDisk(*pblockRead, bi, consensusParams))
-                assert(!"cannot load block from disk");
-            pblock = pblockRead;
+            WLogFormat("historical block serving limit reached, disconnect peer=%d", xnode->nodeID);
+
+            //disconnect node
+            SetFlagsBit(xnode->retFlags, NF_DISCONNECT);
+            isOK = false;
         }
-        if (blockType == MSG_BLOCK)
-        {
-            SendNetMessage(xnode->nodeID, NetMsgType::BLOCK, xnode->sendVersion, SERIALIZE_TRANSACTION_NO_WITNESS,
-                           *pblock);
-        } else if (blockType == MSG_WITNESS_BLOCK)
-        {
-            SendNetMessage(xnode->nodeID, NetMsgType::BLOCK, xnode->sendVersion, 0, *pblock);
-        } else if (blockType == MSG_FILTERED_BLOCK)
+        // Pruned nodes may have deleted the block, so check whether
+        // it's available before trying to send.
+        if (isOK && (bi->nStatus & BLOCK_HAVE_DATA))
         {
-            if (filter)
+            std::shared_ptr<const CBlock> pblock;
+            if (a_recent_block && a_recent_block->GetHash() == bi->GetBlockHash())
             {
-                CMerkleBlock merkleBlock = CMerkleBlock(*pblock, *(CBloomFilter *)filter);
-                SendNetMessage(xnode->nodeID, NetMsgType::MERKLEBLOCK, xnode->sendVersion, 0, merkleBlock);
-                // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
-                // This avoids hurting performance by pointlessly requiring a round-trip
-                // Note that there is currently no way for a node to request any single transactions we didn't send here -
-                // they must either disconnect and retry or request the full block.
-                // Thus, the protocol spec specified allows for us to provide duplicate txn here,
-                // however we MUST always provide at least what the remote peer needs
-                typedef std::pair<unsigned int, uint256> PairType;
-                for (PairType &pair : merkleBlock.vMatchedTxn)
-                    SendNetMessage(xnode->nodeID, NetMsgType::TX, xnode->sendVersion, SERIALIZE_TRANSACTION_NO_WITNESS,
-                                   *pblock->vtx[pair.first]);
+                pblock = a_recent_block;
+            } else if (blockType == MSG_WITNESS_BLOCK ||
+                       (blockType == MSG_BLOCK && !IsWitnessEnabled(bi->pprev, consensusParams)))
+            {
+                // The blk file holds the block serialized with witness, which is what the peer asked for,
+                // or is the same bytes for a block that can't carry any witness: send them as they are.
+                // The disk read and the send happen below, once cs_main is released.
+                rawBlockPos = bi->GetBlockPos();
+                rawBlockHash = bi->GetBlockHash();
+                fSendRaw = true;
             }
-            // else
-            // no response
-        } else if (blockType == MSG_CMPCT_BLOCK)
-        {
-            // If a peer is asking for old blocks, we're almost guaranteed
-            // they won't have a useful mempool to match against a compact block,
-            // and we don't feel like constructing the object for them, so
-            // instead we respond with the full, non-compact block.
-            bool fPeerWantsWitness = IsFlagsBitOn(xnode->flags, NF_WANTCMPCTWITNESS);
-            int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-            bool fCanDirectFetch = Tip()->GetBlockTime() > (GetAdjustedTime() - consensusParams.nPowTargetSpacing * 20);
-            if (fCanDirectFetch &&
-                bi->nHeight >= cIndexManager.GetChain().Height() - MAX_CMPCTBLOCK_DEPTH)
+
+            if (!fSendRaw)
             {
-                if ((fPeerWantsWitness || !fWitnessesPresentInARecentCompactBlock) &&
-                    a_recent_compact_block &&
-                    a_recent_compact_block->header.GetHash() == bi->GetBlockHash())
+                if (!pblock)
                 {
-                    SendNetMessage(xnode->nodeID, NetMsgType::CMPCTBLOCK, xnode->sendVersion, nSendFlags,
-                                   *a_recent_compact_block);
-                } else
+                    // Send block from disk
+                    std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+                    if (!ReadBlockFromDisk(*pblockRead, bi, consensusParams))
+                        assert(!"cannot load block from disk");
+                    pblock = pblockRead;
+                }
+                if (blockType == MSG_BLOCK)
+                {
+                    SendNetMessage(xnode->nodeID, NetMsgType::BLOCK, xnode->sendVersion, SERIALIZE_TRANSACTION_NO_WITNESS,
+                                   *pblock);
+                } else if (blockType == MSG_WITNESS_BLOCK)
                 {
-                    CBlockHeaderAndShortTxIDs cmpctblock(*pblock, fPeerWantsWitness);
-                    SendNetMessage(xnode->nodeID, NetMsgType::CMPCTBLOCK, xnode->sendVersion, nSendFlags, cmpctblock);
+                    SendNetMessage(xnode->nodeID, NetMsgType::BLOCK, xnode->sendVersion, 0, *pblock);
+                } else if (blockType == MSG_FILTERED_BLOCK)
+                {
+                    if (filter)
+                    {
+                        CMerkleBlock merkleBlock = CMerkleBlock(*pblock, *(CBloomFilter *)filter);
+                        SendNetMessage(xnode->nodeID, NetMsgType::MERKLEBLOCK, xnode->sendVersion, 0, merkleBlock);
+                        // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
+                        // This avoids hurting performance by pointlessly requiring a round-trip
+                        // Note that there is currently no way for a node to request any single transactions we didn't send here -
+                        // they must either disconnect and retry or request the full block.
+                        // Thus, the protocol spec specified allows for us to provide duplicate txn here,
+                        // however we MUST always provide at least what the remote peer needs
+                        typedef std::pair<unsigned int, uint256> PairType;
+                        for (PairType &pair : merkleBlock.vMatchedTxn)
+                            SendNetMessage(xnode->nodeID, NetMsgType::TX, xnode->sendVersion, SERIALIZE_TRANSACTION_NO_WITNESS,
+                                           *pblock->vtx[pair.first]);
+                    }
+                    // else
+                    // no response
+                } else if (blockType == MSG_CMPCT_BLOCK)
+                {
+                    // If a peer is asking for old blocks, we're almost guaranteed
+                    // they won't have a useful mempool to match against a compact block,
+                    // and we don't feel like constructing the object for them, so
+                    // instead we respond with the full, non-compact block.
+                    bool fPeerWantsWitness = IsFlagsBitOn(xnode->flags, NF_WANTCMPCTWITNESS);
+                    int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
+                    bool fCanDirectFetch = Tip()->GetBlockTime() > (GetAdjustedTime() - consensusParams.nPowTargetSpacing * 20);
+                    if (fCanDirectFetch &&
+                        bi->nHeight >= cIndexManager.GetChain().Height() - MAX_CMPCTBLOCK_DEPTH)
+                    {
+                        if ((fPeerWantsWitness || !fWitnessesPresentInARecentCompactBlock) &&
+                            a_recent_compact_block &&
+                            a_recent_compact_block->header.GetHash() == bi->GetBlockHash())
+                        {
+                            SendNetMessage(xnode->nodeID, NetMsgType::CMPCTBLOCK, xnode->sendVersion, nSendFlags,
+                                           *a_recent_compact_block);
+                        } else
+                        {
+                            CBlockHeaderAndShortTxIDs cmpctblock(*pblock, fPeerWantsWitness);
+                            SendNetMessage(xnode->nodeID, NetMsgType::CMPCTBLOCK, xnode->sendVersion, nSendFlags, cmpctblock);
+                        }
+                    } else
+                    {
+                        SendNetMessage(xnode->nodeID, NetMsgType::BLOCK, xnode->sendVersion, nSendFlags, *pblock);
+                    }
                 }
-            } else
+            }
+        }
+    }
+
+    if (fSendRaw)
+    {
+        CRawBlockCache::RawBlock rawBlock = rawBlockCache.Get(rawBlockHash);
+        if (!rawBlock)
+        {
+            std::shared_ptr<std::vector<unsigned char>> rawRead = std::make_shared<std::vector<unsigned char>>();
+            if (ReadRawBlockFromDisk(*rawRead, rawBlockPos, Params().MessageStart()) &&
+                Hash(rawRead->begin(), rawRead->begin() + 80) == rawBlockHash)
             {
-                SendNetMessage(xnode->nodeID, NetMsgType::BLOCK, xnode->sendVersion, nSendFlags, *pblock);
+                rawBlock = rawRead;
+                rawBlockCache.Insert(rawBlockHash, rawBlock);
             }
         }
+        if (rawBlock)
+        {
+            ifNetObj->SendNetMessage(xnode->nodeID, NetMsgType::BLOCK, rawBlock);
+            return isOK;
+        }
+
+        // Send block from disk, decoded and serialized again
+        CBlock block;
+        if (!ReadBlockFromDisk(block, rawBlockPos, consensusParams) || block.GetHash() != rawBlockHash)
+        {
+            ELogFormat("failed to read block %s from disk for peer=%d", rawBlockHash.ToString(), xnode->nodeID);
+            return false;
+        }
+        int nSendFlags = blockType == MSG_WITNESS_BLOCK ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
+        SendNetMessage(xnode->nodeID, NetMsgType::BLOCK, xnode->sendVersion, nSendFlags, block);
     }
     return isOK;
 }
@@ -139,25 +139,23 @@ CViewManager::DisconnectBlock(const CBlock &block, const CBlockIndex *pindex, CC
     GET_CONTRACT_INTERFACE(ifContractObj);
     uint256 hashStateRoot;
     uint256 hashUTXORoot;
-    CBlock prevblock;
-    if (!ReadBlockFromDisk(prevblock, pindex->pprev, Params().GetConsensus())) {
-        //TODO  LogError
-        rLogError("ReadBlockFromDisk failed at %d, hash=%s", pindex->pprev->nHeight,
-                         pindex->pprev->GetBlockHash().ToString());
-    } else {
-        if(prevblock.GetVMState(hashStateRoot, hashUTXORoot) == RET_VM_STATE_ERR)
-        {
-            ILogFormat("GetVMState err");
-        }
+    if (ReadVMStateFromIndex(pindex->pprev, hashStateRoot, hashUTXORoot, Params().GetConsensus()) ==
+        RET_VM_STATE_ERR)
+    {
+        ILogFormat("GetVMState err");
     }
     ifContractObj->UpdateState(hashStateRoot, hashUTXORoot);
-   // ifContractObj->UpdateState(pindex->pprev->hashStateRoot, pindex->pprev->hashUTXORoot);
 
     GET_CHAIN_INTERFACE(ifChainObj);
+    if (pfClean == NULL)
+    {
+        ifChainObj->GetBlockTreeDB()->EraseContractRegistry(pindex->nHeight);
+    }
     if (pfClean == NULL && ifChainObj->IsLogEvents())
     {
         ifContractObj->DeleteResults(block.vtx);
         ifChainObj->GetBlockTreeDB()->EraseHeightIndex(pindex->nHeight);
+        ifChainObj->GetBlockTreeDB()->EraseLogIndex(pindex->nHeight);
     }
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
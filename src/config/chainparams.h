@@ -155,6 +155,7 @@ public:
         return vFixedSeeds;
     }
 
+    //! mapCheckpoints grows with the checkpoints received from peers, read and add them under cs_main
     const CCheckpointData &Checkpoints() const
     {
         return checkpointData;
@@ -20,6 +20,7 @@ struct ByteCodeExecResult
     CAmount refundSender = 0;           //the total amount for refund to every sender of contract tx
     std::vector<CTxOut> refundOutputs;  //the CTXout for refund amount to every sender of contract tx
     std::vector<CTransaction> valueTransfers;  //after running the contract tx ,need to run the TX
+    std::vector<std::pair<dev::h160, uint256>> createdContracts;  //address and code hash of the contracts the tx created
 };
 
 struct CHeightTxIndexIteratorKey
@@ -103,6 +104,126 @@ struct CHeightTxIndexKey
     }
 };
 
+/** Key of the (contract address, first log topic) -> transactions postings of one block */
+struct CLogTopicIndexKey
+{
+    dev::h160 address;
+    dev::h256 topic;
+    unsigned int height;
+
+    size_t GetSerializeSize(int nType, int nVersion) const
+    {
+        return 56;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream &s) const
+    {
+        s.write((const char *)address.data(), dev::h160::size);
+        s.write((const char *)topic.data(), dev::h256::size);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s)
+    {
+        s.read((char *)address.data(), dev::h160::size);
+        s.read((char *)topic.data(), dev::h256::size);
+        height = ser_readdata32be(s);
+    }
+
+    CLogTopicIndexKey(dev::h160 _address, dev::h256 _topic, unsigned int _height)
+    {
+        address = _address;
+        topic = _topic;
+        height = _height;
+    }
+
+    CLogTopicIndexKey()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        address.clear();
+        topic.clear();
+        height = 0;
+    }
+};
+
+/** Log index of one block: the bloom of its contract addresses and log entries, and the
+ *  transactions of each contract address grouped by the first topic of the logs they emitted. */
+struct CBlockLogIndex
+{
+    dev::h2048 bloom;
+    std::map<std::pair<dev::h160, dev::h256>, std::vector<uint256>> topics;
+};
+
+/** Position of a contract in the contract registry: contracts are listed in creation order */
+struct CContractRegistryKey
+{
+    unsigned int height;    //!< height of the block that created the contract
+    unsigned int order;     //!< creation order within that block
+    dev::h160 address;
+
+    size_t GetSerializeSize(int nType, int nVersion) const
+    {
+        return 28;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream &s) const
+    {
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, order);
+        s.write((const char *)address.data(), dev::h160::size);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s)
+    {
+        height = ser_readdata32be(s);
+        order = ser_readdata32be(s);
+        s.read((char *)address.data(), dev::h160::size);
+    }
+
+    CContractRegistryKey(unsigned int _height, unsigned int _order, dev::h160 _address)
+    {
+        height = _height;
+        order = _order;
+        address = _address;
+    }
+
+    CContractRegistryKey()
+    {
+        SetNull();
+    }
+
+    void SetNull()
+    {
+        height = 0;
+        order = 0;
+        address.clear();
+    }
+};
+
+/** Contract registry entry. The balance is not kept here, it changes with every call to the contract */
+struct CContractRegistryEntry
+{
+    uint256 hashCode;
+    uint256 txid;           //!< null for the contracts registered from the state they were found in
+
+    ADD_SERIALIZE_METHODS;
+
+    template<typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(hashCode);
+        READWRITE(txid);
+    }
+};
+
 #endif //SUPERBITCOIN_CONTRACTBASE_H
 
 
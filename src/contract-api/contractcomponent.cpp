@@ -12,6 +12,10 @@
 #include "univalue/include/univalue.h"
 #include "utils/timedata.h"
 #include "contractconfig.h"
+#include "contractsnapshot.h"
+#include "statepruner.h"
+
+#include <list>
 
 static std::unique_ptr<SbtcState> globalState;
 static std::shared_ptr<dev::eth::SealEngineFace> globalSealEngine;
@@ -20,6 +24,32 @@ static bool fRecordLogOpcodes = false;
 static bool fIsVMlogFile = false;
 static bool fGettingValuesDGP = false;
 
+// coinbase of the tip block, the EVM environment of read-only calls takes its author from it
+static CCriticalSection cs_tipCoinbase;
+static CTransactionRef tipCoinbase;
+static uint256 hashTipCoinbase;
+
+// read-only snapshots of recently queried roots, most recently used first
+static const size_t MAX_STATE_SNAPSHOTS = 8;
+static CCriticalSection cs_stateSnapshots;
+static std::list<std::shared_ptr<CContractStateSnapshot>> stateSnapshots;
+static dev::OverlayDB stateDiskView;
+static dev::OverlayDB utxoDiskView;
+
+// governance parameters read from the DGP contracts on the global state
+static CDGPCache dgpCache;
+
+// memory the staged trie nodes may take before they are written ahead of the next full flush
+static size_t nContractDBCache = DEFAULT_CONTRACT_DB_CACHE << 20;
+
+// trie nodes read from disk, shared by the state and UTXO databases and the snapshots over them
+static std::shared_ptr<dev::NodeCache> nodeCache;
+
+// deletes the trie nodes only the blocks below the -prunecontractstate window reach
+static std::unique_ptr<CStatePruner> statePruner;
+
+static CCriticalSection cs_vmLog;
+
 SET_CPP_SCOPED_LOG_CATEGORY(CID_CONTRACT);
 
 
@@ -135,6 +165,8 @@ UniValue vmLogToJSON(const ResultExecute &execRes, const CTransaction &tx, const
 void writeVMlog(const std::vector<ResultExecute> &res, const CTransaction &tx = CTransaction(),
                 const CBlock &block = CBlock())
 {
+    // read-only calls log from the RPC threads
+    LOCK(cs_vmLog);
     boost::filesystem::path sbtcDir = GetDataDir() / "vmExecLogs.json";
     std::stringstream ss;
     if (fIsVMlogFile)
@@ -166,24 +198,33 @@ void writeVMlog(const std::vector<ResultExecute> &res, const CTransaction &tx =
     fIsVMlogFile = true;
 }
 
-std::vector<ResultExecute> CallContract(const dev::Address &addrContract, std::vector<unsigned char> opcode,
-                                        const dev::Address &sender = dev::Address(), uint64_t gasLimit = 0)
+// state and sealEngine are nullptr to run on the global state
+static std::vector<ResultExecute> ExecuteCall(SbtcState *state, dev::eth::SealEngineFace *sealEngine,
+                                              const CBlockIndex *pTip, uint64_t blockGasLimit,
+                                              const dev::Address &addrContract, std::vector<unsigned char> opcode,
+                                              const dev::Address &sender, uint64_t gasLimit)
 {
-    CBlock block;
     CMutableTransaction tx;
 
-    GET_CHAIN_INTERFACE(ifChainObj);
-
-    CBlockIndex *pTip = ifChainObj->GetActiveChain().Tip();
-
-    CBlockIndex *pblockindex = ifChainObj->GetBlockIndex(pTip->GetBlockHash());
-
-    ReadBlockFromDisk(block, pblockindex, Params().GetConsensus());
+    // only the tip header and its coinbase are needed, so the tip block is read once per tip instead of per call
+    CBlock block(pTip->GetBlockHeader());
+    {
+        LOCK(cs_tipCoinbase);
+        if (hashTipCoinbase != pTip->GetBlockHash())
+        {
+            CBlock tipBlock;
+            tipCoinbase.reset();
+            hashTipCoinbase.SetNull();
+            if (ReadBlockFromDisk(tipBlock, pTip, Params().GetConsensus()) && !tipBlock.vtx.empty())
+            {
+                tipCoinbase = tipBlock.vtx[0];
+                hashTipCoinbase = pTip->GetBlockHash();
+            }
+        }
+        if (tipCoinbase)
+            block.vtx.push_back(tipCoinbase);
+    }
     block.nTime = GetAdjustedTime();
-    block.vtx.erase(block.vtx.begin() + 1, block.vtx.end());
-
-    SbtcDGP sbtcDGP(globalState.get(), fGettingValuesDGP);
-    uint64_t blockGasLimit = sbtcDGP.getBlockGasLimit(pTip->nHeight + 1);
 
     if (gasLimit == 0)
     {
@@ -200,11 +241,56 @@ std::vector<ResultExecute> CallContract(const dev::Address &addrContract, std::v
     callTransaction.setVersion(VersionVM::GetEVMDefault());
 
 
-    ByteCodeExec exec(block, std::vector<SbtcTransaction>(1, callTransaction), blockGasLimit);
+    ByteCodeExec exec(block, std::vector<SbtcTransaction>(1, callTransaction), blockGasLimit, state, sealEngine,
+                      pTip);
     exec.performByteCode(dev::eth::Permanence::Reverted);
     return exec.getResult();
 }
 
+static DGPParams GetDGPParams(int height)
+{
+    return dgpCache.Get(height, globalState->rootHash(), [height]()
+    {
+        SbtcDGP sbtcDGP(globalState.get(), fGettingValuesDGP);
+        DGPParams params;
+        params.schedule = sbtcDGP.getGasSchedule(height);
+        params.minGasPrice = sbtcDGP.getMinGasPrice(height);
+        params.blockGasLimit = sbtcDGP.getBlockGasLimit(height);
+        return params;
+    });
+}
+
+std::vector<ResultExecute> CallContract(const dev::Address &addrContract, std::vector<unsigned char> opcode,
+                                        const dev::Address &sender = dev::Address(), uint64_t gasLimit = 0)
+{
+    GET_CHAIN_INTERFACE(ifChainObj);
+
+    CBlockIndex *pTip = ifChainObj->GetActiveChain().Tip();
+
+    uint64_t blockGasLimit = GetDGPParams(pTip->nHeight + 1).blockGasLimit;
+
+    return ExecuteCall(nullptr, nullptr, pTip, blockGasLimit, addrContract, opcode, sender, gasLimit);
+}
+
+// The DGP templates run with the default block gas limit. Taking it from the DGP would ask the templates
+// again: GetDGPParams runs them for the gas schedule and CallContract reads GetDGPParams.
+std::vector<ResultExecute> CallDGPContract(const dev::Address &addrContract, std::vector<unsigned char> opcode)
+{
+    GET_CHAIN_INTERFACE(ifChainObj);
+
+    CBlockIndex *pTip = ifChainObj->GetActiveChain().Tip();
+
+    return ExecuteCall(nullptr, nullptr, pTip, DEFAULT_BLOCK_GAS_LIMIT_DGP, addrContract, opcode, dev::Address(), 0);
+}
+
+std::vector<ResultExecute> CallContractOnState(SbtcState &state, dev::eth::SealEngineFace &sealEngine,
+                                               const CBlockIndex *pTip, uint64_t blockGasLimit,
+                                               const dev::Address &addrContract, std::vector<unsigned char> opcode,
+                                               const dev::Address &sender, uint64_t gasLimit)
+{
+    return ExecuteCall(&state, &sealEngine, pTip, blockGasLimit, addrContract, opcode, sender, gasLimit);
+}
+
 
 CContractComponent::CContractComponent()
 {
@@ -249,6 +335,10 @@ bool CContractComponent::ContractInit()
     globalState = std::unique_ptr<SbtcState>(
             new SbtcState(dev::u256(0), SbtcState::openDB(dirSbtc, hashDB, dev::WithExisting::Trust), dirSbtc,
                           existstate));
+    nodeCache = std::make_shared<dev::NodeCache>(
+            std::max<int64_t>(Args().GetArg<int64_t>("-contractnodecache", DEFAULT_CONTRACT_NODE_CACHE), 0) << 20);
+    globalState->db().setNodeCache(nodeCache);
+    globalState->dbUtxo().setNodeCache(nodeCache);
     dev::eth::ChainParams cp((dev::eth::genesisInfo(dev::eth::Network::sbtcMainNetwork)));
     globalSealEngine = std::unique_ptr<dev::eth::SealEngineFace>(cp.createSealEngine());
 
@@ -263,26 +353,17 @@ bool CContractComponent::ContractInit()
     if (IsEnabled)
     {
         CBlockIndex *pTip = ifChainObj->GetActiveChain().Tip();
-        CBlock block;
-        if (!ReadBlockFromDisk(block, pTip, Params().GetConsensus()))
+        uint256 hashStateRoot;
+        uint256 hashUTXORoot;
+        if (ReadVMStateFromIndex(pTip, hashStateRoot, hashUTXORoot, Params().GetConsensus()) != RET_VM_STATE_OK)
         {
-            rLogError("ReadBlockFromDisk failed at %d, hash=%s", pTip->nHeight,
-                      pTip->GetBlockHash().ToString());
+            rLogError("GetVMState failed at %d, hash=%s", pTip->nHeight, pTip->GetBlockHash().ToString());
             assert(0);
             return false;
         } else
         {
-            uint256 hashStateRoot;
-            uint256 hashUTXORoot;
-            if(block.GetVMState(hashStateRoot, hashUTXORoot) != RET_VM_STATE_OK)
-            {
-                assert(0);
-                rLogError("GetVMState failed");
-                return false;
-            }else {
-                globalState->setRoot(uintToh256(hashStateRoot));
-                globalState->setRootUTXO(uintToh256(hashUTXORoot));
-            }
+            globalState->setRoot(uintToh256(hashStateRoot));
+            globalState->setRootUTXO(uintToh256(hashUTXORoot));
         }
     } else
     {
@@ -294,6 +375,49 @@ bool CContractComponent::ContractInit()
     globalState->db().commit();
     globalState->dbUtxo().commit();
 
+    {
+        LOCK(cs_stateSnapshots);
+        stateDiskView = globalState->db().diskView();
+        utxoDiskView = globalState->dbUtxo().diskView();
+    }
+
+    bool fContractRegistry = false;
+    if (!ifChainObj->GetBlockTreeDB()->ReadFlag("contractregistry", fContractRegistry) || !fContractRegistry)
+    {
+        // contracts created before the registry was kept are registered once from the state at the tip,
+        // in address order, under height 0
+        std::map<dev::h160, dev::u256> contracts;
+        for (const auto &e : globalState->addresses())
+            contracts.insert(e);
+        std::vector<std::pair<dev::h160, CContractRegistryEntry>> entries;
+        for (const auto &e : contracts)
+        {
+            CContractRegistryEntry entry;
+            entry.hashCode = h256Touint(globalState->codeHash(e.first));
+            entries.push_back(std::make_pair(e.first, entry));
+        }
+        if (!ifChainObj->GetBlockTreeDB()->WriteContractRegistry(0, entries) ||
+            !ifChainObj->GetBlockTreeDB()->WriteFlag("contractregistry", true))
+        {
+            return rLogError("%s: failed to write the contract registry", __func__);
+        }
+        ILogFormat("Registered %u existing contracts", entries.size());
+    }
+
+    nContractDBCache = std::max<int64_t>(Args().GetArg<int64_t>("-contractdbcache", DEFAULT_CONTRACT_DB_CACHE),
+                                         MIN_CONTRACT_DB_CACHE) << 20;
+
+    int nPruneContractState = Args().GetArg<int>("-prunecontractstate", DEFAULT_PRUNE_CONTRACT_STATE);
+    if (nPruneContractState != 0)
+    {
+        if (nPruneContractState < (int)MIN_BLOCKS_TO_KEEP)
+        {
+            return rLogError("-prunecontractstate must keep at least %u blocks", MIN_BLOCKS_TO_KEEP);
+        }
+        statePruner.reset(new CStatePruner(globalState->db(), globalState->dbUtxo(), nPruneContractState));
+        statePruner->Start();
+        ILogFormat("Contract state pruning enabled, keeping the last %d blocks", nPruneContractState);
+    }
     fRecordLogOpcodes = Args().IsArgSet("-record-log-opcodes");
     fIsVMlogFile = boost::filesystem::exists(GetDataDir() / "vmExecLogs.json");
 
@@ -316,10 +440,27 @@ bool CContractComponent::ComponentShutdown()
 {
     NLogStream() << "shutdown CContract component";
 
+    if (statePruner)
+    {
+        statePruner->Stop();
+        statePruner.reset();
+    }
     delete pstorageresult;
     pstorageresult = NULL;
+    {
+        LOCK(cs_main);
+        FlushState(true);
+    }
+    {
+        LOCK(cs_stateSnapshots);
+        stateSnapshots.clear();
+        stateDiskView = dev::OverlayDB();
+        utxoDiskView = dev::OverlayDB();
+    }
+    dgpCache.Clear();
     delete globalState.release();
     globalSealEngine.reset();
+    nodeCache.reset();
     return true;
 }
 
@@ -337,9 +478,9 @@ uint64_t CContractComponent::GetMinGasPrice(int height)
         return 0;
     }
 
-    SbtcDGP sbtcDGP(globalState.get(), fGettingValuesDGP);
-    globalSealEngine->setSbtcSchedule(sbtcDGP.getGasSchedule(height));
-    minGasPrice = sbtcDGP.getMinGasPrice(height);
+    DGPParams params = GetDGPParams(height);
+    globalSealEngine->setSbtcSchedule(params.schedule);
+    minGasPrice = params.minGasPrice;
 
     return minGasPrice;
 }
@@ -358,13 +499,54 @@ uint64_t CContractComponent::GetBlockGasLimit(int height)
         return 0;
     }
 
-    SbtcDGP sbtcDGP(globalState.get(), fGettingValuesDGP);
-    globalSealEngine->setSbtcSchedule(sbtcDGP.getGasSchedule(height));
-    blockGasLimit = sbtcDGP.getBlockGasLimit(height);
+    DGPParams params = GetDGPParams(height);
+    globalSealEngine->setSbtcSchedule(params.schedule);
+    blockGasLimit = params.blockGasLimit;
 
     return blockGasLimit;
 }
 
+void CContractComponent::FlushState(bool fForce)
+{
+    if (!globalState)
+        return;
+    size_t nUsage = globalState->db().stagedMemoryUsage() + globalState->dbUtxo().stagedMemoryUsage();
+    if (nUsage == 0 || (!fForce && nUsage <= nContractDBCache))
+        return;
+    int64_t nStart = GetTimeMicros();
+    globalState->db().flush();
+    globalState->dbUtxo().flush();
+    NLogFormat("Wrote %.1fMiB of contract state in %.2fms", nUsage * (1.0 / (1 << 20)),
+               (GetTimeMicros() - nStart) * 0.001);
+}
+
+dev::NodeCache::Stats CContractComponent::GetNodeCacheStats()
+{
+    if (!nodeCache)
+        return dev::NodeCache::Stats{0, 0, 0, 0, 0};
+    return nodeCache->stats();
+}
+
+int CContractComponent::GetStateHistoryDepth()
+{
+    if (!statePruner)
+        return 0;
+    return statePruner->GetKeepBlocks();
+}
+
+void CContractComponent::UpdateDGPCache(const CBlockIndex *pTip, bool fPrime)
+{
+    if (pTip == nullptr)
+    {
+        dgpCache.Clear();
+        return;
+    }
+    // the parameters of the next block are kept, those above belong to blocks taken off
+    dgpCache.EraseAbove(pTip->nHeight + 1);
+    if (fPrime && pTip->IsSBTCContractEnabled())
+        GetDGPParams(pTip->nHeight + 1);
+}
+
 bool CContractComponent::AddressInUse(string contractaddress)
 {
 //    GET_CHAIN_INTERFACE(ifChainObj);
@@ -862,6 +1044,14 @@ bool CContractComponent::ContractTxConnectBlock(CTransaction tx, uint32_t transa
         return false;
     }
 
+    for (size_t k = 0; k < resultConvertQtumTX.first.size(); k++)
+    {
+        for (const dev::Address &newAddress : resultExec[k].createdContracts)
+        {
+            bcer.createdContracts.push_back(std::make_pair(newAddress, h256Touint(globalState->codeHash(newAddress))));
+        }
+    }
+
     countCumulativeGasUsed += bcer.usedGas;
     std::vector<TransactionReceiptInfo> tri;
     if (bLogEvents)
@@ -946,6 +1136,48 @@ void CContractComponent::UpdateState(uint256 hashStateRoot, uint256 hashUTXORoot
     globalState->setRootUTXO(uintToh256(hashUTXORoot));
 }
 
+void CContractComponent::PushStateLayer()
+{
+    bool IsEnabled =  [&]()->bool{
+        GET_CHAIN_INTERFACE(ifChainObj);
+        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
+        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+    }();
+    if (!IsEnabled)
+    {
+        return;
+    }
+    globalState->pushLayer();
+}
+
+void CContractComponent::MergeStateLayer()
+{
+    bool IsEnabled =  [&]()->bool{
+        GET_CHAIN_INTERFACE(ifChainObj);
+        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
+        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+    }();
+    if (!IsEnabled)
+    {
+        return;
+    }
+    globalState->mergeLayer();
+}
+
+void CContractComponent::DiscardStateLayer()
+{
+    bool IsEnabled =  [&]()->bool{
+        GET_CHAIN_INTERFACE(ifChainObj);
+        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
+        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+    }();
+    if (!IsEnabled)
+    {
+        return;
+    }
+    globalState->discardLayer();
+}
+
 void CContractComponent::DeleteResults(std::vector<CTransactionRef> const &txs)
 {
     bool IsEnabled =  [&]()->bool{
@@ -962,10 +1194,11 @@ void CContractComponent::DeleteResults(std::vector<CTransactionRef> const &txs)
 
 std::vector<TransactionReceiptInfo> CContractComponent::GetResult(uint256 const &hashTx)
 {
+    // called from the RPC threads without cs_main, the tip is read once from the published view
     bool IsEnabled =  [&]()->bool{
         GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+        const CBlockIndex *pTip = ifChainObj->GetActiveChainView()->Tip();
+        return pTip != nullptr && pTip->IsSBTCContractEnabled();
     }();
     if (!IsEnabled)
     {
@@ -974,6 +1207,21 @@ std::vector<TransactionReceiptInfo> CContractComponent::GetResult(uint256 const
     return pstorageresult->getResult(uintToh256(hashTx));
 }
 
+std::vector<TransactionReceiptInfo> CContractComponent::GetCommittedResult(uint256 const &hashTx)
+{
+    // called from the RPC threads without cs_main, the tip is read once from the published view
+    bool IsEnabled =  [&]()->bool{
+        GET_CHAIN_INTERFACE(ifChainObj);
+        const CBlockIndex *pTip = ifChainObj->GetActiveChainView()->Tip();
+        return pTip != nullptr && pTip->IsSBTCContractEnabled();
+    }();
+    if (!IsEnabled)
+    {
+         return std::vector<TransactionReceiptInfo>();
+    }
+    return pstorageresult->getCommittedResult(uintToh256(hashTx));
+}
+
 void CContractComponent::CommitResults()
 {
     bool IsEnabled =  [&]()->bool{
@@ -1019,24 +1267,47 @@ std::map<dev::h256, std::pair<dev::u256, dev::u256>> CContractComponent::GetStor
     return storage;
 };
 
-void CContractComponent::SetTemporaryState(uint256 hashStateRoot, uint256 hashUTXORoot)
+std::shared_ptr<CContractStateSnapshot> CContractComponent::GetStateSnapshot(uint256 hashStateRoot,
+                                                                           uint256 hashUTXORoot)
 {
+    if (hashStateRoot.IsNull() || hashUTXORoot.IsNull())
+    {
+        return nullptr;
+    }
+    dev::h256 root = uintToh256(hashStateRoot);
+    dev::h256 rootUTXO = uintToh256(hashUTXORoot);
 
-    bool IsEnabled =  [&]()->bool{
-        GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
-    }();
-    if (!IsEnabled)
+    LOCK(cs_stateSnapshots);
+    for (auto it = stateSnapshots.begin(); it != stateSnapshots.end(); ++it)
     {
-        return;
+        if ((*it)->GetStateRoot() == root && (*it)->GetUTXORoot() == rootUTXO)
+        {
+            stateSnapshots.splice(stateSnapshots.begin(), stateSnapshots, it);
+            return stateSnapshots.front();
+        }
     }
-    if (hashStateRoot.IsNull() || hashUTXORoot.IsNull())
+    if (!stateDiskView.db() || !utxoDiskView.db())
     {
-        return;
+        return nullptr;
+    }
+
+    std::shared_ptr<CContractStateSnapshot> snapshot;
+    try
+    {
+        snapshot = std::make_shared<CContractStateSnapshot>(stateDiskView, utxoDiskView, root, rootUTXO);
+    }
+    catch (const dev::Exception &e)
+    {
+        ELogFormat("cannot open contract state %s/%s: %s", hashStateRoot.ToString(), hashUTXORoot.ToString(),
+                   e.what());
+        return nullptr;
+    }
+    stateSnapshots.push_front(snapshot);
+    if (stateSnapshots.size() > MAX_STATE_SNAPSHOTS)
+    {
+        stateSnapshots.pop_back();
     }
-    TemporaryState ts(globalState);
-    ts.SetRoot(uintToh256(hashStateRoot), uintToh256(hashUTXORoot));
+    return snapshot;
 }
 
 std::unordered_map<dev::h160, dev::u256> CContractComponent::GetContractList()
@@ -1149,15 +1420,11 @@ UniValue transactionReceiptToJSON(const dev::eth::TransactionReceipt &txRec)
     return result;
 }
 
-void CContractComponent::RPCCallContract(UniValue &result, const string addrContract, std::vector<unsigned char> opcode,
-                                         string sender, uint64_t gasLimit)
+void CContractComponent::RPCCallContract(UniValue &result, CContractStateSnapshot &snapshot, const CBlockIndex *pTip,
+                                         const string addrContract, std::vector<unsigned char> opcode, string sender,
+                                         uint64_t gasLimit)
 {
-    bool IsEnabled =  [&]()->bool{
-        GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
-    }();
-    if (!IsEnabled)
+    if (!pTip->IsSBTCContractEnabled())
     {
         return;
     }
@@ -1165,7 +1432,7 @@ void CContractComponent::RPCCallContract(UniValue &result, const string addrCont
     dev::Address addrAccount(addrContract);
     dev::Address senderAddress(sender);
 
-    std::vector<ResultExecute> execResults = CallContract(addrAccount, opcode, senderAddress, gasLimit);
+    std::vector<ResultExecute> execResults = snapshot.Call(pTip, addrAccount, opcode, senderAddress, gasLimit);
     if (fRecordLogOpcodes)
     {
         writeVMlog(execResults);
@@ -1176,6 +1443,8 @@ void CContractComponent::RPCCallContract(UniValue &result, const string addrCont
 
 bool ByteCodeExec::performByteCode(dev::eth::Permanence type)
 {
+    SbtcState *execState = state ? state : globalState.get();
+    dev::eth::SealEngineFace *execSealEngine = sealEngine ? sealEngine : globalSealEngine.get();
     for (SbtcTransaction &tx : txs)
     {
         //validate VM version
@@ -1184,7 +1453,7 @@ bool ByteCodeExec::performByteCode(dev::eth::Permanence type)
             return false;
         }
         dev::eth::EnvInfo envInfo(BuildEVMEnvironment());
-        if (!tx.isCreation() && !globalState->addressInUse(tx.receiveAddress()))
+        if (!tx.isCreation() && !execState->addressInUse(tx.receiveAddress()))
         {
             ILogFormat("performByteCode execption====="); //sbtc debug
             dev::eth::ExecutionResult execRes;
@@ -1195,11 +1464,16 @@ bool ByteCodeExec::performByteCode(dev::eth::Permanence type)
             continue;
         }
         ILogFormat("performByteCode start exec====="); //sbtc debug
-        result.push_back(globalState->execute(envInfo, *globalSealEngine.get(), tx, type, OnOpFunc()));
+        result.push_back(execState->execute(envInfo, *execSealEngine, tx, type, OnOpFunc()));
     }
-    globalState->db().commit();
-    globalState->dbUtxo().commit();
-    globalSealEngine.get()->deleteAddresses.clear();
+    // a snapshot only reads the databases, what it executed is dropped with it. The global state is
+    // staged in memory and written with the chain state, see CContractComponent::FlushState
+    if (!state)
+    {
+        globalState->db().stage();
+        globalState->dbUtxo().stage();
+    }
+    execSealEngine->deleteAddresses.clear();
     return true;
 }
 
@@ -1260,7 +1534,7 @@ dev::eth::EnvInfo ByteCodeExec::BuildEVMEnvironment()
     GET_CHAIN_INTERFACE(ifChainObj);
 
     dev::eth::EnvInfo env;
-    CBlockIndex *tip = ifChainObj->GetActiveChain().Tip();
+    const CBlockIndex *tip = pTip ? pTip : ifChainObj->GetActiveChain().Tip();
     env.setNumber(dev::u256(tip->nHeight + 1));
     env.setTimestamp(dev::u256(block.nTime));
     env.setDifficulty(dev::u256(block.nBits));
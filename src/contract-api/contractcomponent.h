@@ -94,6 +94,19 @@ public:
     {
     }
 
+    /// Executes on a state snapshot instead of the global state, in the block after _pTip. Nothing is committed.
+    ByteCodeExec(const CBlock &_block, std::vector<SbtcTransaction> _txs, const uint64_t _blockGasLimit,
+                 SbtcState *_state, dev::eth::SealEngineFace *_sealEngine, const CBlockIndex *_pTip) : txs(_txs),
+                                                                                                       block(_block),
+                                                                                                       blockGasLimit(
+                                                                                                               _blockGasLimit),
+                                                                                                       state(_state),
+                                                                                                       sealEngine(
+                                                                                                               _sealEngine),
+                                                                                                       pTip(_pTip)
+    {
+    }
+
     bool performByteCode(dev::eth::Permanence type = dev::eth::Permanence::Committed);
 
     bool processingResults(ByteCodeExecResult &result);
@@ -117,8 +130,20 @@ private:
 
     const uint64_t blockGasLimit;
 
+    SbtcState *state = nullptr;
+
+    dev::eth::SealEngineFace *sealEngine = nullptr;
+
+    const CBlockIndex *pTip = nullptr;
+
 };
 
+/// Runs a read-only call to a contract on the given state, as if in the block after pTip.
+std::vector<ResultExecute> CallContractOnState(SbtcState &state, dev::eth::SealEngineFace &sealEngine,
+                                               const CBlockIndex *pTip, uint64_t blockGasLimit,
+                                               const dev::Address &addrContract, std::vector<unsigned char> opcode,
+                                               const dev::Address &sender, uint64_t gasLimit);
+
 class CContractComponent : public IContractComponent
 {
 public:
@@ -138,6 +163,14 @@ public:
 
     uint64_t GetBlockGasLimit(int height) override;
 
+    void UpdateDGPCache(const CBlockIndex *pTip, bool fPrime) override;
+
+    void FlushState(bool fForce) override;
+
+    dev::NodeCache::Stats GetNodeCacheStats() override;
+
+    int GetStateHistoryDepth() override;
+
     bool AddressInUse(string contractaddress) override;
 
     bool CheckContractTx(const CTransaction tx, const CAmount nFees,
@@ -164,17 +197,25 @@ public:
 
     void UpdateState(uint256 hashStateRoot, uint256 hashUTXORoot) override;
 
+    void PushStateLayer() override;
+
+    void MergeStateLayer() override;
+
+    void DiscardStateLayer() override;
+
     void DeleteResults(std::vector<CTransactionRef> const &txs) override;
 
     std::vector<TransactionReceiptInfo> GetResult(uint256 const &hashTx) override;
 
+    std::vector<TransactionReceiptInfo> GetCommittedResult(uint256 const &hashTx) override;
+
     void CommitResults() override;
 
     void ClearCacheResult() override;
 
     std::map<dev::h256, std::pair<dev::u256, dev::u256>> GetStorageByAddress(string address) override;
 
-    void SetTemporaryState(uint256 hashStateRoot, uint256 hashUTXORoot) override;
+    std::shared_ptr<CContractStateSnapshot> GetStateSnapshot(uint256 hashStateRoot, uint256 hashUTXORoot) override;
 
     std::unordered_map<dev::h160, dev::u256> GetContractList() override;
 
@@ -185,9 +226,9 @@ public:
     bool
     GetContractVin(dev::Address address, dev::h256 &hash, uint32_t &nVout, dev::u256 &value, uint8_t &alive) override;
 
-    void
-    RPCCallContract(UniValue &result, const string addrContract, std::vector<unsigned char> opcode, string sender = "",
-                    uint64_t gasLimit = 0) override;
+    void RPCCallContract(UniValue &result, CContractStateSnapshot &snapshot, const CBlockIndex *pTip,
+                         const string addrContract, std::vector<unsigned char> opcode, string sender = "",
+                         uint64_t gasLimit = 0) override;
 
     string GetExceptedInfo(uint32_t index) override;
 
@@ -28,6 +28,16 @@ static const uint64_t MEMPOOL_MIN_GAS_LIMIT = 22000;
 
 #define CONTRACT_STATE_DIR "stateContract"
 
+//memory in megabytes the contract state may take between two flushes of the chain state, and its lower bound
+static const int64_t DEFAULT_CONTRACT_DB_CACHE = 100;
+static const int64_t MIN_CONTRACT_DB_CACHE = 4;
+
+//memory in megabytes of the trie nodes read from the contract state databases kept for later reads
+static const int64_t DEFAULT_CONTRACT_NODE_CACHE = 64;
+
+//blocks back from the tip whose contract state is kept by -prunecontractstate, 0 keeps all of it
+static const int DEFAULT_PRUNE_CONTRACT_STATE = 0;
+
 static const uint256 DEFAULT_HASH_STATE_ROOT = uint256S(
         "0x9514771014c9ae803d8cea2731b2063e83de44802b40dce2d06acd02d0ff65e9");
 static const uint256 DEFAULT_HASH_UTXO_ROOT = uint256S(
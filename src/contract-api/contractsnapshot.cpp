@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////
+//  contractsnapshot.cpp
+//  Implementation of the Class CContractStateSnapshot
+///////////////////////////////////////////////////////////
+
+#include "contractsnapshot.h"
+#include "contractcomponent.h"
+#include "chaincontrol/chain.h"
+
+CContractStateSnapshot::CContractStateSnapshot(const dev::OverlayDB &dbState, const dev::OverlayDB &dbUTXO,
+                                               const dev::h256 &hashStateRootIn, const dev::h256 &hashUTXORootIn)
+        : hashStateRoot(hashStateRootIn),
+          hashUTXORoot(hashUTXORootIn),
+          state(dev::u256(0), dbState, dbUTXO, hashStateRootIn, hashUTXORootIn)
+{
+    dev::eth::ChainParams cp((dev::eth::genesisInfo(dev::eth::Network::sbtcMainNetwork)));
+    sealEngine = std::unique_ptr<dev::eth::SealEngineFace>(cp.createSealEngine());
+}
+
+bool CContractStateSnapshot::AddressInUse(const dev::Address &address)
+{
+    LOCK(cs);
+    return state.addressInUse(address);
+}
+
+dev::u256 CContractStateSnapshot::GetBalance(const dev::Address &address)
+{
+    LOCK(cs);
+    return state.balance(address);
+}
+
+std::vector<uint8_t> CContractStateSnapshot::GetCode(const dev::Address &address)
+{
+    LOCK(cs);
+    return state.code(address);
+}
+
+std::map<dev::h256, std::pair<dev::u256, dev::u256>> CContractStateSnapshot::GetStorage(const dev::Address &address)
+{
+    LOCK(cs);
+    return state.storage(address);
+}
+
+bool CContractStateSnapshot::GetVin(const dev::Address &address, Vin &vin)
+{
+    LOCK(cs);
+    const Vin *pvin = state.vin(address);
+    if (pvin == nullptr || !pvin->alive)
+        return false;
+    vin = *pvin;
+    return true;
+}
+
+std::vector<ResultExecute> CContractStateSnapshot::Call(const CBlockIndex *pTip, const dev::Address &addrContract,
+                                                        const std::vector<unsigned char> &opcode,
+                                                        const dev::Address &sender, uint64_t gasLimit)
+{
+    LOCK(cs);
+    // The DGP contracts are read from the snapshot's storage: their evm mode would call them
+    // through the global state.
+    SbtcDGP sbtcDGP(&state, false);
+    sealEngine->setSbtcSchedule(sbtcDGP.getGasSchedule(pTip->nHeight + 1));
+    uint64_t blockGasLimit = sbtcDGP.getBlockGasLimit(pTip->nHeight + 1);
+    return CallContractOnState(state, *sealEngine, pTip, blockGasLimit, addrContract, opcode, sender, gasLimit);
+}
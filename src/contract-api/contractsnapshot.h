@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////
+//  contractsnapshot.h
+//  Implementation of the Class CContractStateSnapshot
+///////////////////////////////////////////////////////////
+#ifndef SUPERBITCOIN_CONTRACTSNAPSHOT_H
+#define SUPERBITCOIN_CONTRACTSNAPSHOT_H
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "framework/sync.h"
+#include "sbtcstate.h"
+
+class CBlockIndex;
+
+/**
+ * Immutable view of the contract state at a pair of (state, UTXO) roots, for the read-only RPCs.
+ * The trie nodes are read from the committed or staged state through the snapshot's own overlay
+ * and account cache, so neither cs_main nor the consensus state is touched. Queries on the same
+ * snapshot run one at a time, different snapshots are read in parallel.
+ */
+class CContractStateSnapshot
+{
+public:
+    /** Throws dev::eth::RootNotFound if either root has not been committed to the databases */
+    CContractStateSnapshot(const dev::OverlayDB &dbState, const dev::OverlayDB &dbUTXO,
+                           const dev::h256 &hashStateRoot, const dev::h256 &hashUTXORoot);
+
+    const dev::h256 &GetStateRoot() const
+    {
+        return hashStateRoot;
+    }
+
+    const dev::h256 &GetUTXORoot() const
+    {
+        return hashUTXORoot;
+    }
+
+    bool AddressInUse(const dev::Address &address);
+
+    dev::u256 GetBalance(const dev::Address &address);
+
+    std::vector<uint8_t> GetCode(const dev::Address &address);
+
+    std::map<dev::h256, std::pair<dev::u256, dev::u256>> GetStorage(const dev::Address &address);
+
+    bool GetVin(const dev::Address &address, Vin &vin);
+
+    /** Executes a call to a contract as if in the block after pTip, nothing of it is kept */
+    std::vector<ResultExecute> Call(const CBlockIndex *pTip, const dev::Address &addrContract,
+                                    const std::vector<unsigned char> &opcode, const dev::Address &sender,
+                                    uint64_t gasLimit);
+
+private:
+    const dev::h256 hashStateRoot;
+    const dev::h256 hashUTXORoot;
+
+    CCriticalSection cs;
+    SbtcState state;
+    std::unique_ptr<dev::eth::SealEngineFace> sealEngine;
+};
+
+#endif //SUPERBITCOIN_CONTRACTSNAPSHOT_H
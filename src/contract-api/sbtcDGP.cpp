@@ -143,12 +143,14 @@ void SbtcDGP::initStorageTemplate(const dev::Address &addr)
     storageTemplate = state->storage(addr);
 }
 
-extern std::vector<ResultExecute> CallContract(const dev::Address &addrContract, std::vector<unsigned char> opcode,
-                                               const dev::Address &sender = dev::Address(), uint64_t gasLimit = 0);
+extern std::vector<ResultExecute> CallDGPContract(const dev::Address &addrContract, std::vector<unsigned char> opcode);
 
 void SbtcDGP::initDataTemplate(const dev::Address &addr, std::vector<unsigned char> &data)
 {
-    dataTemplate = CallContract(addr, data)[0].execRes.output;
+    if (callTemplate)
+        dataTemplate = callTemplate(addr, data);
+    else
+        dataTemplate = CallDGPContract(addr, data)[0].execRes.output;
 }
 
 void SbtcDGP::createParamsInstance()
@@ -306,3 +308,40 @@ void SbtcDGP::clear()
     storageTemplate.clear();
     paramsInstance.clear();
 }
+
+DGPParams CDGPCache::Get(int height, const dev::h256 &root, const ComputeFn &compute)
+{
+    std::pair<int, dev::h256> key(height, root);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end())
+            return it->second;
+    }
+
+    DGPParams params = compute();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.size() >= MAX_DGP_CACHE_ENTRIES && !entries.count(key))
+        entries.erase(entries.begin());
+    entries[key] = params;
+    return params;
+}
+
+void CDGPCache::EraseAbove(int height)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.erase(entries.lower_bound(std::make_pair(height + 1, dev::h256())), entries.end());
+}
+
+void CDGPCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+size_t CDGPCache::Size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
@@ -6,6 +6,10 @@
 #include "validation.h"
 #include "utilstrencodings.h"
 
+#include <functional>
+#include <map>
+#include <mutex>
+
 static const dev::Address GasScheduleDGP = dev::Address("0000000000000000000000000000000000000080");
 static const dev::Address BlockSizeDGP = dev::Address("0000000000000000000000000000000000000081");
 static const dev::Address GasPriceDGP = dev::Address("0000000000000000000000000000000000000082");
@@ -24,12 +28,16 @@ static const uint64_t MIN_BLOCK_GAS_LIMIT_DGP = 1000000;
 static const uint64_t MAX_BLOCK_GAS_LIMIT_DGP = 1000000000;
 static const uint64_t DEFAULT_BLOCK_GAS_LIMIT_DGP = 40000000;
 
+//sbtc in evm mode, runs a read-only call of a DGP template contract and returns its output
+typedef std::function<std::vector<unsigned char>(const dev::Address &, const std::vector<unsigned char> &)> DGPCallFn;
+
 class SbtcDGP
 {
 
 public:
 
-    SbtcDGP(SbtcState *_state, bool _dgpevm = true) : dgpevm(_dgpevm), state(_state)
+    SbtcDGP(SbtcState *_state, bool _dgpevm = true, DGPCallFn _callTemplate = DGPCallFn())
+            : dgpevm(_dgpevm), state(_state), callTemplate(std::move(_callTemplate))
     {
         initDataEIP158();
     }
@@ -80,6 +88,8 @@ private:
 
     const SbtcState *state;
 
+    DGPCallFn callTemplate;  //sbtc CallDGPContract on the global state if empty
+
     dev::Address templateContract;
 
     std::map<dev::h256, std::pair<dev::u256, dev::u256>> storageDGP; //sbtc hashedKey,<key,value>
@@ -94,4 +104,40 @@ private:
 
 };
 
+// governance parameters read from the DGP contracts for a block height
+struct DGPParams
+{
+    dev::eth::EVMSchedule schedule;
+    uint64_t minGasPrice;
+    uint64_t blockGasLimit;
+};
+
+static const size_t MAX_DGP_CACHE_ENTRIES = 8;
+
+/**
+ * The DGP parameters of the last few heights, keyed by (height, state root) so a hit is exactly what a new
+ * SbtcDGP on that state would return. Past MAX_DGP_CACHE_ENTRIES the lowest height, one the chain has moved
+ * past, is dropped.
+ */
+class CDGPCache
+{
+public:
+    typedef std::function<DGPParams()> ComputeFn;
+
+    // compute runs without the lock held: in evm mode the DGP getters run the templates, which read the
+    // parameters again
+    DGPParams Get(int height, const dev::h256 &root, const ComputeFn &compute);
+
+    // drops the entries above height, after a disconnect they belong to the blocks taken off
+    void EraseAbove(int height);
+
+    void Clear();
+
+    size_t Size();
+
+private:
+    std::mutex mutex;
+    std::map<std::pair<int, dev::h256>, DGPParams> entries;
+};
+
 #endif
@@ -19,6 +19,16 @@ SbtcState::SbtcState(u256 const &_accountStartNonce, OverlayDB const &_db, const
     stateUTXO = SecureTrieDB<Address, OverlayDB>(&dbUTXO);
 }
 
+SbtcState::SbtcState(u256 const &_accountStartNonce, OverlayDB const &_db, OverlayDB const &_dbUTXO,
+                     h256 const &_root, h256 const &_rootUTXO) :
+        State(_accountStartNonce, _db, BaseState::PreExisting),
+        dbUTXO(_dbUTXO)
+{
+    stateUTXO = SecureTrieDB<Address, OverlayDB>(&dbUTXO);
+    setRoot(_root);
+    setRootUTXO(_rootUTXO);
+}
+
 SbtcState::SbtcState() : dev::eth::State(dev::Invalid256, dev::OverlayDB(), dev::eth::BaseState::PreExisting)
 {
     dbUTXO = OverlayDB();
@@ -56,6 +66,7 @@ SbtcState::execute(EnvInfo const &_envInfo, SealEngineFace const &_sealEngine, S
 
     CTransactionRef tx;
     u256 startGasUsed;
+    std::vector<dev::Address> createdContracts;
     try
     {
         if (_t.isCreation() && _t.value())
@@ -101,6 +112,16 @@ SbtcState::execute(EnvInfo const &_envInfo, SealEngineFace const &_sealEngine, S
                 printfErrorLog(res.excepted);
             }
 
+            // the changes of reverted calls are rolled back out of the log, what is left was created for good
+            for (auto const &change : m_changeLog)
+            {
+                if (change.kind != dev::eth::detail::Change::NewCode)
+                    continue;
+                auto it = m_cache.find(change.address);
+                if (it != m_cache.end() && it->second.isAlive() && !it->second.code().empty())
+                    createdContracts.push_back(change.address);
+            }
+
             ILogFormat("SbtcState::execute commit"); //sbtc debug
             sbtc::commit(cacheUTXO, stateUTXO, m_cache);
             cacheUTXO.clear();
@@ -156,10 +177,37 @@ SbtcState::execute(EnvInfo const &_envInfo, SealEngineFace const &_sealEngine, S
     } else
     {
         return ResultExecute{res, dev::eth::TransactionReceipt(rootHash(), startGasUsed + e.gasUsed(), e.logs()),
-                             tx ? *tx : CTransaction()};
+                             tx ? *tx : CTransaction(), createdContracts};
     }
 }
 
+void SbtcState::pushLayer()
+{
+    layerRoots.emplace_back(rootHash(), rootHashUTXO());
+    m_db.pushLayer();
+    dbUTXO.pushLayer();
+}
+
+void SbtcState::mergeLayer()
+{
+    if (layerRoots.empty())
+        return;
+    layerRoots.pop_back();
+    m_db.mergeLayer();
+    dbUTXO.mergeLayer();
+}
+
+void SbtcState::discardLayer()
+{
+    if (layerRoots.empty())
+        return;
+    m_db.discardLayer();
+    dbUTXO.discardLayer();
+    setRoot(layerRoots.back().first);
+    setRootUTXO(layerRoots.back().second);
+    layerRoots.pop_back();
+}
+
 std::unordered_map<dev::Address, Vin> SbtcState::vins() const // temp
 {
     std::unordered_map<dev::Address, Vin> ret;
@@ -37,6 +37,7 @@ struct ResultExecute
     dev::eth::ExecutionResult execRes;
     dev::eth::TransactionReceipt txRec;
     CTransaction tx;
+    std::vector<dev::Address> createdContracts;  //contracts created by the tx or by CREATE in its calls, in order
 };
 
 namespace sbtc
@@ -76,6 +77,11 @@ public:
     SbtcState(dev::u256 const &_accountStartNonce, dev::OverlayDB const &_db, const std::string &_path,
               dev::eth::BaseState _bs = dev::eth::BaseState::PreExisting);
 
+    /// Opens the state at existing roots of already opened databases. Throws RootNotFound if
+    /// either root is not in them.
+    SbtcState(dev::u256 const &_accountStartNonce, dev::OverlayDB const &_db, dev::OverlayDB const &_dbUTXO,
+              dev::h256 const &_root, dev::h256 const &_rootUTXO);
+
     ResultExecute
     execute(dev::eth::EnvInfo const &_envInfo, dev::eth::SealEngineFace const &_sealEngine, SbtcTransaction const &_t,
             dev::eth::Permanence _p = dev::eth::Permanence::Committed, dev::eth::OnOpFunc const &_onOp = OnOpFunc());
@@ -108,12 +114,23 @@ public:
         return dbUTXO;
     }
 
+    /// Speculative execution: pushLayer() opens a child layer on the state and UTXO overlays,
+    /// mergeLayer() keeps what was executed since, discardLayer() drops it and returns to the
+    /// roots the layer was opened at. Commits to disk are deferred while a layer is open.
+    void pushLayer();
+
+    void mergeLayer();
+
+    void discardLayer();
+
     virtual ~SbtcState()
     {
     }
 
     friend CondensingTX;
 
+    friend class CContractStateSnapshot;
+
 private:
 
     void transferBalance(dev::Address const &_from, dev::Address const &_to, dev::u256 const &_value);
@@ -145,6 +162,8 @@ private:
     dev::eth::SecureTrieDB<dev::Address, dev::OverlayDB> stateUTXO;
 
     std::unordered_map<dev::Address, Vin> cacheUTXO;
+
+    std::vector<std::pair<dev::h256, dev::h256>> layerRoots;
 };
 
 
@@ -0,0 +1,275 @@
+///////////////////////////////////////////////////////////
+//  statepruner.cpp
+//  Implementation of the Class CStatePruner
+///////////////////////////////////////////////////////////
+
+#include "statepruner.h"
+#include "contractconfig.h"
+#include "sbtcstate.h"
+#include "chaincontrol/blockfilemanager.h"
+#include "chaincontrol/chain.h"
+#include "chaincontrol/coins.h"
+#include "config/chainparams.h"
+#include "sbtccore/block/validation.h"
+#include "interface/ichaincomponent.h"
+#include "contract/libdevcore/TrieCommon.h"
+#include "contract/libdevcore/TrieDB.h"
+#include "utils/util.h"
+#include "utils/utiltime.h"
+
+SET_CPP_SCOPED_LOG_CATEGORY(CID_CONTRACT);
+
+// unmarked nodes deleted per write batch
+static const size_t SWEEP_BATCH_SIZE = 10000;
+// nodes marked between two checks of the stop flag
+static const size_t MARK_CHECK_INTERVAL = 10000;
+
+CStatePruner::CStatePruner(const dev::OverlayDB &dbStateIn, const dev::OverlayDB &dbUTXOIn, int nKeepBlocksIn)
+        : dbState(dbStateIn.diskView()),
+          dbUTXO(dbUTXOIn.diskView()),
+          nKeepBlocks(nKeepBlocksIn),
+          nLastPruneHeight(0),
+          fStop(false)
+{
+}
+
+CStatePruner::~CStatePruner()
+{
+    Stop();
+}
+
+void CStatePruner::Start()
+{
+    fStop = false;
+    thread = std::thread(&CStatePruner::ThreadPrune, this);
+}
+
+void CStatePruner::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fStop = true;
+    }
+    cond.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+void CStatePruner::ThreadPrune()
+{
+    RenameThread("sbtc-stateprune");
+    GET_CHAIN_INTERFACE(ifChainObj);
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait_for(lock, std::chrono::minutes(1), [this] { return fStop.load(); });
+        }
+        if (fStop)
+            return;
+
+        int nHeight = ifChainObj->GetActiveChainView()->Height();
+        if (nHeight < nLastPruneHeight + nKeepBlocks)
+            continue;
+        // a cycle that failed is retried as late as one that succeeded
+        nLastPruneHeight = nHeight;
+        PruneCycle();
+    }
+}
+
+bool CStatePruner::PruneCycle()
+{
+    int64_t nStart = GetTimeMillis();
+
+    std::vector<dev::h256> vStateRoots(1, uintToh256(DEFAULT_HASH_STATE_ROOT));
+    std::vector<dev::h256> vUTXORoots(1, uintToh256(DEFAULT_HASH_UTXO_ROOT));
+    int nTipHeight;
+    {
+        // ConnectTip flushes the nodes of a new tip before UpdateTip publishes it, both under cs_main. Taking
+        // the roots and starting the sweep under it as well, a node on disk is either reachable from a root
+        // taken here or written while the sweep runs, and kept.
+        LOCK(cs_main);
+        dbState.beginSweep();
+        dbUTXO.beginSweep();
+        GET_CHAIN_INTERFACE(ifChainObj);
+        const CChain &chainActive = ifChainObj->GetActiveChain();
+        nTipHeight = chainActive.Height();
+        // the coins on disk can be far behind the tip: after a restart the blocks past their best block are
+        // connected again from its state roots, or from those of the heads of an interrupted coins flush.
+        // The nodes of the flushed best block are never pruned: on the active chain every block from it up
+        // to the tip is retained, as the next flush may move the best block to any of them.
+        int nFirstHeight = std::max(0, nTipHeight - nKeepBlocks);
+        std::vector<const CBlockIndex *> vRetained;
+        CCoinsView *pcoinsdbview = ifChainObj->GetCoinViewDB();
+        std::vector<uint256> vFlushed = pcoinsdbview->GetHeadBlocks();
+        vFlushed.push_back(pcoinsdbview->GetBestBlock());
+        for (const uint256 &hash : vFlushed)
+        {
+            if (hash.IsNull())
+                continue;
+            const CBlockIndex *pindex = ifChainObj->GetBlockIndex(hash);
+            if (!pindex)
+            {
+                ELogFormat("state pruning skipped, the coins database block %s is not indexed", hash.ToString());
+                dbState.endSweep();
+                dbUTXO.endSweep();
+                return false;
+            }
+            if (chainActive.Contains(pindex))
+                nFirstHeight = std::min(nFirstHeight, pindex->nHeight);
+            else
+                vRetained.push_back(pindex);
+        }
+        // the roots the last nKeepBlocks blocks are disconnected back to are kept as well
+        for (int nHeight = nFirstHeight; nHeight <= nTipHeight; nHeight++)
+            vRetained.push_back(chainActive[nHeight]);
+
+        for (const CBlockIndex *pindex : vRetained)
+        {
+            uint256 hashStateRoot, hashUTXORoot;
+            VM_STATE_ROOT ret = ReadVMStateFromIndex(pindex, hashStateRoot, hashUTXORoot, Params().GetConsensus());
+            if (ret == RET_CONTRACT_UNENBALE)
+                continue;
+            if (ret != RET_VM_STATE_OK)
+            {
+                ELogFormat("state pruning skipped, no state roots for block %s at height %d",
+                           pindex->GetBlockHash().ToString(), pindex->nHeight);
+                dbState.endSweep();
+                dbUTXO.endSweep();
+                return false;
+            }
+            vStateRoots.push_back(uintToh256(hashStateRoot));
+            vUTXORoots.push_back(uintToh256(hashUTXORoot));
+        }
+    }
+
+    size_t nDeleted = 0, nKept = 0;
+    if (!MarkAndSweep(vStateRoots, vUTXORoots, nDeleted, nKept))
+        return false;
+
+    NLogFormat("pruned %u contract state nodes at height %d, kept %u reachable from the last %d blocks (%dms)",
+               nDeleted, nTipHeight, nKept, nKeepBlocks, GetTimeMillis() - nStart);
+    return !fStop;
+}
+
+bool CStatePruner::MarkAndSweep(const std::vector<dev::h256> &vStateRoots, const std::vector<dev::h256> &vUTXORoots,
+                                size_t &nDeleted, size_t &nKept)
+{
+    NodeSet marked, markedAccountNodes, markedUTXO, markedUTXOAccountNodes;
+    bool fMarked = true;
+    for (const dev::h256 &root : vStateRoots)
+        fMarked = fMarked && MarkTrie(dbState, root, true, marked, markedAccountNodes);
+    for (const dev::h256 &root : vUTXORoots)
+        fMarked = fMarked && MarkTrie(dbUTXO, root, false, markedUTXO, markedUTXOAccountNodes);
+
+    nDeleted = 0;
+    nKept = marked.size() + markedAccountNodes.size() + markedUTXO.size();
+    if (fMarked)
+    {
+        nDeleted += Sweep(dbState, marked, markedAccountNodes);
+        nDeleted += Sweep(dbUTXO, markedUTXO, markedUTXOAccountNodes);
+    }
+    dbState.endSweep();
+    dbUTXO.endSweep();
+    return fMarked;
+}
+
+bool CStatePruner::MarkTrie(const dev::OverlayDB &db, const dev::h256 &root, bool fAccounts, NodeSet &marked,
+                            NodeSet &markedAccountNodes)
+{
+    // a node of the account trie identical to a storage node would not have its accounts marked, so
+    // the account trie has a set of its own
+    std::vector<std::pair<dev::h256, bool>> pending(1, std::make_pair(root, fAccounts));
+    size_t nMarked = 0;
+    while (!pending.empty())
+    {
+        dev::h256 hash = pending.back().first;
+        bool fAccountNode = pending.back().second;
+        pending.pop_back();
+        if (!(fAccountNode ? markedAccountNodes : marked).insert(hash).second)
+            continue;
+        if (++nMarked % MARK_CHECK_INTERVAL == 0 && fStop)
+            return false;
+
+        std::string node = db.lookup(hash);
+        if (node.empty())
+        {
+            if (hash == dev::EmptyTrie)
+                continue;
+            // whatever it reaches cannot be told from garbage
+            ELogFormat("state pruning skipped, trie node %s is missing", hash.hex());
+            return false;
+        }
+        MarkNode(dev::RLP(node), fAccountNode, pending, marked);
+    }
+    return true;
+}
+
+void CStatePruner::MarkNode(const dev::RLP &node, bool fAccounts, std::vector<std::pair<dev::h256, bool>> &pending,
+                            NodeSet &marked)
+{
+    if (!node.isList())
+        return;
+
+    dev::bytesConstRef value;
+    if (node.itemCount() == 17)
+    {
+        for (unsigned i = 0; i < 16; i++)
+            MarkChild(node[i], fAccounts, pending, marked);
+        value = node[16].payload();
+    } else if (node.itemCount() == 2)
+    {
+        if (!dev::isLeaf(node))
+        {
+            MarkChild(node[1], fAccounts, pending, marked);
+            return;
+        }
+        value = node[1].payload();
+    }
+
+    // account: nonce, balance, storage root, code hash
+    if (!fAccounts || value.empty())
+        return;
+    dev::RLP account(value);
+    if (!account.isList() || account.itemCount() != 4)
+        return;
+    pending.push_back(std::make_pair(account[2].toHash<dev::h256>(), false));
+    dev::h256 hashCode = account[3].toHash<dev::h256>();
+    if (hashCode != dev::EmptySHA3)
+        marked.insert(hashCode);
+}
+
+void CStatePruner::MarkChild(const dev::RLP &child, bool fAccounts, std::vector<std::pair<dev::h256, bool>> &pending,
+                             NodeSet &marked)
+{
+    // nodes shorter than a hash are kept inline in their parent
+    if (child.isList())
+        MarkNode(child, fAccounts, pending, marked);
+    else if (child.isData() && child.size() == dev::h256::size)
+        pending.push_back(std::make_pair(child.toHash<dev::h256>(), fAccounts));
+}
+
+size_t CStatePruner::Sweep(dev::OverlayDB &db, const NodeSet &marked, const NodeSet &markedAccountNodes)
+{
+    size_t nDeleted = 0;
+    std::vector<dev::h256> vUnmarked;
+    std::unique_ptr<ldb::Iterator> it(db.db()->NewIterator(ldb::ReadOptions()));
+    for (it->SeekToFirst(); it->Valid() && !fStop; it->Next())
+    {
+        // the auxiliary entries, key preimages, are one byte longer and always kept
+        if (it->key().size() != dev::h256::size)
+            continue;
+        dev::h256 hash((byte const *)it->key().data(), dev::h256::ConstructFromPointer);
+        if (marked.count(hash) || markedAccountNodes.count(hash))
+            continue;
+        vUnmarked.push_back(hash);
+        if (vUnmarked.size() >= SWEEP_BATCH_SIZE)
+        {
+            nDeleted += db.sweep(vUnmarked);
+            vUnmarked.clear();
+        }
+    }
+    if (!fStop)
+        nDeleted += db.sweep(vUnmarked);
+    return nDeleted;
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////
+//  statepruner.h
+//  Implementation of the Class CStatePruner
+///////////////////////////////////////////////////////////
+#ifndef SUPERBITCOIN_STATEPRUNER_H
+#define SUPERBITCOIN_STATEPRUNER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "contract/libdevcore/OverlayDB.h"
+#include "contract/libdevcore/RLP.h"
+
+/**
+ * Removes the contract state trie nodes that only the roots of blocks older than the last nKeepBlocks
+ * blocks of the active chain reach. The nodes of the best block of the coins database, and of the heads
+ * of an interrupted coins flush, are never pruned however old: the node restarts from them, and the
+ * active chain blocks from the best block up to the tip are retained along with it.
+ * A cycle marks the nodes reachable from the retained roots, storage tries and code included, then deletes
+ * the other nodes from disk in batches. Both run on the pruner's own thread without cs_main: only taking
+ * the roots and starting the sweep hold it, the nodes are read through disk views, and the databases keep
+ * the nodes that are written while a cycle runs.
+ */
+class CStatePruner
+{
+public:
+    CStatePruner(const dev::OverlayDB &dbState, const dev::OverlayDB &dbUTXO, int nKeepBlocks);
+
+    ~CStatePruner();
+
+    void Start();
+
+    /** Interrupts a running cycle and joins the thread */
+    void Stop();
+
+    int GetKeepBlocks() const
+    {
+        return nKeepBlocks;
+    }
+
+    /**
+     * Deletes the nodes that none of the given roots reach. The sweep has to be begun on both databases,
+     * it is ended here. Returns false if a node reachable from a root is missing, nothing is deleted then,
+     * or if the pruner was stopped.
+     */
+    bool MarkAndSweep(const std::vector<dev::h256> &vStateRoots, const std::vector<dev::h256> &vUTXORoots,
+                      size_t &nDeleted, size_t &nKept);
+
+private:
+    typedef std::unordered_set<dev::h256> NodeSet;
+
+    void ThreadPrune();
+
+    bool PruneCycle();
+
+    /** Marks the trie at root; with fAccounts its leaves are accounts whose storage and code are marked too */
+    bool MarkTrie(const dev::OverlayDB &db, const dev::h256 &root, bool fAccounts, NodeSet &marked,
+                  NodeSet &markedAccountNodes);
+
+    void MarkNode(const dev::RLP &node, bool fAccounts, std::vector<std::pair<dev::h256, bool>> &pending,
+                  NodeSet &marked);
+
+    void MarkChild(const dev::RLP &child, bool fAccounts, std::vector<std::pair<dev::h256, bool>> &pending,
+                   NodeSet &marked);
+
+    /** Deletes the nodes of db that are in neither set, returns how many were */
+    size_t Sweep(dev::OverlayDB &db, const NodeSet &marked, const NodeSet &markedAccountNodes);
+
+    dev::OverlayDB dbState;
+    dev::OverlayDB dbUTXO;
+    const int nKeepBlocks;
+    int nLastPruneHeight;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<bool> fStop;
+};
+
+#endif //SUPERBITCOIN_STATEPRUNER_H
@@ -60,6 +60,13 @@ std::vector<TransactionReceiptInfo> StorageResults::getResult(dev::h256 const &h
     return result;
 }
 
+std::vector<TransactionReceiptInfo> StorageResults::getCommittedResult(dev::h256 const &hashTx)
+{
+    std::vector<TransactionReceiptInfo> result;
+    readResult(hashTx, result);
+    return result;
+}
+
 void StorageResults::commitResults()
 {
     if (m_cache_result.size())
@@ -49,6 +49,9 @@ public:
 
     std::vector<TransactionReceiptInfo> getResult(dev::h256 const &hashTx);
 
+    /// Reads committed results only, bypassing the cache, so it can be used from any thread
+    std::vector<TransactionReceiptInfo> getCommittedResult(dev::h256 const &hashTx);
+
     void commitResults();
 
     void clearCacheResult();
@@ -0,0 +1,201 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file Keccak.cpp
+ * The rounds follow the Keccak team's optimized 64-bit implementation: the 25
+ * lanes live in locals, the steps of a round are fused, and two rounds swap
+ * the A and E sets of locals instead of moving lanes around. The same round
+ * macro is expanded over 64-bit integers and over AVX2 vectors of four lanes.
+ */
+
+#include "Keccak.h"
+
+#if defined(KECCAK_X86)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace dev
+{
+    namespace keccak
+    {
+
+        static const uint64_t c_roundConstants[24] =
+                {0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+                 0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+                 0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+                 0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+                 0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+                 0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL};
+
+        // Chi of plane y from the B lanes into the E lanes. XOR, ROL, ANDN (~a & b) and RC(round) are defined
+        // for the lane type before the expansion.
+#define KECCAK_CHI(E, y)                 \
+        E##y##a = XOR(Ba, ANDN(Be, Bi)); \
+        E##y##e = XOR(Be, ANDN(Bi, Bo)); \
+        E##y##i = XOR(Bi, ANDN(Bo, Bu)); \
+        E##y##o = XOR(Bo, ANDN(Bu, Ba)); \
+        E##y##u = XOR(Bu, ANDN(Ba, Be));
+
+        // One round from the A lanes into the E lanes.
+#define KECCAK_ROUND(A, E, round)                                                       \
+        Ca = XOR(XOR(XOR(A##ba, A##ga), XOR(A##ka, A##ma)), A##sa);                     \
+        Ce = XOR(XOR(XOR(A##be, A##ge), XOR(A##ke, A##me)), A##se);                     \
+        Ci = XOR(XOR(XOR(A##bi, A##gi), XOR(A##ki, A##mi)), A##si);                     \
+        Co = XOR(XOR(XOR(A##bo, A##go), XOR(A##ko, A##mo)), A##so);                     \
+        Cu = XOR(XOR(XOR(A##bu, A##gu), XOR(A##ku, A##mu)), A##su);                     \
+        Da = XOR(Cu, ROL(Ce, 1));                                                       \
+        De = XOR(Ca, ROL(Ci, 1));                                                       \
+        Di = XOR(Ce, ROL(Co, 1));                                                       \
+        Do = XOR(Ci, ROL(Cu, 1));                                                       \
+        Du = XOR(Co, ROL(Ca, 1));                                                       \
+                                                                                        \
+        Ba = XOR(A##ba, Da);                                                            \
+        Be = ROL(XOR(A##ge, De), 44);                                                   \
+        Bi = ROL(XOR(A##ki, Di), 43);                                                   \
+        Bo = ROL(XOR(A##mo, Do), 21);                                                   \
+        Bu = ROL(XOR(A##su, Du), 14);                                                   \
+        KECCAK_CHI(E, b)                                                                \
+        E##ba = XOR(E##ba, RC(round));                                                  \
+                                                                                        \
+        Ba = ROL(XOR(A##bo, Do), 28);                                                   \
+        Be = ROL(XOR(A##gu, Du), 20);                                                   \
+        Bi = ROL(XOR(A##ka, Da), 3);                                                    \
+        Bo = ROL(XOR(A##me, De), 45);                                                   \
+        Bu = ROL(XOR(A##si, Di), 61);                                                   \
+        KECCAK_CHI(E, g)                                                                \
+                                                                                        \
+        Ba = ROL(XOR(A##be, De), 1);                                                    \
+        Be = ROL(XOR(A##gi, Di), 6);                                                    \
+        Bi = ROL(XOR(A##ko, Do), 25);                                                   \
+        Bo = ROL(XOR(A##mu, Du), 8);                                                    \
+        Bu = ROL(XOR(A##sa, Da), 18);                                                   \
+        KECCAK_CHI(E, k)                                                                \
+                                                                                        \
+        Ba = ROL(XOR(A##bu, Du), 27);                                                   \
+        Be = ROL(XOR(A##ga, Da), 36);                                                   \
+        Bi = ROL(XOR(A##ke, De), 10);                                                   \
+        Bo = ROL(XOR(A##mi, Di), 15);                                                   \
+        Bu = ROL(XOR(A##so, Do), 56);                                                   \
+        KECCAK_CHI(E, m)                                                                \
+                                                                                        \
+        Ba = ROL(XOR(A##bi, Di), 62);                                                   \
+        Be = ROL(XOR(A##go, Do), 55);                                                   \
+        Bi = ROL(XOR(A##ku, Du), 39);                                                   \
+        Bo = ROL(XOR(A##ma, Da), 41);                                                   \
+        Bu = ROL(XOR(A##se, De), 2);                                                    \
+        KECCAK_CHI(E, s)
+
+#define KECCAK_LANES(T, P) \
+        T P##ba, P##be, P##bi, P##bo, P##bu, P##ga, P##ge, P##gi, P##go, P##gu, P##ka, P##ke, P##ki, P##ko, P##ku, \
+          P##ma, P##me, P##mi, P##mo, P##mu, P##sa, P##se, P##si, P##so, P##su;
+
+#define KECCAK_LANE_IO(OP)                                                                                  \
+        OP(ba, 0) OP(be, 1) OP(bi, 2) OP(bo, 3) OP(bu, 4) OP(ga, 5) OP(ge, 6) OP(gi, 7) OP(go, 8) OP(gu, 9) \
+        OP(ka, 10) OP(ke, 11) OP(ki, 12) OP(ko, 13) OP(ku, 14) OP(ma, 15) OP(me, 16) OP(mi, 17) OP(mo, 18) \
+        OP(mu, 19) OP(sa, 20) OP(se, 21) OP(si, 22) OP(so, 23) OP(su, 24)
+
+#define KECCAK_PERMUTE(T)                                  \
+        KECCAK_LANES(T, A)                                 \
+        KECCAK_LANES(T, E)                                 \
+        T Ba, Be, Bi, Bo, Bu, Ca, Ce, Ci, Co, Cu, Da, De, Di, Do, Du; \
+        KECCAK_LANE_IO(LOAD)                               \
+        for (int round = 0; round < 24; round += 2)        \
+        {                                                  \
+            KECCAK_ROUND(A, E, round)                      \
+            KECCAK_ROUND(E, A, round + 1)                  \
+        }                                                  \
+        KECCAK_LANE_IO(STORE)
+
+#define XOR(a, b) ((a) ^ (b))
+#define ROL(a, n) (((a) << (n)) | ((a) >> (64 - (n))))
+#define ANDN(a, b) (~(a) & (b))
+#define RC(round) c_roundConstants[round]
+#define LOAD(lane, i) A##lane = _state[i];
+#define STORE(lane, i) _state[i] = A##lane;
+
+        static inline __attribute__((always_inline)) void permuteLanes(uint64_t *_state)
+        {
+            KECCAK_PERMUTE(uint64_t)
+        }
+
+        void keccakfUnrolled(uint64_t *_state)
+        {
+            permuteLanes(_state);
+        }
+
+#if defined(KECCAK_X86)
+        // The compiler emits ANDN for ~a & b and RORX for the rotations.
+        __attribute__((target("bmi,bmi2"))) void keccakfBMI2(uint64_t *_state)
+        {
+            permuteLanes(_state);
+        }
+
+#undef XOR
+#undef ROL
+#undef ANDN
+#undef RC
+#undef LOAD
+#undef STORE
+
+#define XOR(a, b) _mm256_xor_si256(a, b)
+#define ROL(a, n) _mm256_or_si256(_mm256_slli_epi64(a, n), _mm256_srli_epi64(a, 64 - (n)))
+#define ANDN(a, b) _mm256_andnot_si256(a, b)
+#define RC(round) _mm256_set1_epi64x((long long)c_roundConstants[round])
+#define LOAD(lane, i) A##lane = _mm256_loadu_si256((__m256i const *)(_states + 4 * i));
+#define STORE(lane, i) _mm256_storeu_si256((__m256i *)(_states + 4 * i), A##lane);
+
+        __attribute__((target("avx2"))) void keccakfAVX2x4(uint64_t *_states)
+        {
+            KECCAK_PERMUTE(__m256i)
+        }
+
+        bool cpuHasBMI2()
+        {
+            uint32_t eax, ebx, ecx, edx;
+            if (__get_cpuid_max(0, nullptr) < 7)
+                return false;
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            // BMI1 for ANDN, BMI2 for RORX
+            return (ebx >> 3 & 1) && (ebx >> 8 & 1);
+        }
+
+        bool cpuHasAVX2()
+        {
+            uint32_t eax, ebx, ecx, edx;
+            if (__get_cpuid_max(0, nullptr) < 7 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+                return false;
+            // the OS has to save the YMM registers: OSXSAVE, then XCR0 with the SSE and AVX state bits
+            if (!(ecx >> 27 & 1) || !(ecx >> 28 & 1))
+                return false;
+            uint32_t xcr0, xcr0High;
+            __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+            if ((xcr0 & 6) != 6)
+                return false;
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            return ebx >> 5 & 1;
+        }
+#endif
+
+#undef XOR
+#undef ROL
+#undef ANDN
+#undef RC
+#undef LOAD
+#undef STORE
+
+    }
+}
@@ -0,0 +1,54 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file Keccak.h
+ * Keccak-f[1600] permutations for the CPU features SHA3.cpp selects between.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace dev
+{
+    namespace keccak
+    {
+
+        /// Keccak-f[1600] over the 25 lanes of one state.
+        typedef void (*Permutation)(uint64_t *_state);
+
+        /// Keccak-f[1600] over four states at once, lane i of state j at _states[4 * i + j].
+        typedef void (*Permutation4)(uint64_t *_states);
+
+        /// Unrolled, with the lanes kept in registers.
+        void keccakfUnrolled(uint64_t *_state);
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__amd64__))
+#define KECCAK_X86 1
+
+        /// keccakfUnrolled compiled for BMI1/BMI2: ANDN for chi, RORX for the rotations.
+        void keccakfBMI2(uint64_t *_state);
+
+        /// Four states in the 64-bit elements of AVX2 registers.
+        void keccakfAVX2x4(uint64_t *_states);
+
+        bool cpuHasBMI2();
+
+        bool cpuHasAVX2();
+#endif
+
+    }
+}
@@ -95,6 +95,7 @@ namespace dev
 #if DEV_GUARDED_DB
         WriteGuard l(x_this);
 #endif
+        journalMain(_h);
         auto it = m_main.find(_h);
         if (it != m_main.end())
         {
@@ -116,6 +117,7 @@ namespace dev
         {
             if (m_main[_h].second > 0)
             {
+                journalMain(_h);
                 m_main[_h].second--;
                 return true;
             }
@@ -152,6 +154,7 @@ namespace dev
 #if DEV_GUARDED_DB
         WriteGuard l(x_this);
 #endif
+        journalAux(_h);
         m_aux[_h].second = false;
     }
 
@@ -160,6 +163,7 @@ namespace dev
 #if DEV_GUARDED_DB
         WriteGuard l(x_this);
 #endif
+        journalAux(_h);
         m_aux[_h] = make_pair(_v.toBytes(), true);
     }
 
@@ -183,6 +187,80 @@ namespace dev
                 it = m_aux.erase(it);
     }
 
+    void MemoryDB::journalMain(h256 const &_h)
+    {
+        if (m_layers.empty())
+            return;
+        auto it = m_main.find(_h);
+        if (it == m_main.end())
+            m_journal.push_back(LayerChange{_h, false, false, 0, {}});
+        else
+            m_journal.push_back(LayerChange{_h, false, true, it->second.second, {}});
+    }
+
+    void MemoryDB::journalAux(h256 const &_h)
+    {
+        if (m_layers.empty())
+            return;
+        auto it = m_aux.find(_h);
+        if (it == m_aux.end())
+            m_journal.push_back(LayerChange{_h, true, false, 0, {}});
+        else
+            m_journal.push_back(LayerChange{_h, true, true, 0, it->second});
+    }
+
+    void MemoryDB::pushLayer()
+    {
+#if DEV_GUARDED_DB
+        WriteGuard l(x_this);
+#endif
+        m_layers.push_back(m_journal.size());
+    }
+
+    void MemoryDB::mergeLayer()
+    {
+#if DEV_GUARDED_DB
+        WriteGuard l(x_this);
+#endif
+        if (m_layers.empty())
+            return;
+        m_layers.pop_back();
+        if (m_layers.empty())
+            m_journal.clear();
+    }
+
+    void MemoryDB::discardLayer()
+    {
+#if DEV_GUARDED_DB
+        WriteGuard l(x_this);
+#endif
+        if (m_layers.empty())
+            return;
+        for (size_t i = m_journal.size(); i > m_layers.back(); --i)
+        {
+            LayerChange &c = m_journal[i - 1];
+            if (c.aux)
+            {
+                if (c.existed)
+                    m_aux[c.key] = std::move(c.auxValue);
+                else
+                    m_aux.erase(c.key);
+            } else
+            {
+                if (!c.existed)
+                    m_main.erase(c.key);
+                else
+                {
+                    auto it = m_main.find(c.key);
+                    if (it != m_main.end())
+                        it->second.second = c.refCount;
+                }
+            }
+        }
+        m_journal.resize(m_layers.back());
+        m_layers.pop_back();
+    }
+
     h256Hash MemoryDB::keys() const
     {
 #if DEV_GUARDED_DB
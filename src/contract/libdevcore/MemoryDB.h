@@ -69,6 +69,8 @@ namespace dev
         {
             m_main.clear();
             m_aux.clear();
+            m_journal.clear();
+            m_layers.clear();
         }    // WARNING !!!! didn't originally clear m_refCount!!!
         std::unordered_map<h256, std::string> get() const;
 
@@ -90,12 +92,45 @@ namespace dev
 
         h256Hash keys() const;
 
+        /// Opens a layer: changes made from now on can be dropped again with discardLayer(), in
+        /// O(entries touched) and without losing what the enclosing layers wrote. Layers nest.
+        /// purge() must not be called while a layer is open.
+        void pushLayer();
+
+        /// Keeps the changes of the innermost layer, they now belong to the enclosing one.
+        void mergeLayer();
+
+        /// Reverts the changes of the innermost layer.
+        void discardLayer();
+
+        size_t layers() const
+        {
+            return m_layers.size();
+        }
+
     protected:
+        /// State of an entry before a change made inside a layer. Keys of m_main address their
+        /// content, so only the reference count has to be remembered for them.
+        struct LayerChange
+        {
+            h256 key;
+            bool aux;
+            bool existed;
+            unsigned refCount;
+            std::pair<bytes, bool> auxValue;
+        };
+
+        void journalMain(h256 const &_h);
+
+        void journalAux(h256 const &_h);
+
 #if DEV_GUARDED_DB
         mutable SharedMutex x_this;
 #endif
         std::unordered_map<h256, std::pair<std::string, unsigned>> m_main;
         std::unordered_map<h256, std::pair<bytes, bool>> m_aux;
+        std::vector<LayerChange> m_journal;
+        std::vector<size_t> m_layers;
 
         mutable bool m_enforceRefs = false;
     };
@@ -0,0 +1,98 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file NodeCache.cpp
+ */
+
+#include "NodeCache.h"
+
+using namespace std;
+using namespace dev;
+
+namespace dev
+{
+
+    // list node, index node and string header of an entry, next to its key and value
+    static const size_t c_entryOverhead = 128;
+
+    static size_t entryMemoryUsage(h256 const &_h, std::string const &_v)
+    {
+        return _h.size + _v.size() + c_entryOverhead;
+    }
+
+    std::string NodeCache::lookup(h256 const &_h)
+    {
+        Guard l(x_cache);
+        auto it = m_index.find(_h);
+        if (it == m_index.end())
+        {
+            ++m_misses;
+            return std::string();
+        }
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->second;
+    }
+
+    void NodeCache::insert(h256 const &_h, std::string const &_v)
+    {
+        size_t usage = entryMemoryUsage(_h, _v);
+        if (_v.empty() || usage > m_maxMemoryUsage)
+            return;
+        Guard l(x_cache);
+        auto it = m_index.find(_h);
+        if (it != m_index.end())
+        {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return;
+        }
+        while (!m_entries.empty() && m_memoryUsage + usage > m_maxMemoryUsage)
+            eraseEntry(std::prev(m_entries.end()));
+        m_entries.emplace_front(_h, _v);
+        m_index.emplace(_h, m_entries.begin());
+        m_memoryUsage += usage;
+    }
+
+    void NodeCache::erase(h256 const &_h)
+    {
+        Guard l(x_cache);
+        auto it = m_index.find(_h);
+        if (it != m_index.end())
+            eraseEntry(it->second);
+    }
+
+    void NodeCache::clear()
+    {
+        Guard l(x_cache);
+        m_entries.clear();
+        m_index.clear();
+        m_memoryUsage = 0;
+    }
+
+    NodeCache::Stats NodeCache::stats() const
+    {
+        Guard l(x_cache);
+        return Stats{m_index.size(), m_memoryUsage, m_maxMemoryUsage, m_hits, m_misses};
+    }
+
+    void NodeCache::eraseEntry(Entries::iterator _it)
+    {
+        m_memoryUsage -= entryMemoryUsage(_it->first, _it->second);
+        m_index.erase(_it->first);
+        m_entries.erase(_it);
+    }
+
+}
@@ -0,0 +1,77 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file NodeCache.h
+ * Least recently used cache of trie nodes read from the state databases.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "FixedHash.h"
+#include "Guards.h"
+
+namespace dev
+{
+
+    /// Bounded cache of trie nodes by hash, evicting the least recently used ones past its memory
+    /// budget. A node's key is the hash of its content, so one cache serves any number of databases
+    /// and overlays, and entries never go stale. Thread safe.
+    class NodeCache
+    {
+    public:
+        struct Stats
+        {
+            size_t entries;
+            size_t memoryUsage;
+            size_t maxMemoryUsage;
+            uint64_t hits;
+            uint64_t misses;
+        };
+
+        explicit NodeCache(size_t _maxMemoryUsage) : m_maxMemoryUsage(_maxMemoryUsage)
+        {
+        }
+
+        /// The node, or an empty string if it is not cached.
+        std::string lookup(h256 const &_h);
+
+        void insert(h256 const &_h, std::string const &_v);
+
+        /// Drops a node that has been deleted from its database.
+        void erase(h256 const &_h);
+
+        void clear();
+
+        Stats stats() const;
+
+    private:
+        using Entries = std::list<std::pair<h256, std::string>>;
+
+        void eraseEntry(Entries::iterator _it);
+
+        mutable Mutex x_cache;
+        Entries m_entries;    ///< Most recently used first.
+        std::unordered_map<h256, Entries::iterator> m_index;
+        size_t m_memoryUsage = 0;
+        size_t const m_maxMemoryUsage;
+        uint64_t m_hits = 0;
+        uint64_t m_misses = 0;
+    };
+
+}
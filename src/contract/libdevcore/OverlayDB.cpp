@@ -52,56 +52,147 @@ namespace dev
         }
     };
 
+    // hash map node and string headers of a staged entry, next to its key and value
+    static const size_t c_stagedEntryOverhead = 64;
+
     void OverlayDB::commit()
     {
-        if (m_db)
-        {
-            ldb::WriteBatch batch;
-            //		cnote << "Committing nodes to disk DB:";
+        // the nodes written inside a layer stay in memory until it is merged into the base or discarded
+        if (layers())
+            return;
+        stage();
+        flush();
+    }
+
+    void OverlayDB::stage()
+    {
+        if (layers() || !m_db)
+            return;
 #if DEV_GUARDED_DB
-            DEV_READ_GUARDED(x_this)
+        DEV_WRITE_GUARDED(x_this)
 #endif
-            {
-                for (auto const &i: m_main)
+        {
+            WriteGuard l(m_staged->x_nodes);
+            // keys of the main nodes address their content, one already staged is the same node
+            for (auto &i: m_main)
+                if (i.second.second)
+                {
+                    auto r = m_staged->main.emplace(i.first, std::move(i.second.first));
+                    if (r.second)
+                        m_staged->memoryUsage += i.first.size + r.first->second.size() + c_stagedEntryOverhead;
+                }
+            for (auto &i: m_aux)
+                if (i.second.second)
                 {
-                    if (i.second.second)
-                        batch.Put(ldb::Slice((char const *)i.first.data(), i.first.size),
-                                  ldb::Slice(i.second.first.data(), i.second.first.size()));
-                    //				cnote << i.first << "#" << m_main[i.first].second;
+                    auto it = m_staged->aux.find(i.first);
+                    if (it == m_staged->aux.end())
+                        m_staged->memoryUsage += i.first.size + c_stagedEntryOverhead;
+                    else
+                        m_staged->memoryUsage -= it->second.size();
+                    m_staged->memoryUsage += i.second.first.size();
+                    m_staged->aux[i.first] = std::move(i.second.first);
                 }
-                for (auto const &i: m_aux)
-                    if (i.second.second)
-                    {
-                        bytes b = i.first.asBytes();
-                        b.push_back(255);    // for aux
-                        batch.Put(bytesConstRef(&b), bytesConstRef(&i.second.first));
-                    }
+            m_aux.clear();
+            m_main.clear();
+        }
+    }
+
+    void OverlayDB::flush()
+    {
+        if (!m_db)
+            return;
+        Guard w(m_sweep->x_write);
+        ldb::WriteBatch batch;
+        {
+            ReadGuard l(m_staged->x_nodes);
+            if (m_staged->main.empty() && m_staged->aux.empty())
+                return;
+            //		cnote << "Committing nodes to disk DB:";
+            for (auto const &i: m_staged->main)
+            {
+                batch.Put(ldb::Slice((char const *)i.first.data(), i.first.size),
+                          ldb::Slice(i.second.data(), i.second.size()));
+                if (m_sweep->sweeping)
+                    m_sweep->written.insert(i.first);
+            }
+            for (auto const &i: m_staged->aux)
+            {
+                bytes b = i.first.asBytes();
+                b.push_back(255);    // for aux
+                batch.Put(bytesConstRef(&b), bytesConstRef(&i.second));
             }
+        }
 
-            for (unsigned i = 0; i < 10; ++i)
+        for (unsigned i = 0; i < 10; ++i)
+        {
+            ldb::Status o = m_db->Write(m_writeOptions, &batch);
+            if (o.ok())
+                break;
+            if (i == 9)
             {
-                ldb::Status o = m_db->Write(m_writeOptions, &batch);
-                if (o.ok())
-                    break;
-                if (i == 9)
-                {
-                    cwarn << "Fail writing to state database. Bombing out.";
-                    exit(-1);
-                }
-                cwarn << "Error writing to state database: " << o.ToString();
-                WriteBatchNoter n;
-                batch.Iterate(&n);
-                cwarn << "Sleeping for" << (i + 1) << "seconds, then retrying.";
-                this_thread::sleep_for(chrono::seconds(i + 1));
+                cwarn << "Fail writing to state database. Bombing out.";
+                exit(-1);
             }
-#if DEV_GUARDED_DB
-            DEV_WRITE_GUARDED(x_this)
-#endif
+            cwarn << "Error writing to state database: " << o.ToString();
+            WriteBatchNoter n;
+            batch.Iterate(&n);
+            cwarn << "Sleeping for" << (i + 1) << "seconds, then retrying.";
+            this_thread::sleep_for(chrono::seconds(i + 1));
+        }
+
+        // only dropped once on disk, a disk view that misses a node here finds it there
+        WriteGuard l(m_staged->x_nodes);
+        m_staged->main.clear();
+        m_staged->aux.clear();
+        m_staged->memoryUsage = 0;
+    }
+
+    size_t OverlayDB::stagedMemoryUsage() const
+    {
+        ReadGuard l(m_staged->x_nodes);
+        return m_staged->memoryUsage;
+    }
+
+    void OverlayDB::beginSweep()
+    {
+        Guard w(m_sweep->x_write);
+        m_sweep->sweeping = true;
+        m_sweep->written.clear();
+    }
+
+    size_t OverlayDB::sweep(std::vector<h256> const &_keys)
+    {
+        if (!m_db)
+            return 0;
+        Guard w(m_sweep->x_write);
+        ldb::WriteBatch batch;
+        size_t deleted = 0;
+        for (auto const &h: _keys)
+            if (!m_sweep->written.count(h))
             {
-                m_aux.clear();
-                m_main.clear();
+                batch.Delete(ldb::Slice((char const *)h.data(), h.size));
+                ++deleted;
             }
+        if (!deleted)
+            return 0;
+        ldb::Status o = m_db->Write(m_writeOptions, &batch);
+        if (!o.ok())
+        {
+            cwarn << "Error deleting from state database: " << o.ToString();
+            return 0;
         }
+        if (m_nodeCache)
+            for (auto const &h: _keys)
+                if (!m_sweep->written.count(h))
+                    m_nodeCache->erase(h);
+        return deleted;
+    }
+
+    void OverlayDB::endSweep()
+    {
+        Guard w(m_sweep->x_write);
+        m_sweep->sweeping = false;
+        m_sweep->written.clear();
     }
 
     bytes OverlayDB::lookupAux(h256 const &_h) const
@@ -109,6 +200,12 @@ namespace dev
         bytes ret = MemoryDB::lookupAux(_h);
         if (!ret.empty() || !m_db)
             return ret;
+        {
+            ReadGuard l(m_staged->x_nodes);
+            auto it = m_staged->aux.find(_h);
+            if (it != m_staged->aux.end())
+                return it->second;
+        }
         std::string v;
         bytes b = _h.asBytes();
         b.push_back(255);    // for aux
@@ -118,19 +215,46 @@ namespace dev
         return asBytes(v);
     }
 
+    OverlayDB OverlayDB::diskView() const
+    {
+        OverlayDB ret;
+        ret.m_db = m_db;
+        ret.m_staged = m_staged;
+        ret.m_sweep = m_sweep;
+        ret.m_nodeCache = m_nodeCache;
+        return ret;
+    }
+
     void OverlayDB::rollback()
     {
 #if DEV_GUARDED_DB
         WriteGuard l(x_this);
 #endif
         m_main.clear();
+        m_journal.clear();
+        m_layers.clear();
     }
 
     std::string OverlayDB::lookup(h256 const &_h) const
     {
         std::string ret = MemoryDB::lookup(_h);
-        if (ret.empty() && m_db)
-            m_db->Get(m_readOptions, ldb::Slice((char const *)_h.data(), 32), &ret);
+        if (!ret.empty() || !m_db)
+            return ret;
+        {
+            ReadGuard l(m_staged->x_nodes);
+            auto it = m_staged->main.find(_h);
+            if (it != m_staged->main.end())
+                return it->second;
+        }
+        if (m_nodeCache)
+        {
+            ret = m_nodeCache->lookup(_h);
+            if (!ret.empty())
+                return ret;
+        }
+        m_db->Get(m_readOptions, ldb::Slice((char const *)_h.data(), 32), &ret);
+        if (m_nodeCache)
+            m_nodeCache->insert(_h, ret);
         return ret;
     }
 
@@ -138,6 +262,12 @@ namespace dev
     {
         if (MemoryDB::exists(_h))
             return true;
+        if (m_db)
+        {
+            ReadGuard l(m_staged->x_nodes);
+            if (m_staged->main.count(_h))
+                return true;
+        }
         std::string ret;
         if (m_db)
             m_db->Get(m_readOptions, ldb::Slice((char const *)_h.data(), 32), &ret);
@@ -149,9 +279,7 @@ namespace dev
 #if ETH_PARANOIA || 1
         if (!MemoryDB::kill(_h))
         {
-            std::string ret;
-            if (m_db)
-                m_db->Get(m_readOptions, ldb::Slice((char const *)_h.data(), 32), &ret);
+            std::string ret = m_db ? lookup(_h) : std::string();
             // No point node ref decreasing for EmptyTrie since we never bother incrementing it in the first place for
             // empty storage tries.
             if (ret.empty() && _h != EmptyTrie)
@@ -170,6 +298,17 @@ namespace dev
         kill(_h);
 
         //kill in overlayDB
+        {
+            WriteGuard l(m_staged->x_nodes);
+            auto it = m_staged->main.find(_h);
+            if (it != m_staged->main.end())
+            {
+                m_staged->memoryUsage -= _h.size + it->second.size() + c_stagedEntryOverhead;
+                m_staged->main.erase(it);
+            }
+        }
+        if (m_nodeCache)
+            m_nodeCache->erase(_h);
         ldb::Status s = m_db->Delete(m_writeOptions, ldb::Slice((char const *)_h.data(), 32));
         if (s.ok())
             return true;
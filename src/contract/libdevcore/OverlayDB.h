@@ -22,10 +22,13 @@
 #pragma once
 
 #include <memory>
+#include <unordered_set>
 #include <libdevcore/db.h>
 #include <libdevcore/Common.h>
 #include <libdevcore/Log.h>
 #include <libdevcore/MemoryDB.h>
+#include <libdevcore/Guards.h>
+#include <libdevcore/NodeCache.h>
 
 namespace dev
 {
@@ -33,7 +36,8 @@ namespace dev
     class OverlayDB : public MemoryDB
     {
     public:
-        OverlayDB(ldb::DB *_db = nullptr) : m_db(_db)
+        OverlayDB(ldb::DB *_db = nullptr) : m_db(_db), m_staged(std::make_shared<StagedNodes>()),
+                                           m_sweep(std::make_shared<SweepState>())
         {
         }
 
@@ -44,8 +48,28 @@ namespace dev
             return m_db.get();
         }
 
+        /// Writes the referenced nodes to disk, with whatever was staged before.
         void commit();
 
+        /// Moves the referenced nodes into a store that is kept in memory until flush(), so the writes of
+        /// many commits end up in one batch. Staged nodes read like committed ones, also through diskView().
+        void stage();
+
+        /// Writes the staged nodes to disk in one batch.
+        void flush();
+
+        /// Approximate memory held by the staged nodes, in bytes.
+        size_t stagedMemoryUsage() const;
+
+        /// From now on, remembers the nodes flush() writes so that sweep() leaves them on disk.
+        void beginSweep();
+
+        /// Deletes the given nodes from disk in one batch, except those written since beginSweep().
+        /// Returns how many were deleted.
+        size_t sweep(std::vector<h256> const &_keys);
+
+        void endSweep();
+
         void rollback();
 
         std::string lookup(h256 const &_h) const;
@@ -58,10 +82,41 @@ namespace dev
 
         bytes lookupAux(h256 const &_h) const;
 
+        /// Keeps the nodes read from disk in the given cache, which may be shared with other overlays.
+        /// The disk views made afterwards use it too.
+        void setNodeCache(std::shared_ptr<NodeCache> const &_cache)
+        {
+            m_nodeCache = _cache;
+        }
+
+        /// Another overlay on the same disk database, with nothing in memory. What it reads is what
+        /// has been committed or staged, so it can be used from another thread. Never commit through it.
+        OverlayDB diskView() const;
+
     private:
         using MemoryDB::clear;
 
+        /// Written by the owner of the database, read by its disk views from other threads.
+        struct StagedNodes
+        {
+            mutable SharedMutex x_nodes;
+            std::unordered_map<h256, std::string> main;
+            std::unordered_map<h256, bytes> aux;
+            size_t memoryUsage = 0;
+        };
+
+        /// Orders the writes of flush() with the deletes of sweep().
+        struct SweepState
+        {
+            Mutex x_write;
+            bool sweeping = false;
+            std::unordered_set<h256> written;
+        };
+
         std::shared_ptr<ldb::DB> m_db;
+        std::shared_ptr<StagedNodes> m_staged;
+        std::shared_ptr<SweepState> m_sweep;
+        std::shared_ptr<NodeCache> m_nodeCache;
 
         ldb::ReadOptions m_readOptions;
         ldb::WriteOptions m_writeOptions;
@@ -20,10 +20,12 @@
  */
 
 #include "SHA3.h"
+#include <cassert>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include "Keccak.h"
 #include "RLP.h"
 #include "picosha2.h"
 
@@ -156,7 +158,16 @@ namespace dev
         mkapply_ds(xorin, dst[i] ^= src[i])  // xorin
         mkapply_sd(setout, dst[i] = src[i])  // setout
 
-#define P keccakf
+        static void keccakfStandard(uint64_t *_state)
+        {
+            keccakf(_state);
+        }
+
+        // selected by sha3AutoDetect(), the 4-way one is null when there is none
+        static Permutation s_keccakf = keccakfStandard;
+        static Permutation4 s_keccakf4 = nullptr;
+
+#define P(a) s_keccakf((uint64_t *)a)
 #define Plen 200
 
         // Fold P*F over the full blocks of an input.
@@ -177,7 +188,7 @@ namespace dev
             {
                 return -1;
             }
-            uint8_t a[Plen] = {0};
+            alignas(8) uint8_t a[Plen] = {0};
             // Absorb input.
             foldP(in, inlen, xorin);
             // Xor in the DS and pad frame.
@@ -223,6 +234,76 @@ namespace dev
 
         defsha3(512)
 
+        static const size_t c_rate256 = 200 - 256 / 4;
+
+        static inline void xorLanes4(uint64_t *_states, unsigned _j, const uint8_t *_block)
+        {
+            for (unsigned i = 0; i < c_rate256 / 8; ++i)
+            {
+                uint64_t lane;
+                memcpy(&lane, _block + 8 * i, 8);
+                _states[4 * i + _j] ^= lane;
+            }
+        }
+
+        /// sha3_256 of four inputs in step, each permutation of s_keccakf4 advancing all of them.
+        static void sha3_256x4(bytesConstRef const *_inputs, h256 *o_outputs)
+        {
+            alignas(32) uint64_t a[4 * 25] = {0};
+            size_t blocks[4];
+            size_t maxBlocks = 0;
+            for (unsigned j = 0; j < 4; ++j)
+            {
+                blocks[j] = _inputs[j].size() / c_rate256 + 1;
+                maxBlocks = std::max(maxBlocks, blocks[j]);
+            }
+            for (size_t b = 0; b < maxBlocks; ++b)
+            {
+                for (unsigned j = 0; j < 4; ++j)
+                {
+                    if (b + 1 < blocks[j])
+                        xorLanes4(a, j, _inputs[j].data() + b * c_rate256);
+                    else if (b + 1 == blocks[j])
+                    {
+                        uint8_t last[c_rate256] = {0};
+                        size_t len = _inputs[j].size() - b * c_rate256;
+                        if (len)
+                            memcpy(last, _inputs[j].data() + b * c_rate256, len);
+                        last[len] ^= 0x01;
+                        last[c_rate256 - 1] ^= 0x80;
+                        xorLanes4(a, j, last);
+                    }
+                }
+                // finished states go on being permuted, their digests are already out
+                s_keccakf4(a);
+                for (unsigned j = 0; j < 4; ++j)
+                    if (b + 1 == blocks[j])
+                        for (unsigned i = 0; i < 4; ++i)
+                            memcpy(o_outputs[j].data() + 8 * i, &a[4 * i + j], 8);
+            }
+        }
+
+        static bool selfTest()
+        {
+            // the empty string, "abc", and 200 bytes of 0xa3 which take two blocks
+            static const std::string c_expected[3] = {
+                    "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470",
+                    "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45",
+                    "3a57666b048777f2c953dc4456f45a2588e1cb6f2da760122d530ac2ce607d4a"};
+            std::string abc = "abc";
+            bytes a3(200, 0xa3);
+            bytesConstRef inputs[4] = {bytesConstRef(), bytesConstRef(abc), bytesConstRef(&a3), bytesConstRef()};
+            h256 outputs[4];
+            for (unsigned i = 0; i < 4; ++i)
+                if (sha3(inputs[i]) != h256(c_expected[i % 3]))
+                    return false;
+            sha3(inputs, outputs, 4);
+            for (unsigned i = 0; i < 4; ++i)
+                if (outputs[i] != h256(c_expected[i % 3]))
+                    return false;
+            return true;
+        }
+
     }
 
     bool sha3(bytesConstRef _input, bytesRef o_output)
@@ -235,4 +316,52 @@ namespace dev
         return true;
     }
 
+    void sha3(bytesConstRef const *_inputs, h256 *o_outputs, size_t _count)
+    {
+        size_t i = 0;
+        if (keccak::s_keccakf4)
+            for (; i + 4 <= _count; i += 4)
+                keccak::sha3_256x4(_inputs + i, o_outputs + i);
+        for (; i < _count; ++i)
+            o_outputs[i] = sha3(_inputs[i]);
+    }
+
+    bool sha3UseImplementation(std::string const &_name)
+    {
+        keccak::Permutation f = nullptr;
+        keccak::Permutation4 f4 = nullptr;
+        if (_name == "standard")
+            f = keccak::keccakfStandard;
+        else if (_name == "unrolled")
+            f = keccak::keccakfUnrolled;
+#if defined(KECCAK_X86)
+        else if (_name == "bmi2" && keccak::cpuHasBMI2())
+            f = keccak::keccakfBMI2;
+        else if (_name == "avx2" && keccak::cpuHasAVX2())
+        {
+            f = keccak::cpuHasBMI2() ? keccak::keccakfBMI2 : keccak::keccakfUnrolled;
+            f4 = keccak::keccakfAVX2x4;
+        }
+#endif
+        if (!f)
+            return false;
+        keccak::s_keccakf = f;
+        keccak::s_keccakf4 = f4;
+        return true;
+    }
+
+    std::string sha3AutoDetect()
+    {
+        std::string name = "unrolled";
+#if defined(KECCAK_X86)
+        if (keccak::cpuHasAVX2())
+            name = "avx2";
+        else if (keccak::cpuHasBMI2())
+            name = "bmi2";
+#endif
+        sha3UseImplementation(name);
+        assert(keccak::selfTest());
+        return name;
+    }
+
 }
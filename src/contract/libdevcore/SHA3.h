@@ -44,6 +44,17 @@ namespace dev
         return ret;
     }
 
+    /// Calculate the SHA3-256 hashes of _count inputs into o_outputs, several at a time where the CPU allows.
+    void sha3(bytesConstRef const *_inputs, h256 *o_outputs, size_t _count);
+
+    /// Select the fastest Keccak-f[1600] implementation the CPU supports and check it against known answers.
+    /// @returns its name: "unrolled", "bmi2" or "avx2" (bmi2 or unrolled, with 4-way AVX2 for batches).
+    std::string sha3AutoDetect();
+
+    /// Select the named implementation, "standard" being the portable one. For tests and benchmarks.
+    /// @returns false if it is unknown or the CPU does not support it.
+    bool sha3UseImplementation(std::string const &_name);
+
     inline SecureFixedHash<32> sha3Secure(bytesConstRef _input)
     {
         SecureFixedHash<32> ret;
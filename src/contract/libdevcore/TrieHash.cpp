@@ -96,8 +96,9 @@ namespace dev
 #endif
             } else
             {
-                // otherwise enumerate all 16+1 entries.
+                // otherwise enumerate all 16+1 entries, the children that are not inlined hashed together.
                 _rlp.appendList(17);
+                RLPStream children[16];
                 auto b = _begin;
                 if (_preLen == b->first.size())
                 {
@@ -107,24 +108,37 @@ namespace dev
 #endif
                     ++b;
                 }
+                bytesConstRef hashed[16];
+                h256 hashes[16];
+                unsigned hashedCount = 0;
                 for (auto i = 0; i < 16; ++i)
                 {
                     auto n = b;
                     for (; n != _end && n->first[_preLen] == i; ++n)
                     {
                     }
-                    if (b == n)
-                        _rlp << "";
-                    else
+                    if (b != n)
                     {
 #if ENABLE_DEBUG_PRINT
                         if (g_hashDebug)
                             std::cerr << s_indent << std::hex << i << ": " << std::dec << std::endl;
 #endif
-                        hash256aux(_s, b, n, _preLen + 1, _rlp);
+                        hash256rlp(_s, b, n, _preLen + 1, children[i]);
+                        if (children[i].out().size() >= 32)
+                            hashed[hashedCount++] = bytesConstRef(&children[i].out());
                     }
                     b = n;
                 }
+                sha3(hashed, hashes, hashedCount);
+                for (unsigned i = 0, h = 0; i < 16; ++i)
+                {
+                    if (children[i].out().empty())
+                        _rlp << "";
+                    else if (children[i].out().size() < 32)
+                        _rlp.APPEND_CHILD(children[i].out());
+                    else
+                        _rlp << hashes[h++];
+                }
                 if (_preLen == _begin->first.size())
                     _rlp << _begin->second;
                 else
@@ -34,19 +34,6 @@ uint64_t VM::memNeed(u256 _offset, u256 _size)
     return toInt63(_size ? u512(_offset) + _size : u512(0));
 }
 
-template<class S>
-S divWorkaround(S const &_a, S const &_b)
-{
-    return (S)(s512(_a) / s512(_b));
-}
-
-template<class S>
-S modWorkaround(S const &_a, S const &_b)
-{
-    return (S)(s512(_a) % s512(_b));
-}
-
-
 //
 // for decoding destinations of JUMPTO, JUMPV, JUMPSUB and JUMPSUBV
 //
@@ -400,7 +387,7 @@ void VM::interpretCases()
                     updateIOGas();
 
                     u256 base = *m_SP--;
-                    *m_SP = exp256(base, expon);
+                    *m_SP = arith::exp(base, expon);
                 }
                 NEXT
 
@@ -414,7 +401,7 @@ void VM::interpretCases()
                     updateIOGas();
 
                     //pops two items and pushes S[-1] + S[-2] mod 2^256.
-                    *(m_SP - 1) += *m_SP;
+                    *(m_SP - 1) = arith::add(*(m_SP - 1), *m_SP);
                     --m_SP;
                 }
                 NEXT
@@ -428,7 +415,7 @@ void VM::interpretCases()
 #if EVM_HACK_MUL_64
                     *(uint64_t*)(m_SP - 1) *= *(uint64_t*)m_SP;
 #else
-                    *(m_SP - 1) *= *m_SP;
+                    *(m_SP - 1) = arith::mul(*(m_SP - 1), *m_SP);
 #endif
                     --m_SP;
                 }
@@ -439,7 +426,7 @@ void VM::interpretCases()
                     ON_OP();
                     updateIOGas();
 
-                    *(m_SP - 1) = *m_SP - *(m_SP - 1);
+                    *(m_SP - 1) = arith::sub(*m_SP, *(m_SP - 1));
                     --m_SP;
                 }
                 NEXT
@@ -449,7 +436,7 @@ void VM::interpretCases()
                     ON_OP();
                     updateIOGas();
 
-                    *(m_SP - 1) = *(m_SP - 1) ? divWorkaround(*m_SP, *(m_SP - 1)) : 0;
+                    *(m_SP - 1) = arith::div(*m_SP, *(m_SP - 1));
                     --m_SP;
                 }
                 NEXT
@@ -459,7 +446,7 @@ void VM::interpretCases()
                     ON_OP();
                     updateIOGas();
 
-                    *(m_SP - 1) = *(m_SP - 1) ? s2u(divWorkaround(u2s(*m_SP), u2s(*(m_SP - 1)))) : 0;
+                    *(m_SP - 1) = arith::sdiv(*m_SP, *(m_SP - 1));
                     --m_SP;
                 }
                 NEXT
@@ -469,7 +456,7 @@ void VM::interpretCases()
                     ON_OP();
                     updateIOGas();
 
-                    *(m_SP - 1) = *(m_SP - 1) ? modWorkaround(*m_SP, *(m_SP - 1)) : 0;
+                    *(m_SP - 1) = arith::mod(*m_SP, *(m_SP - 1));
                     --m_SP;
                 }
                 NEXT
@@ -479,7 +466,7 @@ void VM::interpretCases()
                     ON_OP();
                     updateIOGas();
 
-                    *(m_SP - 1) = *(m_SP - 1) ? s2u(modWorkaround(u2s(*m_SP), u2s(*(m_SP - 1)))) : 0;
+                    *(m_SP - 1) = arith::smod(*m_SP, *(m_SP - 1));
                     --m_SP;
                 }
                 NEXT
@@ -597,7 +584,7 @@ void VM::interpretCases()
                     ON_OP();
                     updateIOGas();
 
-                    *(m_SP - 2) = *(m_SP - 2) ? u256((u512(*m_SP) + u512(*(m_SP - 1))) % *(m_SP - 2)) : 0;
+                    *(m_SP - 2) = arith::addmod(*m_SP, *(m_SP - 1), *(m_SP - 2));
                     m_SP -= 2;
                 }
                 NEXT
@@ -607,7 +594,7 @@ void VM::interpretCases()
                     ON_OP();
                     updateIOGas();
 
-                    *(m_SP - 2) = *(m_SP - 2) ? u256((u512(*m_SP) * u512(*(m_SP - 1))) % *(m_SP - 2)) : 0;
+                    *(m_SP - 2) = arith::mulmod(*m_SP, *(m_SP - 1), *(m_SP - 2));
                     m_SP -= 2;
                 }
                 NEXT
@@ -28,6 +28,8 @@
 #include <libdevcore/SHA3.h>
 #include <libethcore/BlockHeader.h>
 #include "VMFace.h"
+#include "VMAnalysisCache.h"
+#include "VMArith.h"
 
 namespace dev
 {
@@ -90,9 +92,7 @@ namespace dev
 
             static void initMetrics();
 
-            static u256 exp256(u256 _base, u256 _exponent);
-
-            void copyCode(int);
+            void copyCode(VMCodeAnalysis &_analysis, int _extraBytes);
 
             const void *const *c_jumpTable = 0;
             bool m_caseInit = false;
@@ -110,9 +110,9 @@ namespace dev
             // space for memory
             bytes m_mem;
 
-            // space for code and pointer to data
-            bytes m_codeSpace;
-            byte *m_code = nullptr;
+            // analysis of the executing code, possibly shared with other executions of it
+            std::shared_ptr<VMCodeAnalysis const> m_analysis;
+            byte const *m_code = nullptr;
 
             // space for stack and pointer to data
             u256 m_stackSpace[1025];
@@ -133,7 +133,7 @@ namespace dev
 #endif
 
             // constant pool
-            u256 m_pool[256];
+            u256 const *m_pool = nullptr;
 
             // interpreter state
             Instruction m_OP;                   // current operator
@@ -177,9 +177,6 @@ namespace dev
 
             void reportStackUse();
 
-            std::vector<uint64_t> m_beginSubs;
-            std::vector<uint64_t> m_jumpDests;
-
             int64_t verifyJumpDest(u256 const &_dest, bool _throw = true);
 
             int poolConstant(const u256 &);
@@ -0,0 +1,121 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file VMAnalysisCache.h
+ * @date 2018
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <atomic>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/Guards.h>
+
+namespace dev
+{
+    namespace eth
+    {
+
+        /**
+         * @brief Result of the VM's first pass over a piece of code: the copy of the code with the
+         * synthetic instructions patched in, the sorted JUMPDEST table and the constant pool.
+         * It only depends on the code, and is immutable once stored in the VMAnalysisCache.
+         */
+        struct VMCodeAnalysis
+        {
+            size_t codeSize = 0;                ///< size of the original code
+            bytes code;                         ///< optimized code, zero padded past codeSize
+            std::vector<uint64_t> jumpDests;    ///< pcs of the valid jump destinations, ascending
+            std::vector<uint64_t> beginSubs;
+            u256 pool[256];                     ///< constants pushed by PUSHC
+        };
+
+        /**
+         * @brief Simple thread-safe cache to store a mapping from code hash to the VM's analysis of that code.
+         * If the cache is full, a random element is removed.
+         */
+        class VMAnalysisCache
+        {
+        public:
+            std::shared_ptr<VMCodeAnalysis const> get(h256 const &_hash, size_t _codeSize)
+            {
+                UniqueGuard g(x_cache);
+                auto it = m_cache.find(_hash);
+                if (it == m_cache.end() || it->second->codeSize != _codeSize)
+                {
+                    ++m_misses;
+                    return nullptr;
+                }
+                ++m_hits;
+                return it->second;
+            }
+
+            void store(h256 const &_hash, std::shared_ptr<VMCodeAnalysis const> const &_analysis)
+            {
+                UniqueGuard g(x_cache);
+                if (m_cache.size() >= c_maxSize)
+                    removeRandomElement();
+                m_cache[_hash] = _analysis;
+            }
+
+            size_t size() const
+            {
+                UniqueGuard g(x_cache);
+                return m_cache.size();
+            }
+
+            uint64_t hits() const
+            {
+                return m_hits;
+            }
+
+            uint64_t misses() const
+            {
+                return m_misses;
+            }
+
+            static VMAnalysisCache &instance()
+            {
+                static VMAnalysisCache cache;
+                return cache;
+            }
+
+        private:
+            /// Removes a random element from the cache.
+            void removeRandomElement()
+            {
+                if (!m_cache.empty())
+                {
+                    auto it = m_cache.lower_bound(h256::random());
+                    if (it == m_cache.end())
+                        it = m_cache.begin();
+                    m_cache.erase(it);
+                }
+            }
+
+            // an entry holds the code plus an 8KB constant pool
+            static const size_t c_maxSize = 512;
+            mutable Mutex x_cache;
+            std::map<h256, std::shared_ptr<VMCodeAnalysis const>> m_cache;
+            std::atomic<uint64_t> m_hits{0};
+            std::atomic<uint64_t> m_misses{0};
+        };
+
+    }
+}
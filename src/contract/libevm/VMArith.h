@@ -0,0 +1,406 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file VMArith.h
+ * @date 2018
+ *
+ * 256-bit arithmetic for the interpreter's stack operations.
+ *
+ * The EVM words are boost::multiprecision numbers whose generic algorithms dominate arithmetic-heavy
+ * contracts. Where the compiler has a 128-bit integer type the operations below work directly on the
+ * four 64-bit limbs of the words, with a carry chain for ADD/SUB, a truncated schoolbook product for
+ * MUL/EXP and a short division for divisors and moduli that fit in 64 bits. Anything else is handed
+ * back to boost, so results are bit-identical to the plain u256/u512/s512 expressions.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <libdevcore/Common.h>
+
+#if defined(__SIZEOF_INT128__) && defined(BOOST_HAS_INT128)
+#define EVM_NATIVE_ARITH 1
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+#else
+#define EVM_NATIVE_ARITH 0
+#endif
+
+namespace dev
+{
+    namespace eth
+    {
+        namespace arith
+        {
+
+            /// Reference versions, also used by the native ones for the operands they do not cover.
+            inline u256 divRef(u256 const &_a, u256 const &_b)
+            {
+                return _b ? (u256)(s512(_a) / s512(_b)) : 0;
+            }
+
+            inline u256 modRef(u256 const &_a, u256 const &_b)
+            {
+                return _b ? (u256)(s512(_a) % s512(_b)) : 0;
+            }
+
+            inline u256 sdivRef(u256 const &_a, u256 const &_b)
+            {
+                return _b ? s2u((s256)(s512(u2s(_a)) / s512(u2s(_b)))) : 0;
+            }
+
+            inline u256 smodRef(u256 const &_a, u256 const &_b)
+            {
+                return _b ? s2u((s256)(s512(u2s(_a)) % s512(u2s(_b)))) : 0;
+            }
+
+            inline u256 addmodRef(u256 const &_a, u256 const &_b, u256 const &_m)
+            {
+                return _m ? u256((u512(_a) + u512(_b)) % _m) : 0;
+            }
+
+            inline u256 mulmodRef(u256 const &_a, u256 const &_b, u256 const &_m)
+            {
+                return _m ? u256((u512(_a) * u512(_b)) % _m) : 0;
+            }
+
+            inline u256 expRef(u256 _base, u256 _exponent)
+            {
+                using boost::multiprecision::limb_type;
+                u256 result = 1;
+                while (_exponent)
+                {
+                    if (static_cast<limb_type>(_exponent) & 1)
+                        result *= _base;
+                    _base *= _base;
+                    _exponent >>= 1;
+                }
+                return result;
+            }
+
+#if EVM_NATIVE_ARITH
+
+            static_assert(sizeof(boost::multiprecision::limb_type) == sizeof(uint64_t), "u256 limbs must be 64-bit");
+
+            using uint128 = unsigned __int128;
+
+            /// Little-endian limbs of a u256.
+            struct Word
+            {
+                uint64_t w[4];
+            };
+
+            inline Word toWord(u256 const &_v)
+            {
+                Word r = {{0, 0, 0, 0}};
+                std::memcpy(r.w, _v.backend().limbs(), _v.backend().size() * sizeof(uint64_t));
+                return r;
+            }
+
+            inline u256 fromWord(Word const &_w)
+            {
+                u256 r;
+                r.backend().resize(4, 4);
+                std::memcpy(r.backend().limbs(), _w.w, sizeof(_w.w));
+                r.backend().normalize();
+                return r;
+            }
+
+            inline bool isZero(Word const &_a)
+            {
+                return (_a.w[0] | _a.w[1] | _a.w[2] | _a.w[3]) == 0;
+            }
+
+            inline bool fits64(Word const &_a)
+            {
+                return (_a.w[1] | _a.w[2] | _a.w[3]) == 0;
+            }
+
+            inline bool isNegative(Word const &_a)
+            {
+                return _a.w[3] >> 63;
+            }
+
+            inline Word addWord(Word const &_a, Word const &_b)
+            {
+                Word r;
+#if defined(__x86_64__)
+                unsigned long long t;
+                unsigned char c = _addcarry_u64(0, _a.w[0], _b.w[0], &t);
+                r.w[0] = t;
+                c = _addcarry_u64(c, _a.w[1], _b.w[1], &t);
+                r.w[1] = t;
+                c = _addcarry_u64(c, _a.w[2], _b.w[2], &t);
+                r.w[2] = t;
+                _addcarry_u64(c, _a.w[3], _b.w[3], &t);
+                r.w[3] = t;
+#else
+                uint64_t c = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    uint128 t = (uint128)_a.w[i] + _b.w[i] + c;
+                    r.w[i] = (uint64_t)t;
+                    c = (uint64_t)(t >> 64);
+                }
+#endif
+                return r;
+            }
+
+            inline Word subWord(Word const &_a, Word const &_b)
+            {
+                Word r;
+#if defined(__x86_64__)
+                unsigned long long t;
+                unsigned char c = _subborrow_u64(0, _a.w[0], _b.w[0], &t);
+                r.w[0] = t;
+                c = _subborrow_u64(c, _a.w[1], _b.w[1], &t);
+                r.w[1] = t;
+                c = _subborrow_u64(c, _a.w[2], _b.w[2], &t);
+                r.w[2] = t;
+                _subborrow_u64(c, _a.w[3], _b.w[3], &t);
+                r.w[3] = t;
+#else
+                uint64_t c = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    uint128 t = (uint128)_a.w[i] - _b.w[i] - c;
+                    r.w[i] = (uint64_t)t;
+                    c = (uint64_t)(t >> 64) & 1;
+                }
+#endif
+                return r;
+            }
+
+            inline Word negWord(Word const &_a)
+            {
+                return subWord(Word{{0, 0, 0, 0}}, _a);
+            }
+
+            /// Product modulo 2^256: only the partial products below the fourth limb are computed.
+            inline Word mulWord(Word const &_a, Word const &_b)
+            {
+                Word r = {{0, 0, 0, 0}};
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (!_a.w[i])
+                        continue;
+                    uint64_t c = 0;
+                    for (int j = 0; i + j < 4; ++j)
+                    {
+                        uint128 t = (uint128)_a.w[i] * _b.w[j] + r.w[i + j] + c;
+                        r.w[i + j] = (uint64_t)t;
+                        c = (uint64_t)(t >> 64);
+                    }
+                }
+                return r;
+            }
+
+            /// Divides by a 64-bit divisor, returns the remainder.
+            inline uint64_t divmod64(Word const &_a, uint64_t _d, Word &o_q)
+            {
+                uint128 rem = 0;
+                for (int i = 3; i >= 0; --i)
+                {
+                    uint128 cur = (rem << 64) | _a.w[i];
+                    o_q.w[i] = (uint64_t)(cur / _d);
+                    rem = cur % _d;
+                }
+                return (uint64_t)rem;
+            }
+
+            inline uint64_t mod64(Word const &_a, uint64_t _d)
+            {
+                Word q;
+                return divmod64(_a, _d, q);
+            }
+
+            /// Unsigned quotient for a non-zero divisor.
+            inline Word udivWord(Word const &_a, Word const &_b)
+            {
+                Word q = {{0, 0, 0, 0}};
+                if (fits64(_b))
+                    divmod64(_a, _b.w[0], q);
+                else
+                    q = toWord(fromWord(_a) / fromWord(_b));
+                return q;
+            }
+
+            /// Unsigned remainder for a non-zero divisor.
+            inline Word umodWord(Word const &_a, Word const &_b)
+            {
+                if (fits64(_b))
+                    return Word{{mod64(_a, _b.w[0]), 0, 0, 0}};
+                return toWord(fromWord(_a) % fromWord(_b));
+            }
+
+            inline u256 add(u256 const &_a, u256 const &_b)
+            {
+                return fromWord(addWord(toWord(_a), toWord(_b)));
+            }
+
+            inline u256 sub(u256 const &_a, u256 const &_b)
+            {
+                return fromWord(subWord(toWord(_a), toWord(_b)));
+            }
+
+            inline u256 mul(u256 const &_a, u256 const &_b)
+            {
+                return fromWord(mulWord(toWord(_a), toWord(_b)));
+            }
+
+            inline u256 div(u256 const &_a, u256 const &_b)
+            {
+                Word b = toWord(_b);
+                if (isZero(b))
+                    return 0;
+                return fromWord(udivWord(toWord(_a), b));
+            }
+
+            inline u256 mod(u256 const &_a, u256 const &_b)
+            {
+                Word b = toWord(_b);
+                if (isZero(b))
+                    return 0;
+                return fromWord(umodWord(toWord(_a), b));
+            }
+
+            /// Truncates towards zero like s512, so -2^255 / -1 wraps back to -2^255.
+            inline u256 sdiv(u256 const &_a, u256 const &_b)
+            {
+                Word a = toWord(_a);
+                Word b = toWord(_b);
+                if (isZero(b))
+                    return 0;
+                bool negA = isNegative(a);
+                bool negB = isNegative(b);
+                Word q = udivWord(negA ? negWord(a) : a, negB ? negWord(b) : b);
+                return fromWord(negA != negB ? negWord(q) : q);
+            }
+
+            /// The remainder takes the sign of the dividend.
+            inline u256 smod(u256 const &_a, u256 const &_b)
+            {
+                Word a = toWord(_a);
+                Word b = toWord(_b);
+                if (isZero(b))
+                    return 0;
+                bool negA = isNegative(a);
+                Word r = umodWord(negA ? negWord(a) : a, isNegative(b) ? negWord(b) : b);
+                return fromWord(negA ? negWord(r) : r);
+            }
+
+            inline u256 addmod(u256 const &_a, u256 const &_b, u256 const &_m)
+            {
+                Word m = toWord(_m);
+                if (isZero(m))
+                    return 0;
+                if (!fits64(m))
+                    return addmodRef(_a, _b, _m);
+                uint128 s = (uint128)mod64(toWord(_a), m.w[0]) + mod64(toWord(_b), m.w[0]);
+                return u256((uint64_t)(s % m.w[0]));
+            }
+
+            inline u256 mulmod(u256 const &_a, u256 const &_b, u256 const &_m)
+            {
+                Word m = toWord(_m);
+                if (isZero(m))
+                    return 0;
+                if (!fits64(m))
+                    return mulmodRef(_a, _b, _m);
+                uint128 p = (uint128)mod64(toWord(_a), m.w[0]) * mod64(toWord(_b), m.w[0]);
+                return u256((uint64_t)(p % m.w[0]));
+            }
+
+            inline u256 exp(u256 const &_base, u256 const &_exponent)
+            {
+                Word base = toWord(_base);
+                Word e = toWord(_exponent);
+                Word r = {{1, 0, 0, 0}};
+                int top = 3;
+                while (top >= 0 && !e.w[top])
+                    --top;
+                for (int i = 0; i <= top; ++i)
+                {
+                    uint64_t bits = e.w[i];
+                    // the squarings past the exponent's highest bit would not contribute
+                    for (int k = 0; k < 64 && (i < top || bits); ++k, bits >>= 1)
+                    {
+                        if (bits & 1)
+                            r = mulWord(r, base);
+                        base = mulWord(base, base);
+                    }
+                }
+                return fromWord(r);
+            }
+
+#else
+
+            inline u256 add(u256 const &_a, u256 const &_b)
+            {
+                return _a + _b;
+            }
+
+            inline u256 sub(u256 const &_a, u256 const &_b)
+            {
+                return _a - _b;
+            }
+
+            inline u256 mul(u256 const &_a, u256 const &_b)
+            {
+                return _a * _b;
+            }
+
+            inline u256 div(u256 const &_a, u256 const &_b)
+            {
+                return divRef(_a, _b);
+            }
+
+            inline u256 mod(u256 const &_a, u256 const &_b)
+            {
+                return modRef(_a, _b);
+            }
+
+            inline u256 sdiv(u256 const &_a, u256 const &_b)
+            {
+                return sdivRef(_a, _b);
+            }
+
+            inline u256 smod(u256 const &_a, u256 const &_b)
+            {
+                return smodRef(_a, _b);
+            }
+
+            inline u256 addmod(u256 const &_a, u256 const &_b, u256 const &_m)
+            {
+                return addmodRef(_a, _b, _m);
+            }
+
+            inline u256 mulmod(u256 const &_a, u256 const &_b, u256 const &_m)
+            {
+                return mulmodRef(_a, _b, _m);
+            }
+
+            inline u256 exp(u256 const &_base, u256 const &_exponent)
+            {
+                return expRef(_base, _exponent);
+            }
+
+#endif
+
+        }
+    }
+}
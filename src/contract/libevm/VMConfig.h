@@ -33,13 +33,10 @@ namespace dev
         //
         // EVM_TRACE              - provides various levels of tracing
 
+        // the jump table below has to name, at each opcode value, the CASE the switch takes for it
 #ifndef EVM_JUMP_DISPATCH
-#ifdef __GNUC__
-#define EVM_JUMP_DISPATCH false
-#else
 #define EVM_JUMP_DISPATCH false
 #endif
-#endif
 #if EVM_JUMP_DISPATCH
 #ifndef __GNUC__
 #error "address of label extension avaiable only on Gnu"
@@ -219,16 +216,16 @@ namespace dev
             &&NUMBER,  \
             &&DIFFICULTY,  \
             &&GASLIMIT,  \
+            &&INVALID,  \
+            &&INVALID,  \
+            &&INVALID,  \
+            &&INVALID,  \
             &&JUMPTO,  \
             &&JUMPIF,  \
             &&JUMPV,  \
             &&JUMPSUB,  \
             &&JUMPSUBV,  \
             &&RETURNSUB,  \
-            &&BEGINSUB,  \
-            &&BEGINDATA,  \
-            &&INVALID,  \
-            &&INVALID,  \
             &&POP,           /* 50, */  \
             &&MLOAD,  \
             &&MSTORE,  \
@@ -241,8 +238,8 @@ namespace dev
             &&MSIZE,  \
             &&GAS,  \
             &&JUMPDEST,  \
-            &&BEGINDATA,  \
             &&BEGINSUB,  \
+            &&BEGINDATA,  \
             &&INVALID,  \
             &&INVALID,  \
             &&PUSH1,         /* 60, */  \
@@ -51,21 +51,34 @@ void VM::initMetrics()
     done = true;
 }
 
-void VM::copyCode(int _extraBytes)
+void VM::copyCode(VMCodeAnalysis &_analysis, int _extraBytes)
 {
     // Copy code so that it can be safely modified and extend code by
     // _extraBytes zero bytes to allow reading virtual data at the end
     // of the code without bounds checks.
     auto extendedSize = m_ext->code.size() + _extraBytes;
-    m_codeSpace.reserve(extendedSize);
-    m_codeSpace = m_ext->code;
-    m_codeSpace.resize(extendedSize);
-    m_code = m_codeSpace.data();
+    _analysis.codeSize = m_ext->code.size();
+    _analysis.code.reserve(extendedSize);
+    _analysis.code = m_ext->code;
+    _analysis.code.resize(extendedSize);
 }
 
 void VM::optimize()
 {
-    copyCode(33);
+    // the analysis only depends on the code, reuse the one of an earlier execution if there is one
+    VMAnalysisCache &cache = VMAnalysisCache::instance();
+    bool const fCacheable = m_ext->codeHash != h256();
+    if (fCacheable && (m_analysis = cache.get(m_ext->codeHash, m_ext->code.size())))
+    {
+        m_code = m_analysis->code.data();
+        m_pool = m_analysis->pool;
+        return;
+    }
+
+    std::shared_ptr<VMCodeAnalysis> analysis = std::make_shared<VMCodeAnalysis>();
+    m_analysis = analysis;
+    copyCode(*analysis, 33);
+    byte *code = analysis->code.data();
 
     size_t const nBytes = m_ext->code.size();
 
@@ -74,7 +87,7 @@ void VM::optimize()
     TRACE_STR(1, "Build JUMPDEST table")
     for (size_t pc = 0; pc < nBytes; ++pc)
     {
-        Instruction op = Instruction(m_code[pc]);
+        Instruction op = Instruction(code[pc]);
         TRACE_OP(2, pc, op);
 
         // make synthetic ops in user code trigger invalid instruction if run
@@ -85,12 +98,12 @@ void VM::optimize()
                 )
         {
             TRACE_OP(1, pc, op);
-            m_code[pc] = (byte)Instruction::BAD;
+            code[pc] = (byte)Instruction::BAD;
         }
 
         if (op == Instruction::JUMPDEST)
         {
-            m_jumpDests.push_back(pc);
+            analysis->jumpDests.push_back(pc);
         } else if (
                 (byte)Instruction::PUSH1 <= (byte)op &&
                 (byte)op <= (byte)Instruction::PUSH32
@@ -110,11 +123,11 @@ void VM::optimize()
         else if (op == Instruction::JUMPV || op == Instruction::JUMPSUBV)
         {
             ++pc;
-            pc += 4 * m_code[pc];  // number of 4-byte dests followed by table
+            pc += 4 * code[pc];  // number of 4-byte dests followed by table
         }
         else if (op == Instruction::BEGINSUB)
         {
-            m_beginSubs.push_back(pc);
+            analysis->beginSubs.push_back(pc);
         }
         else if (op == Instruction::BEGINDATA)
         {
@@ -175,7 +188,7 @@ void VM::optimize()
             }
             return table[hash] == val;
         }
-    } constantPool(m_pool);
+    } constantPool(analysis->pool);
 #define CONST_POOL_HASH_INIT() constantPool.hashInit()
 #define CONST_POOL_HASH_BYTE(b) constantPool.hashByte(b)
 #define CONST_POOL_GET_HASH() constantPool.getHash()
@@ -191,7 +204,7 @@ void VM::optimize()
     for (size_t pc = 0; pc < nBytes; ++pc)
     {
         u256 val = 0;
-        Instruction op = Instruction(m_code[pc]);
+        Instruction op = Instruction(code[pc]);
 
         if ((byte)Instruction::PUSH1 <= (byte)op && (byte)op <= (byte)Instruction::PUSH32)
         {
@@ -200,11 +213,11 @@ void VM::optimize()
 
             // decode pushed bytes to integral value
             CONST_POOL_HASH_INIT();
-            val = m_code[pc + 1];
+            val = code[pc + 1];
             for (uint64_t i = pc + 2, n = nPush; --n; ++i)
             {
-                val = (val << 8) | m_code[i];
-                CONST_POOL_HASH_BYTE(m_code[i]);
+                val = (val << 8) | code[i];
+                CONST_POOL_HASH_BYTE(code[i]);
             }
 
 #ifdef EVM_USE_CONSTANT_POOL
@@ -216,9 +229,9 @@ void VM::optimize()
                 byte hash = CONST_POOL_GET_HASH();
                 if (CONST_POOL_INSERT_VAL(hash, val))
                 {
-                    m_code[pc] = (byte)Instruction::PUSHC;
-                    m_code[pc + 1] = hash;
-                    m_code[pc + 2] = nPush - 1;
+                    code[pc] = (byte)Instruction::PUSHC;
+                    code[pc + 1] = hash;
+                    code[pc + 2] = nPush - 1;
                     TRACE_VAL(1, "constant pooled", val);
                 }
                 TRACE_POST_OPT(1, pc, op);
@@ -231,14 +244,14 @@ void VM::optimize()
             // outer loop is N = number of bytes in code array
             // so complexity is N log M, worst case is N log N
             size_t i = pc + nPush + 1;
-            op = Instruction(m_code[i]);
+            op = Instruction(code[i]);
             if (op == Instruction::JUMP)
             {
                 TRACE_STR(1, "Replace const JUMPC")
                 TRACE_PRE_OPT(1, i, op);
 
                 if (0 <= verifyJumpDest(val, false))
-                    m_code[i] = byte(op = Instruction::JUMPC);
+                    code[i] = byte(op = Instruction::JUMPC);
 
                 TRACE_POST_OPT(1, i, op);
             } else if (op == Instruction::JUMPI)
@@ -247,7 +260,7 @@ void VM::optimize()
                 TRACE_PRE_OPT(1, i, op);
 
                 if (0 <= verifyJumpDest(val, false))
-                    m_code[i] = byte(op = Instruction::JUMPCI);
+                    code[i] = byte(op = Instruction::JUMPCI);
 
                 TRACE_POST_OPT(1, ii, op);
             }
@@ -259,6 +272,11 @@ void VM::optimize()
     }
     TRACE_STR(1, "Finished optimizations")
 #endif
+
+    m_code = code;
+    m_pool = analysis->pool;
+    if (fCacheable)
+        cache.store(m_ext->codeHash, analysis);
 }
 
 
@@ -273,23 +291,3 @@ void VM::initEntry()
     optimize();
 }
 
-
-// Implementation of EXP.
-//
-// This implements exponentiation by squaring algorithm.
-// Is faster than boost::multiprecision::powm() because it avoids explicit
-// mod operation.
-// Do not inline it.
-u256 VM::exp256(u256 _base, u256 _exponent)
-{
-    using boost::multiprecision::limb_type;
-    u256 result = 1;
-    while (_exponent)
-    {
-        if (static_cast<limb_type>(_exponent) & 1)    // If exponent is odd.
-            result *= _base;
-        _base *= _base;
-        _exponent >>= 1;
-    }
-    return result;
-}
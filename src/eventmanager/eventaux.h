@@ -59,10 +59,9 @@ public:
 
     void Wake ()
     {
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            nValue--;
-        }
+        // notify with the lock held, the waiter may destroy this object as soon as it sees nValue <= 0.
+        std::lock_guard<std::mutex> lock(mutex);
+        nValue--;
         cond.notify_one();
     }
 
@@ -100,4 +99,12 @@ std::string EventSignature()
     return EventFoo<TArgs...>::name();
 }
 
+// identifies the handler signature void(TArgs...) by address, comparable without RTTI.
+template <typename... TArgs>
+const void* EventSignatureID()
+{
+    static const char id = 0;
+    return &id;
+}
+
 #endif //__SBTC_EVENTAUX_H__
@@ -1,10 +1,12 @@
 #ifndef __SBTC_EVENTBASIC_H__
 #define __SBTC_EVENTBASIC_H__
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <thread>
-#include <boost/any.hpp>
+#include <vector>
 
 typedef uint32_t uint32;
 
@@ -31,12 +33,43 @@ enum EventHandlePriority
     EHP_HIGHEST     = 4,
 };
 
+class CEventHandlerBase
+{
+public:
+    virtual ~CEventHandlerBase() {}
+};
+
+// callback of an event whose params are TArgs..., the type is fixed when the handler is registered.
+template<typename... TArgs>
+class CEventHandler : public CEventHandlerBase
+{
+public:
+    explicit CEventHandler(std::function<void(TArgs...)> fnIn) : fn(std::move(fnIn)) {}
+
+    std::function<void(TArgs...)> fn;
+};
+
+class CEventDispatcher;
 struct EventHandleItem
 {
     int         flags;      // see EventHandleFlags
     int         priority;   // see EventHandlePriority
     void*       receiver;   // receiver object
-    boost::any  handler;    // callback
+    CEventDispatcher* dispatcher; // dispatcher thread of the receiver's module
+    std::shared_ptr<CEventHandlerBase> handler; // callback, a CEventHandler<TArgs...>
+};
+
+// an immutable snapshot of the handlers of one event.
+struct EventHandlerList
+{
+    const void* signature;  // see EventSignatureID
+    std::vector<EventHandleItem> handlers; // in priority order
+};
+
+struct EventHandlerSlot
+{
+    std::atomic<const EventHandlerList*> handlers{nullptr};
+    std::atomic<int> invoking{0}; // number of senders/posters reading the handlers
 };
 
 class CMultiWaiter;
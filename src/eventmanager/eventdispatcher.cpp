@@ -33,6 +33,36 @@ int CEventDispatcher::AddAsyncEvent(std::unique_ptr<EventQueuedItem> item)
     return -1;
 }
 
+int CEventDispatcher::AddAsyncEvent(int flags, CMultiWaiter* syncObj, std::function<void()> handler)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!interrupted)
+    {
+        std::unique_ptr<EventQueuedItem> item;
+        if (!pool.empty())
+        {
+            item = std::move(pool.back());
+            pool.pop_back();
+        }
+        else
+        {
+            item.reset(new EventQueuedItem);
+        }
+        item->flags = flags;
+        item->postID = std::this_thread::get_id();
+        item->syncObj = syncObj;
+        item->handler = std::move(handler);
+
+        queue.emplace_back(std::move(item));
+        if (queue.size() == 1)
+        {
+            cond.notify_one();
+        }
+        return 0;
+    }
+    return -1;
+}
+
 void CEventDispatcher::Interrupt(bool rude)
 {
     std::unique_lock<std::mutex> lock(mutex);
@@ -54,11 +84,16 @@ void CEventDispatcher::WaitExit()
 
 void CEventDispatcher::Dispatch()
 {
+    std::unique_ptr<EventQueuedItem> item;
     while (true)
     {
-        std::unique_ptr<EventQueuedItem> item;
         {
             std::unique_lock<std::mutex> lock(mutex);
+            if (item && pool.size() < MAX_POOLED_ITEMS)
+            {
+                pool.emplace_back(std::move(item));
+            }
+
             while (!interrupted && queue.empty())
             {
                 cond.wait(lock);
@@ -87,6 +122,8 @@ void CEventDispatcher::Dispatch()
             {
                 item->syncObj->Wake();
             }
+            item->handler = nullptr; // release the event params before the item is pooled
+            item->syncObj = nullptr;
         }
         else
         {
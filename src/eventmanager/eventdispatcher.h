@@ -2,6 +2,7 @@
 #define __SBTC_EVENTDISPATCHER_H__
 
 #include <deque>
+#include <vector>
 #include <thread>
 #include <memory>
 #include <mutex>
@@ -20,6 +21,9 @@ public:
 
     int AddAsyncEvent(std::unique_ptr<EventQueuedItem> item);
 
+    // queue a handler in an item taken from the dispatcher's pool of executed items.
+    int AddAsyncEvent(int flags, CMultiWaiter* syncObj, std::function<void()> handler);
+
     void Interrupt(bool rude = false);
 
     void WaitExit();
@@ -28,6 +32,9 @@ private:
 
     void Dispatch();
 
+    // keep at most this many executed items for reuse
+    static const size_t MAX_POOLED_ITEMS = 1024;
+
     bool interrupted;
     bool rudeInterrupted;
     std::thread dispThread;
@@ -35,6 +42,7 @@ private:
     std::mutex mutex;
     std::condition_variable cond;
     std::deque<std::unique_ptr<EventQueuedItem>> queue;
+    std::vector<std::unique_ptr<EventQueuedItem>> pool;
 };
 
 #endif //__SBTC_EVENTDISPATCHER_H__
@@ -1,6 +1,8 @@
 
 #include "eventmanager.h"
 
+#include <algorithm>
+
 //CEventManager& CEventManager::Instance()
 //{
 //    static CEventManager eventMgr;
@@ -38,6 +40,9 @@ int CEventManager::Uninit(bool refined)
     EVENT_LOCK_GUARD(mutex)
     if (!mapEventDispatchers.empty())
     {
+        mapEventHandlers.clear();
+        PublishAllEventHandlers();
+
         std::vector<CEventDispatcher*> dispatchers;
         for (auto& dispatcher : mapEventDispatchers)
         {
@@ -48,6 +53,11 @@ int CEventManager::Uninit(bool refined)
         {
             EVENT_UNLOCK_GUARD(mutex)
 
+            for (int eventID = 0; eventID < EVENT_ID_LIMIT; eventID++)
+            {
+                WaitForEventReaders(eventID);
+            }
+
             for (auto& dispatcher : dispatchers)
             {
                 dispatcher->Interrupt(!refined);
@@ -60,72 +70,115 @@ int CEventManager::Uninit(bool refined)
         }
 
         mapEventDispatchers.clear();
-        mapEventHandlers.clear();
         mapObjModules.clear();
+        vecRetiredHandlers.clear();
         return 0;
     }
     return 1;
 }
 
-#ifndef EVENT_UNLOCK_MODE
+int CEventManager::InsertEventHandler(int eventID, const void* signature, EventHandleItem handler)
+{
+    if (eventID < 0 || eventID >= EVENT_ID_LIMIT)
+    {
+        return -1;
+    }
+
+    EVENT_LOCK_GUARD(mutex)
+    auto& handlers = mapEventHandlers[eventID];
+    if (handlers.handlers.empty())
+    {
+        handlers.signature = signature;
+    }
+    else if (handlers.signature != signature)
+    {
+        return ERC_BADSIGNATURE;
+    }
+
+    // same priority handlers are invoked in registration order.
+    auto it = std::upper_bound(handlers.handlers.begin(), handlers.handlers.end(), handler.priority,
+                               [](int priority, const EventHandleItem& item) { return priority < item.priority; });
+    handlers.handlers.insert(it, std::move(handler));
+    PublishEventHandlers(eventID);
+    return 0;
+}
+
 int CEventManager::UnregisterEventHandler(int eventID, void* receiver)
 {
     int removeCount = 0;
-    EVENT_LOCK_GUARD(mutex)
-    auto it = mapEventHandlers.find(eventID);
-    if (it != mapEventHandlers.end())
+    if (eventID < 0 || eventID >= EVENT_ID_LIMIT)
     {
-        auto & handlers = it->second;
-        if (!handlers.empty())
+        return removeCount;
+    }
+
+    {
+        EVENT_LOCK_GUARD(mutex)
+        auto it = mapEventHandlers.find(eventID);
+        if (it == mapEventHandlers.end() || it->second.handlers.empty())
         {
-#ifdef EVENT_WEAKLOCK_MODE
-            // we should prevent handler from removed while some of handlers is invoking.
-            if (handlers.begin()->second.flags & EHF_HANDLER_INVOKING)
+            return removeCount;
+        }
+
+        // we should prevent handler from removed while some of handlers is invoking.
+        if (eventSlots[eventID].invoking.load() > 0)
+        {
+            return -1; // return value (-1) means unregister failed.
+        }
+
+        auto& handlers = it->second.handlers;
+        auto itHandler = handlers.begin();
+        while (itHandler != handlers.end())
+        {
+            if (itHandler->receiver == receiver)
             {
-                // removeCount = -1;
-                return -1; // return value (-1) means unregister failed.
+                removeCount++;
+                itHandler = handlers.erase(itHandler);
             }
-#endif
-            auto itHandler = handlers.begin();
-            while (itHandler != handlers.end())
+            else
             {
-                if (itHandler->second.receiver == receiver)
-                {
-                    removeCount++;
-                    itHandler = handlers.erase(itHandler);
-                }
-                else
-                {
-                    ++itHandler;
-                }
+                ++itHandler;
             }
         }
+
+        if (removeCount == 0)
+        {
+            return removeCount;
+        }
+        PublishEventHandlers(eventID);
     }
+
+    WaitForEventReaders(eventID);
     return removeCount;
 }
 
 int CEventManager::UnregisterEventHandler(int eventID)
 {
     int removeCount = 0;
-    EVENT_LOCK_GUARD(mutex)
-    auto it = mapEventHandlers.find(eventID);
-    if (it != mapEventHandlers.end())
+    if (eventID < 0 || eventID >= EVENT_ID_LIMIT)
+    {
+        return removeCount;
+    }
+
     {
-        auto & handlers = it->second;
-        if (!handlers.empty())
+        EVENT_LOCK_GUARD(mutex)
+        auto it = mapEventHandlers.find(eventID);
+        if (it == mapEventHandlers.end() || it->second.handlers.empty())
         {
-#ifdef EVENT_WEAKLOCK_MODE
-            // we should prevent handler from removed while some of handlers is invoking.
-            if (handlers.begin()->second.flags & EHF_HANDLER_INVOKING)
-            {
-                // removeCount = -1;
-                return -1; // return value (-1) means unregister failed.
-            }
-#endif
-            removeCount = (int)handlers.size();
-            mapEventHandlers.erase(it);
+            return removeCount;
         }
+
+        // we should prevent handler from removed while some of handlers is invoking.
+        if (eventSlots[eventID].invoking.load() > 0)
+        {
+            return -1; // return value (-1) means unregister failed.
+        }
+
+        removeCount = (int)it->second.handlers.size();
+        mapEventHandlers.erase(it);
+        PublishEventHandlers(eventID);
     }
+
+    WaitForEventReaders(eventID);
     return removeCount;
 }
 
@@ -144,7 +197,6 @@ int CEventManager::UnregisterEventHandlerInsistently(int eventID, void* receiver
     }
     return removeCount;
 }
-#endif
 
 int CEventManager::SetEventReceiverModule(int module, std::initializer_list<void*> receivers)
 {
@@ -155,6 +207,7 @@ int CEventManager::SetEventReceiverModule(int module, std::initializer_list<void
         {
             mapObjModules.emplace(receiver, module);
         }
+        PublishAllEventHandlers();
         return 0;
     }
     return -1;
@@ -167,8 +220,65 @@ int CEventManager::RunEventDispatcherForModules(uint32 modulesMask)
     if (it == mapEventDispatchers.end())
     {
         mapEventDispatchers.emplace(modulesMask, std::move(std::unique_ptr<CEventDispatcher>(new CEventDispatcher)));
+        PublishAllEventHandlers();
         return 0;
     }
     return -1;
 }
 
+CEventDispatcher* CEventManager::FindEventDispatcher(void* receiver)
+{
+    uint32 module = (uint32)MID_ALL_MODULE;
+    auto itModule = mapObjModules.find(receiver);
+    if (itModule != mapObjModules.end())
+    {
+        module = (uint32)itModule->second;
+    }
+
+    auto itDisp = mapEventDispatchers.lower_bound(module);
+    while (itDisp != mapEventDispatchers.end() && !(itDisp->first & module))
+    {
+        ++itDisp;
+    }
+    return itDisp != mapEventDispatchers.end() ? itDisp->second.get() : nullptr;
+}
+
+void CEventManager::PublishEventHandlers(int eventID)
+{
+    std::unique_ptr<EventHandlerList> handlers;
+    auto it = mapEventHandlers.find(eventID);
+    if (it != mapEventHandlers.end())
+    {
+        handlers.reset(new EventHandlerList(it->second));
+        for (auto& eachHandler : handlers->handlers)
+        {
+            eachHandler.dispatcher = FindEventDispatcher(eachHandler.receiver);
+        }
+    }
+
+    // senders may still read the replaced list, it is released by Uninit.
+    const EventHandlerList* replaced = eventSlots[eventID].handlers.exchange(handlers.release());
+    if (replaced)
+    {
+        vecRetiredHandlers.emplace_back(replaced);
+    }
+}
+
+void CEventManager::PublishAllEventHandlers()
+{
+    for (int eventID = 0; eventID < EVENT_ID_LIMIT; eventID++)
+    {
+        if (eventSlots[eventID].handlers.load() || mapEventHandlers.count(eventID))
+        {
+            PublishEventHandlers(eventID);
+        }
+    }
+}
+
+void CEventManager::WaitForEventReaders(int eventID)
+{
+    while (eventSlots[eventID].invoking.load() > 0)
+    {
+        std::this_thread::yield();
+    }
+}
@@ -9,41 +9,43 @@
 #include <memory>
 #include <mutex>
 #include <initializer_list>
-#include <boost/any.hpp>
+#include <atomic>
 #include "eventid.h"
 #include "moduleid.h"
 #include "eventdispatcher.h"
 
-//#define EVENT_UNLOCK_MODE
-//#define EVENT_WEAKLOCK_MODE
-//#define EVENT_STRONGLOCK_MODE
+// Registering, unregistering and the module/dispatcher setup are serialized by CEventManager's mutex.
+// Each of them publishes an immutable EventHandlerList per event ID, which sendEvent/postEvent/postEventAndWait
+// read without any lock, so an event can be sent from inside an event handler without deadlock.
+// Replaced lists are kept until Uninit, and unregistering waits until no sender reads the old list any more.
+# define EVENT_LOCK_GUARD(m) std::lock_guard<std::mutex> lck(m);
+# define EVENT_UNLOCK_GUARD(m) CEventUnlockGuard<std::mutex> unlck(m);
 
-// In this mode, all of operation to CEventManager's data will not be protected by unique mutex.
-// In other words, Caller should pay more attention to use event manager,
-// and ensure that any init/reister/set/startup methods would be finished before
-// sendEvent/postEvent/postEventAndWait methods.
-//#define EVENT_UNLOCK_MODE
+// event IDs must be in [0, EVENT_ID_LIMIT)
+static const int EVENT_ID_LIMIT = 256;
 
-// In this mode, the accessing to CEventManager's data will be protected by unique mutex,
-// but mutex would be release during the invoking of event handler, therefore another event
-// can be sent in the current event handler at the same thread without deadlock.
-#define EVENT_WEAKLOCK_MODE
+// marks an event as being read by the current thread during its lifetime.
+class CEventReadGuard
+{
+public:
+    CEventReadGuard(const CEventReadGuard&) = delete;
 
-// In this mode, the whole accessing to CEventManager's data as well as the invoking of event handler
-// will be protected by unique mutex.
-//#define EVENT_STRONGLOCK_MODE
+    explicit CEventReadGuard(EventHandlerSlot& slotIn) : slot(slotIn)
+    {
+        slot.invoking.fetch_add(1);
+        handlers = slot.handlers.load();
+    }
 
-#if !defined(EVENT_UNLOCK_MODE) && !defined(EVENT_WEAKLOCK_MODE) && !defined(EVENT_STRONGLOCK_MODE)
-# error "the above three macro must be defined one at least."
-#endif
+    ~CEventReadGuard()
+    {
+        slot.invoking.fetch_sub(1);
+    }
 
-#ifndef EVENT_UNLOCK_MODE
-# define EVENT_LOCK_GUARD(m) std::lock_guard<std::mutex> lck(m);
-# define EVENT_UNLOCK_GUARD(m) CEventUnlockGuard<std::mutex> unlck(m);
-#else
-# define EVENT_LOCK_GUARD(m)
-# define EVENT_UNLOCK_GUARD(m)
-#endif
+    const EventHandlerList* handlers;
+
+private:
+    EventHandlerSlot& slot;
+};
 
 //#define ENABLE_EVENT_SIGNATURE_VERIFY
 
@@ -84,18 +86,8 @@ public:
             if (!MatchEventSignature<TArgs...>(eventID))
                 return ERC_BADSIGNATURE;
 #endif
-            EventHandleItem handler;
-            handler.flags = flags;
-            handler.priority = -prior;
-            handler.receiver = receiver;
-
             std::function<void(TArgs...)> fn = [receiver, memfun](TArgs... args){ (receiver->*memfun)(std::forward<TArgs>(args)...); };
-            handler.handler = std::move(fn);
-
-            EVENT_LOCK_GUARD(mutex)
-            auto& handlers = mapEventHandlers[eventID];
-            handlers.emplace(handler.priority, std::move(handler));
-            return 0;
+            return AddEventHandler<TArgs...>(eventID, receiver, std::move(fn), prior, flags);
         }
         return -1;
     };
@@ -129,16 +121,7 @@ public:
             if (!MatchEventSignature<TArgs...>(eventID))
                 return ERC_BADSIGNATURE;
 #endif
-            EventHandleItem handler;
-            handler.flags = flags;
-            handler.priority = -prior;
-            handler.receiver = nullptr;
-            handler.handler = std::function<void(TArgs...)>(func);
-
-            EVENT_LOCK_GUARD(mutex)
-            auto& handlers = mapEventHandlers[eventID];
-            handlers.emplace(handler.priority, std::move(handler));
-            return 0;
+            return AddEventHandler<TArgs...>(eventID, nullptr, std::function<void(TArgs...)>(func), prior, flags);
         }
         return -1;
     };
@@ -152,19 +135,10 @@ public:
         if (!MatchEventSignature<TArgs...>(eventID))
             return ERC_BADSIGNATURE;
 #endif
-        EventHandleItem handler;
-        handler.flags = flags;
-        handler.priority = -prior;
-        handler.receiver = nullptr;
-        handler.handler = std::function<void(TArgs...)>([functor](TArgs... args){ (const_cast<TFunctor&>(functor))(std::forward<TArgs>(args)...); });
-
-        EVENT_LOCK_GUARD(mutex)
-        auto& handlers = mapEventHandlers[eventID];
-        handlers.emplace(handler.priority, std::move(handler));
-        return 0;
+        std::function<void(TArgs...)> fn = [functor](TArgs... args){ (const_cast<TFunctor&>(functor))(std::forward<TArgs>(args)...); };
+        return AddEventHandler<TArgs...>(eventID, nullptr, std::move(fn), prior, flags);
     };
 
-#ifndef EVENT_UNLOCK_MODE
     // this method may faild because of some handler are invoking.
     int UnregisterEventHandler(int eventID, void* receiver);
 
@@ -173,7 +147,6 @@ public:
 
     // this method must be successful.
     int UnregisterEventHandlerInsistently(int eventID, void* receiver);
-#endif
 
     int SetEventReceiverModule(int module, std::initializer_list<void*> receivers);
 
@@ -207,29 +180,21 @@ public:
         if (!MatchEventSignature<TArgs...>(eventID))
             return ERC_BADSIGNATURE;
 #endif
-        EVENT_LOCK_GUARD(mutex)
-        auto it = mapEventHandlers.find(eventID);
-        if (it != mapEventHandlers.end())
+        if (eventID < 0 || eventID >= EVENT_ID_LIMIT)
+            return -1;
+
+        CEventReadGuard guard(eventSlots[eventID]);
+        const EventHandlerList* handlers = guard.handlers;
+        if (handlers == nullptr || handlers->handlers.empty())
+            return -1;
+        if (handlers->signature != EventSignatureID<TArgs...>())
+            return ERC_BADSIGNATURE;
+
+        for (auto& eachHandler : handlers->handlers)
         {
-            auto& handlers = it->second; // References to elements in the unordered_map container remain valid in all cases, even after a rehash.
-            if (!handlers.empty())
-            {
-                handlers.begin()->second.flags |= EHF_HANDLER_INVOKING; // prevent handlers from removed.
-                {
-#ifdef EVENT_WEAKLOCK_MODE
-                    EVENT_UNLOCK_GUARD(mutex)
-#endif
-                    for (auto& eachHandler : handlers)
-                    {
-                        std::function<void(TArgs...)> callback = boost::any_cast<std::function<void(TArgs...)>>(eachHandler.second.handler);
-                        callback(args...);
-                    }
-                }
-                handlers.begin()->second.flags &= ~EHF_HANDLER_INVOKING;
-                return 0;
-            }
+            static_cast<const CEventHandler<TArgs...>&>(*eachHandler.handler).fn(args...);
         }
-        return -1;
+        return 0;
     }
 
     template<typename... TArgs>
@@ -239,44 +204,25 @@ public:
         if (!MatchEventSignature<TArgs...>(eventID))
             return ERC_BADSIGNATURE;
 #endif
-        EVENT_LOCK_GUARD(mutex)
-        auto it = mapEventHandlers.find(eventID);
-        if (it != mapEventHandlers.end())
+        if (eventID < 0 || eventID >= EVENT_ID_LIMIT)
+            return -1;
+
+        CEventReadGuard guard(eventSlots[eventID]);
+        const EventHandlerList* handlers = guard.handlers;
+        if (handlers == nullptr || handlers->handlers.empty())
+            return -1;
+        if (handlers->signature != EventSignatureID<TArgs...>())
+            return ERC_BADSIGNATURE;
+
+        for (auto& eachHandler : handlers->handlers)
         {
-            std::thread::id currentThreadID = std::this_thread::get_id();
-            auto& handlers = it->second;
-            for (auto& eachHandler : handlers)
+            if (eachHandler.dispatcher) // assert
             {
-                std::unique_ptr<EventQueuedItem> queueItem(new EventQueuedItem);
-                queueItem->flags = eachHandler.second.flags;
-                queueItem->postID = currentThreadID;
-                queueItem->syncObj = nullptr;
-
-                std::function<void(TArgs...)> callback = boost::any_cast<std::function<void(TArgs...)>>(eachHandler.second.handler);
-                std::function<void()> fn = [callback, args...](){ callback(args...); };
-                queueItem->handler = std::move(fn);
-
-                uint32 module = (uint32)MID_ALL_MODULE;
-                auto itModule = mapObjModules.find(eachHandler.second.receiver);
-                if (itModule != mapObjModules.end())
-                {
-                    module = (uint32)itModule->second;
-                }
-
-                auto itDisp = mapEventDispatchers.lower_bound(module);
-                while (itDisp != mapEventDispatchers.end() && !(itDisp->first & module))
-                {
-                    ++itDisp;
-                }
-
-                if (itDisp != mapEventDispatchers.end()) // assert
-                {
-                    itDisp->second->AddAsyncEvent(std::move(queueItem));
-                }
+                auto callback = static_cast<const CEventHandler<TArgs...>*>(eachHandler.handler.get());
+                eachHandler.dispatcher->AddAsyncEvent(eachHandler.flags, nullptr, [callback, args...](){ callback->fn(args...); });
             }
-            return 0;
         }
-        return -1;
+        return 0;
     }
 
     template<typename... TArgs>
@@ -286,66 +232,76 @@ public:
         if (!MatchEventSignature<TArgs...>(eventID))
             return ERC_BADSIGNATURE;
 #endif
-        std::unique_lock<std::mutex> lock(mutex);
-        auto it = mapEventHandlers.find(eventID);
-        if (it != mapEventHandlers.end())
+        if (eventID < 0 || eventID >= EVENT_ID_LIMIT)
+            return -1;
+
+        std::unique_ptr<CMultiWaiter> multiWaiter;
         {
-            auto& handlers = it->second;
-            CMultiWaiter multiWaiter((int)handlers.size());
+            CEventReadGuard guard(eventSlots[eventID]);
+            const EventHandlerList* handlers = guard.handlers;
+            if (handlers == nullptr || handlers->handlers.empty())
+                return -1;
+            if (handlers->signature != EventSignatureID<TArgs...>())
+                return ERC_BADSIGNATURE;
+
+            multiWaiter.reset(new CMultiWaiter((int)handlers->handlers.size()));
             std::thread::id currentThreadID = std::this_thread::get_id();
-            for (auto& eachHandler : handlers)
+            for (auto& eachHandler : handlers->handlers)
             {
-                uint32 module = (uint32)MID_ALL_MODULE;
-                auto itModule = mapObjModules.find(eachHandler.second.receiver);
-                if (itModule != mapObjModules.end())
-                {
-                    module = (uint32)itModule->second;
-                }
-
-                auto itDisp = mapEventDispatchers.lower_bound(module);
-                while (itDisp != mapEventDispatchers.end() && !(itDisp->first & module))
-                {
-                    ++itDisp;
-                }
-
-                if (itDisp != mapEventDispatchers.end()) // assert
+                if (eachHandler.dispatcher) // assert
                 {
-                    if (itDisp->second->GetThreadID() == currentThreadID)
+                    auto callback = static_cast<const CEventHandler<TArgs...>*>(eachHandler.handler.get());
+                    if (eachHandler.dispatcher->GetThreadID() == currentThreadID)
                     {
                         // we can't post an event to the same thread, instead we invoke event handler directly here.
-                        std::function<void(TArgs...)> callback = boost::any_cast<std::function<void(TArgs...)>>(eachHandler.second.handler);
-                        callback(args...); // Should we release lock here?
-                        multiWaiter.Wake();
+                        callback->fn(args...);
+                        multiWaiter->Wake();
                     }
                     else
                     {
-                        std::unique_ptr<EventQueuedItem> queueItem(new EventQueuedItem);
-                        queueItem->flags = eachHandler.second.flags;
-                        queueItem->postID = currentThreadID;
-                        queueItem->syncObj = &multiWaiter;
-
-                        std::function<void(TArgs...)> callback = boost::any_cast<std::function<void(TArgs...)>>(eachHandler.second.handler);
-                        std::function<void()> fn = [callback, args...](){ callback(args...); };
-                        queueItem->handler = std::move(fn);
-
-                        itDisp->second->AddAsyncEvent(std::move(queueItem));
+                        eachHandler.dispatcher->AddAsyncEvent(eachHandler.flags, multiWaiter.get(), [callback, args...](){ callback->fn(args...); });
                     }
                 }
             }
-
-            lock.unlock(); // now we first unlock mutex before waiting for async handler.
-            multiWaiter.Wait();
-            return 0;
         }
-        return -1;
+
+        // the handlers are released before waiting for async handler.
+        multiWaiter->Wait();
+        return 0;
     }
 
 private:
+    template<typename... TArgs>
+    int AddEventHandler(int eventID, void* receiver, std::function<void(TArgs...)> fn, int prior, int flags)
+    {
+        EventHandleItem handler;
+        handler.flags = flags;
+        handler.priority = -prior;
+        handler.receiver = receiver;
+        handler.dispatcher = nullptr;
+        handler.handler = std::make_shared<CEventHandler<TArgs...>>(std::move(fn));
+        return InsertEventHandler(eventID, EventSignatureID<TArgs...>(), std::move(handler));
+    }
+
+    int InsertEventHandler(int eventID, const void* signature, EventHandleItem handler);
+
+    // the following methods must be called with mutex held.
+    CEventDispatcher* FindEventDispatcher(void* receiver);
+
+    void PublishEventHandlers(int eventID);
+
+    void PublishAllEventHandlers();
+
+    // wait until no sender reads handlers replaced before the call.
+    void WaitForEventReaders(int eventID);
+
     std::mutex mutex;
     std::unordered_map<void*, int> mapObjModules;
     std::unordered_map<int, std::string> mapEventSignature;
-    std::unordered_map<int, std::multimap<int, EventHandleItem>> mapEventHandlers;
+    std::unordered_map<int, EventHandlerList> mapEventHandlers;
     std::map<uint32, std::unique_ptr<CEventDispatcher>> mapEventDispatchers;
+    EventHandlerSlot eventSlots[EVENT_ID_LIMIT];
+    std::vector<std::unique_ptr<const EventHandlerList>> vecRetiredHandlers;
 };
 
 #endif //__SBTC_EVENTMANAGER_H__
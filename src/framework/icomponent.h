@@ -19,6 +19,16 @@ namespace appbase
 
         virtual state GetState() const = 0;
 
+        /**
+         * Ids of the components whose Initialize (phase == initialized) or Startup (phase == started)
+         * must have completed before this component's, or'ed together. Components without a
+         * dependency between them run the phase concurrently.
+         */
+        virtual int GetDependencies(state phase) const
+        {
+            return 0;
+        }
+
         virtual bool Initialize() = 0;
 
         virtual bool Startup() = 0;
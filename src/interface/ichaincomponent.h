@@ -23,6 +23,21 @@ enum FlushStateMode
     FLUSH_STATE_ALWAYS
 };
 
+/** Progress of the block import running in the background, see getimportinfo */
+struct CImportProgress
+{
+    bool fActive = false;       //!< an import is running
+    bool fReindex = false;      //!< the import started by rebuilding the block index from the blk files
+    std::string strFile;        //!< file being imported
+    int nFile = 0;              //!< 1-based index of that file among the files to import, 0 before the first
+    int nFiles = 0;
+    uint64_t nFileBytesRead = 0;
+    uint64_t nFileSize = 0;
+    uint64_t nBlocksRead = 0;   //!< blocks read from all the files so far
+    uint64_t nBlocksLoaded = 0; //!< blocks of those that were not known yet
+    int64_t nStartTime = 0;
+};
+
 class IChainComponent : public appbase::TComponent<IChainComponent>
 {
 public:
@@ -40,6 +55,12 @@ public:
         return ID;
     }
 
+    virtual int GetDependencies(state phase) const override
+    {
+        // the mempool is loaded before the import thread starts connecting blocks
+        return phase == started ? CID_TX_MEMPOOL : 0;
+    }
+
     virtual bool ComponentInitialize() = 0;
 
     virtual bool ComponentStartup() = 0;
@@ -52,6 +73,8 @@ public:
 
     virtual bool IsReindexing() const = 0;
 
+    virtual CImportProgress GetImportProgress() = 0;
+
     virtual bool IsTxIndex() const = 0;
 
     virtual bool IsLogEvents() = 0;
@@ -70,6 +93,9 @@ public:
 
     virtual CChain &GetActiveChain() = 0;
 
+    /** Snapshot of the active chain as of the last tip update, usable without cs_main */
+    virtual std::shared_ptr<const CChainView> GetActiveChainView() = 0;
+
     virtual std::set<const CBlockIndex *, CompareBlocksByHeight> GetTips() = 0;
 
     virtual CCoinsView *GetCoinViewDB() = 0;
@@ -146,4 +172,4 @@ public:
 };
 
 #define GET_CHAIN_INTERFACE(ifObj) \
-    auto ifObj = GetApp()->FindComponent<IChainComponent>()
+    auto ifObj = appbase::IBaseApp::GetComponent<IChainComponent>()
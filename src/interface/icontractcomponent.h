@@ -8,9 +8,13 @@
 #include "sbtccore/transaction/transaction.h"
 #include "wallet/amount.h"
 
+#include "contract/libdevcore/NodeCache.h"
 #include "contract-api/contractbase.h"
 #include "contract-api/storageresults.h"
 
+class CBlockIndex;
+class CContractStateSnapshot;
+
 class IContractComponent : public appbase::TComponent<IContractComponent>
 {
 public:
@@ -28,6 +32,12 @@ public:
         return ID;
     }
 
+    virtual int GetDependencies(state phase) const override
+    {
+        // the contract state is opened by the chain component once the tip is loaded
+        return CID_BLOCK_CHAIN;
+    }
+
     virtual bool ComponentInitialize() = 0;
 
     virtual bool ContractInit() = 0;
@@ -40,6 +50,20 @@ public:
 
     virtual uint64_t GetBlockGasLimit(int height) = 0;
 
+    /// Called on every tip change: drops the cached DGP parameters of heights past the new tip and,
+    /// if fPrime, computes the ones of the block after it.
+    virtual void UpdateDGPCache(const CBlockIndex *pTip, bool fPrime) = 0;
+
+    /// Writes the contract state staged by the executions since the last flush. Unless fForce, only when
+    /// it has grown over the -contractdbcache budget. Called under cs_main.
+    virtual void FlushState(bool fForce) = 0;
+
+    /// Usage and hit counts of the cache of trie nodes read from the contract state databases.
+    virtual dev::NodeCache::Stats GetNodeCacheStats() = 0;
+
+    /// Blocks back from the tip whose contract state is kept, 0 when -prunecontractstate keeps all of it.
+    virtual int GetStateHistoryDepth() = 0;
+
     virtual bool AddressInUse(string contractaddress) = 0;
 
     virtual bool CheckContractTx(const CTransaction tx, const CAmount nFees,
@@ -67,17 +91,31 @@ public:
 
     virtual void UpdateState(uint256 hashStateRoot, uint256 hashUTXORoot) = 0;
 
+    /// Opens a copy-on-write layer over the contract state for speculative execution.
+    virtual void PushStateLayer() = 0;
+
+    /// Keeps the changes executed since the matching PushStateLayer.
+    virtual void MergeStateLayer() = 0;
+
+    /// Drops the changes executed since the matching PushStateLayer and restores its roots.
+    virtual void DiscardStateLayer() = 0;
+
     virtual void DeleteResults(std::vector<CTransactionRef> const &txs) = 0;
 
     virtual std::vector<TransactionReceiptInfo> GetResult(uint256 const &hashTx) = 0;
 
+    /// Receipts of a transaction of a connected block, readable without holding cs_main.
+    virtual std::vector<TransactionReceiptInfo> GetCommittedResult(uint256 const &hashTx) = 0;
+
     virtual void CommitResults() = 0;
 
     virtual void ClearCacheResult() = 0;
 
     virtual std::map<dev::h256, std::pair<dev::u256, dev::u256>> GetStorageByAddress(string address) = 0;
 
-    virtual void SetTemporaryState(uint256 hashStateRoot, uint256 hashUTXORoot) = 0;
+    /// Read-only snapshot of the state at the given roots, shared by the queries of recent roots.
+    /// Reading it takes neither cs_main nor the consensus state. nullptr if the roots are unknown.
+    virtual std::shared_ptr<CContractStateSnapshot> GetStateSnapshot(uint256 hashStateRoot, uint256 hashUTXORoot) = 0;
 
     virtual std::unordered_map<dev::h160, dev::u256> GetContractList() = 0;
 
@@ -88,8 +126,10 @@ public:
     virtual bool
     GetContractVin(dev::Address address, dev::h256 &hash, uint32_t &nVout, dev::u256 &value, uint8_t &alive) = 0;
 
+    /// Calls a contract on the snapshot, in the block after pTip, and reports the result for the RPC
     virtual void
-    RPCCallContract(UniValue &result, const string addrContract, std::vector<unsigned char> opcode, string sender,
+    RPCCallContract(UniValue &result, CContractStateSnapshot &snapshot, const CBlockIndex *pTip,
+                    const string addrContract, std::vector<unsigned char> opcode, string sender,
                     uint64_t gasLimit) = 0;
 
     virtual string GetExceptedInfo(uint32_t index) = 0;
@@ -97,4 +137,45 @@ public:
 };
 
 #define GET_CONTRACT_INTERFACE(ifObj) \
-    auto ifObj = GetApp()->FindComponent<IContractComponent>()
+    auto ifObj = appbase::IBaseApp::GetComponent<IContractComponent>()
+
+/** Opens a state layer for its scope and discards it on the way out, exceptions included, unless it was
+ * merged or discarded before. */
+class CContractStateLayer
+{
+public:
+    explicit CContractStateLayer(IContractComponent *ifContractObjIn) : ifContractObj(ifContractObjIn), fOpen(true)
+    {
+        ifContractObj->PushStateLayer();
+    }
+
+    ~CContractStateLayer()
+    {
+        Discard();
+    }
+
+    void Merge()
+    {
+        if (fOpen)
+        {
+            fOpen = false;
+            ifContractObj->MergeStateLayer();
+        }
+    }
+
+    void Discard()
+    {
+        if (fOpen)
+        {
+            fOpen = false;
+            ifContractObj->DiscardStateLayer();
+        }
+    }
+
+private:
+    CContractStateLayer(const CContractStateLayer &) = delete;
+    CContractStateLayer &operator=(const CContractStateLayer &) = delete;
+
+    IContractComponent *ifContractObj;
+    bool fOpen;
+};
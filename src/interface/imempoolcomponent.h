@@ -28,6 +28,12 @@ public:
         return ID;
     }
 
+    virtual int GetDependencies(state phase) const override
+    {
+        // mempool.dat is read during the block index load, and accepted once all components are initialized
+        return 0;
+    }
+
     virtual bool ComponentInitialize() = 0;
 
     virtual bool ComponentStartup() = 0;
@@ -57,4 +63,4 @@ public:
 };
 
 #define GET_TXMEMPOOL_INTERFACE(ifObj) \
-    auto ifObj = GetApp()->FindComponent<ITxMempoolComponent>()
+    auto ifObj = appbase::IBaseApp::GetComponent<ITxMempoolComponent>()
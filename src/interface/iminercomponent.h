@@ -27,15 +27,23 @@ public:
         return ID;
     }
 
+    virtual int GetDependencies(state phase) const override
+    {
+        return phase == started ? CID_BLOCK_CHAIN | CID_TX_MEMPOOL | CID_P2P_NET | CID_WALLET : 0;
+    }
+
     virtual bool ComponentInitialize() = 0;
 
     virtual bool ComponentStartup() = 0;
 
     virtual bool ComponentShutdown() = 0;
 
+    /** Hash rate of the internal miner over the last few seconds, 0 when it is not running. */
+    virtual double GetHashesPerSec() = 0;
+
     //add other interface methods here ...
 
 };
 
 #define GET_MINER_INTERFACE(ifObj) \
-    auto ifObj = GetApp()->FindComponent<IMinerComponent>()
+    auto ifObj = appbase::IBaseApp::GetComponent<IMinerComponent>()
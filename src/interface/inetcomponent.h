@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "componentid.h"
@@ -25,6 +26,12 @@ public:
         return ID;
     }
 
+    virtual int GetDependencies(state phase) const override
+    {
+        // the peer logic receives the validation signals from after the chain is loaded
+        return phase == started ? CID_BLOCK_CHAIN | CID_CONTRACT | CID_TX_MEMPOOL : CID_BLOCK_CHAIN;
+    }
+
     virtual bool ComponentInitialize() = 0;
 
     virtual bool ComponentStartup() = 0;
@@ -34,7 +41,9 @@ public:
     virtual const char *whoru() const = 0;
 
 
-    virtual bool SendNetMessage(int64_t nodeID, const std::string &command, const std::vector<unsigned char> &data) = 0;
+    //! nodeID -1 broadcasts; the payload is framed once and shared by the send queue of every peer
+    virtual bool SendNetMessage(int64_t nodeID, const std::string &command,
+                                std::shared_ptr<const std::vector<unsigned char>> data) = 0;
 
     virtual bool BroadcastTransaction(uint256 txHash) = 0;
 
@@ -65,4 +74,4 @@ public:
 };
 
 #define GET_NET_INTERFACE(ifObj) \
-    auto ifObj = GetApp()->FindComponent<INetComponent>()
+    auto ifObj = appbase::IBaseApp::GetComponent<INetComponent>()
@@ -22,6 +22,12 @@ public:
         return ID;
     }
 
+    virtual int GetDependencies(state phase) const override
+    {
+        // rpc warmup ends with startup
+        return phase == started ? CID_BLOCK_CHAIN | CID_CONTRACT | CID_TX_MEMPOOL : 0;
+    }
+
     virtual bool ComponentInitialize() = 0;
 
     virtual bool ComponentStartup() = 0;
@@ -35,4 +41,4 @@ public:
 };
 
 #define GET_RPC_INTERFACE(ifObj) \
-    auto ifObj = appbase::CBase::Instance().FindComponent<IHttpRpcComponent>()
+    auto ifObj = appbase::IBaseApp::GetComponent<IHttpRpcComponent>()
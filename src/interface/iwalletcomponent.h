@@ -22,6 +22,13 @@ public:
         return ID;
     }
 
+    virtual int GetDependencies(state phase) const override
+    {
+        // the wallet rpc commands go into the rpc table after the core ones, wallet files are verified
+        // while the block index loads. Loading them rescans the chain and re-accepts transactions.
+        return phase == started ? CID_BLOCK_CHAIN | CID_TX_MEMPOOL | CID_P2P_NET : CID_HTTP_RPC;
+    }
+
     virtual bool ComponentInitialize() = 0;
 
     virtual bool ComponentStartup() = 0;
@@ -39,5 +46,5 @@ public:
 };
 
 #define GET_WALLET_INTERFACE(ifObj) \
-    auto ifObj = GetApp()->FindComponent<IWalletComponent>()
+    auto ifObj = appbase::IBaseApp::GetComponent<IWalletComponent>()
 
@@ -31,11 +31,10 @@ bool CMempoolComponent::ComponentInitialize()
     InitializeForNet();
 
     InitFeeEstimate();
-    GetMemPool().SetEstimator(&feeEstimator);
 
     if (Args().GetArg<bool>("-persistmempool", DEFAULT_PERSIST_MEMPOOL))
     {
-        LoadMempool();
+        ReadMempool();
         bDumpMempoolLater = true;
     }
     return true;
@@ -44,6 +43,14 @@ bool CMempoolComponent::ComponentInitialize()
 bool CMempoolComponent::ComponentStartup()
 {
     NLogStream() << "starting CTxMemPool component";
+
+    // the chain tip is known from here on
+    GetMemPool().SetEstimator(&feeEstimator);
+
+    if (bDumpMempoolLater)
+    {
+        LoadMempool();
+    }
     return true;
 }
 
@@ -64,10 +71,8 @@ CTxMemPool &CMempoolComponent::GetMemPool()
     return mempool;
 }
 
-bool CMempoolComponent::LoadMempool(void)
+bool CMempoolComponent::ReadMempool(void)
 {
-    const CChainParams &chainparams = Params();
-    int64_t nExpiryTimeout = Args().GetArg<uint32_t>("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60;
     FILE *filestr = fsbridge::fopen(Args().GetDataDir() / "mempool.dat", "rb");
     CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
     if (file.IsNull())
@@ -75,11 +80,6 @@ bool CMempoolComponent::LoadMempool(void)
         return rLogError("Failed to open mempool file from disk. Continuing anyway");
     }
 
-    int64_t count = 0;
-    int64_t skipped = 0;
-    int64_t failed = 0;
-    int64_t nNow = GetTime();
-
     try
     {
         uint64_t version;
@@ -92,48 +92,69 @@ bool CMempoolComponent::LoadMempool(void)
         file >> num;
         while (num--)
         {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta)
-            {
-                mempool.PrioritiseTransaction(tx->GetHash(), amountdelta);
-            }
-            CValidationState state;
-            if (nTime + nExpiryTimeout > nNow)
-            {
-                LOCK(cs);
-                mempool.AcceptToMemoryPoolWithTime(chainparams, state, tx, true, nullptr, nTime, nullptr, false, 0);
-                if (state.IsValid())
-                {
-                    ++count;
-                } else
-                {
-                    ++failed;
-                }
-            } else
-            {
-                ++skipped;
-            }
+            DiskMempoolTx diskTx;
+            file >> diskTx.tx;
+            file >> diskTx.nTime;
+            file >> diskTx.nFeeDelta;
+            vDiskMempool.push_back(std::move(diskTx));
             if (GetApp()->ShutdownRequested())
                 return false;
         }
-        std::map<uint256, CAmount> mapDeltas;
-        file >> mapDeltas;
+        file >> mapDiskMempoolDeltas;
+    } catch (const std::exception &e)
+    {
+        // what was read before the error is still accepted
+        mapDiskMempoolDeltas.clear();
+        return rLogError("Failed to deserialize mempool data on disk: %s. Continuing anyway", e.what());
+    }
+    return true;
+}
+
+bool CMempoolComponent::LoadMempool(void)
+{
+    const CChainParams &chainparams = Params();
+    int64_t nExpiryTimeout = Args().GetArg<uint32_t>("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60;
 
-        for (const auto &i : mapDeltas)
+    int64_t count = 0;
+    int64_t skipped = 0;
+    int64_t failed = 0;
+    int64_t nNow = GetTime();
+
+    std::vector<DiskMempoolTx> vTxs;
+    vTxs.swap(vDiskMempool);
+    for (const DiskMempoolTx &diskTx : vTxs)
+    {
+        CAmount amountdelta = diskTx.nFeeDelta;
+        if (amountdelta)
         {
-            mempool.PrioritiseTransaction(i.first, i.second);
+            mempool.PrioritiseTransaction(diskTx.tx->GetHash(), amountdelta);
         }
-    } catch (const std::exception &e)
+        CValidationState state;
+        if (diskTx.nTime + nExpiryTimeout > nNow)
+        {
+            LOCK(cs);
+            mempool.AcceptToMemoryPoolWithTime(chainparams, state, diskTx.tx, true, nullptr, diskTx.nTime, nullptr,
+                                               false, 0);
+            if (state.IsValid())
+            {
+                ++count;
+            } else
+            {
+                ++failed;
+            }
+        } else
+        {
+            ++skipped;
+        }
+        if (GetApp()->ShutdownRequested())
+            return false;
+    }
+
+    for (const auto &i : mapDiskMempoolDeltas)
     {
-        return rLogError("Failed to deserialize mempool data on disk: %s. Continuing anyway", e.what());
+        mempool.PrioritiseTransaction(i.first, i.second);
     }
+    mapDiskMempoolDeltas.clear();
 
     NLogFormat("Imported mempool transactions from disk: %i successes, %i failed, %i expired", count, failed,
                skipped);
@@ -59,7 +59,21 @@ private:
     /** Dump the mempool to disk. */
     void DumpMempool();
 
-    /** Load the mempool from disk. */
+    struct DiskMempoolTx
+    {
+        CTransactionRef tx;
+        int64_t nTime;
+        int64_t nFeeDelta;
+    };
+
+    //! mempool.dat as read during initialization, accepted into the mempool on startup
+    std::vector<DiskMempoolTx> vDiskMempool;
+    std::map<uint256, CAmount> mapDiskMempoolDeltas;
+
+    /** Read the mempool from disk. Needs no chain state, so it runs while the block index loads */
+    bool ReadMempool();
+
+    /** Accept the mempool read from disk into the mempool. */
     bool LoadMempool();
 
     void InitFeeEstimate();
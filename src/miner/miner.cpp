@@ -264,6 +264,8 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript &sc
 
     uint256 oldHashStateRoot, oldHashUTXORoot;
     ifContractObj->GetState(oldHashStateRoot, oldHashUTXORoot);
+    // contract txs are executed speculatively on top of the tip state, nothing of it is kept
+    CContractStateLayer stateLayer(ifContractObj);
 
     bool enablecontract = false;
     enablecontract = ifChainObj->IsSBTCForkContractEnabled(pindexPrev->nHeight);
@@ -314,7 +316,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript &sc
     }
     //    pblock->hashStateRoot = hashStateRoot;
     //    pblock->hashUTXORoot = hashUTXORoot;
-    ifContractObj->UpdateState(oldHashStateRoot, oldHashUTXORoot);
+    stateLayer.Discard();
 
     //this should already be populated by AddBlock in case of contracts, but if no contracts
     //then it won't get populated
@@ -401,9 +403,9 @@ bool BlockAssembler::TestPackageTransactions(const CTxMemPool::setEntries &packa
 //sbtc-vm
 bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64_t minGasPrice)
 {
-    uint256 oldHashStateRoot, oldHashUTXORoot;
     GET_CONTRACT_INTERFACE(ifContractObj);
-    ifContractObj->GetState(oldHashStateRoot, oldHashUTXORoot);
+    // execute in a child layer of the block's state, dropped again if the tx is not taken
+    CContractStateLayer stateLayer(ifContractObj);
     // operate on local vars first, then later apply to `this`
     uint64_t nBlockWeight = this->nBlockWeight;
     uint64_t nBlockSigOpsCost = this->nBlockSigOpsCost;
@@ -412,7 +414,6 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
     if (!ifContractObj->RunContractTx(iter->GetTx(), NULL, pblock, minGasPrice, hardBlockGasLimit, softBlockGasLimit,
                                       txGasLimit, bceResult.usedGas, testExecResult))
     {
-        ifContractObj->UpdateState(oldHashStateRoot, oldHashUTXORoot);
         return false;
     }
 
@@ -420,7 +421,6 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
     if (bceResult.usedGas + testExecResult.usedGas > softBlockGasLimit)
     {
         //if this transaction could cause block gas limit to be exceeded, then don't add it
-        ifContractObj->UpdateState(oldHashStateRoot, oldHashUTXORoot);
         return false;
     }
     NLogFormat("AttemptToAddContractToBlock4=====");
@@ -460,11 +460,11 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
         nBlockWeight > MAX_BLOCK_WEIGHT)
     {//sbtc-vm
         //contract will not be added to block, so revert state to before we tried
-        ifContractObj->UpdateState(oldHashStateRoot, oldHashUTXORoot);
         return false;
     }
 
     //block is not too big, so apply the contract execution and it's results to the actual block
+    stateLayer.Merge();
 
     //apply local bytecode to global bytecode state
     bceResult.usedGas += testExecResult.usedGas;
@@ -501,9 +501,7 @@ bool BlockAssembler::AttemptToAddContractToBlock(CTxMemPool::txiter iter, uint64
     }
     //calculate sigops from new refund/proof tx
     this->nBlockSigOpsCost -= (*pblock->vtx[proofTx]).GetLegacySigOpCount();
-    oldHashStateRoot.SetNull();// not update hashroot this moment
-    oldHashUTXORoot.SetNull();
-    RebuildRefundTransaction(oldHashStateRoot, oldHashUTXORoot);
+    RebuildRefundTransaction(uint256(), uint256()); // not update hashroot this moment
     this->nBlockSigOpsCost += (*pblock->vtx[proofTx]).GetLegacySigOpCount();
 
     bceResult.valueTransfers.clear();
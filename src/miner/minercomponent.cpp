@@ -19,11 +19,32 @@
 #include "interface/ichaincomponent.h"
 #include "utils/utilmoneystr.h"
 #include "framework/validationinterface.h"
+#include "utils/arith_uint256.h"
+#include "crypto/common.h"
+#include "crypto/sha256.h"
 
 SET_CPP_SCOPED_LOG_CATEGORY(CID_MINER);
 
 static const bool DEFAULT_GENERATE = false;
 static const int DEFAULT_GENERATE_THREADS = 1;
+/** Nonces a worker tries between two checks whether its template went stale */
+static const uint32_t MINER_STALE_CHECK_NONCES = 0x10000;
+/** Window of the hash rate meter, in milliseconds */
+static const int64_t MINER_HASHMETER_WINDOW = 4000;
+
+/** Template shared by the workers of one mining round */
+struct CMinerComponent::MiningRound
+{
+    CBlockHeader header;
+    CBlockIndex *pindexPrev;
+    unsigned int nTransactionsUpdatedLast;
+    int64_t nStart;
+    std::atomic<bool> fStop{false};
+
+    CCriticalSection cs;
+    bool fFound = false;
+    CBlockHeader found;
+};
 
 CMinerComponent::CMinerComponent()
 {
@@ -58,6 +79,28 @@ bool CMinerComponent::ComponentShutdown()
     return true;
 }
 
+double CMinerComponent::GetHashesPerSec()
+{
+    LOCK(cs);
+    return dHashesPerSec;
+}
+
+void CMinerComponent::CountHashes(uint64_t nHashes)
+{
+    LOCK(cs);
+    int64_t nNow = GetTimeMillis();
+    nHashesMetered += nHashes;
+    if (nHashMeterStart == 0)
+    {
+        nHashMeterStart = nNow;
+    } else if (nNow - nHashMeterStart >= MINER_HASHMETER_WINDOW)
+    {
+        dHashesPerSec = 1000.0 * nHashesMetered / (nNow - nHashMeterStart);
+        nHashesMetered = 0;
+        nHashMeterStart = nNow;
+    }
+}
+
 void CMinerComponent::GenerateBitcoins(bool fGenerate, int nThreads, const CChainParams &chainparams)
 {
     static boost::thread_group *minerThreads = NULL;
@@ -72,6 +115,13 @@ void CMinerComponent::GenerateBitcoins(bool fGenerate, int nThreads, const CChai
         minerThreads = NULL;
     }
 
+    {
+        LOCK(cs);
+        nHashesMetered = 0;
+        nHashMeterStart = 0;
+        dHashesPerSec = 0;
+    }
+
     if (nThreads == 0 || !fGenerate)
         return;
 
@@ -82,13 +132,12 @@ void CMinerComponent::GenerateBitcoins(bool fGenerate, int nThreads, const CChai
         throw std::runtime_error("Error: start sbtc miner failed! only start sbtc miner in regtest or testnet.");
 
     minerThreads = new boost::thread_group();
-    for (int i = 0; i < nThreads; i++)
-        minerThreads->create_thread(boost::bind(&CMinerComponent::SbtcMiner, this, boost::cref(chainparams)));
+    minerThreads->create_thread(boost::bind(&CMinerComponent::SbtcMiner, this, boost::cref(chainparams), nThreads));
 }
 
-void CMinerComponent::SbtcMiner(const CChainParams &chainparams)
+void CMinerComponent::SbtcMiner(const CChainParams &chainparams, int nThreads)
 {
-    NLogStream() << "SbtcMiner started\n";
+    NLogStream() << "SbtcMiner started with " << nThreads << " workers\n";
     SetThreadPriority(THREAD_PRIORITY_LOWEST);
     RenameThread("sbtc-miner");
 
@@ -150,45 +199,51 @@ void CMinerComponent::SbtcMiner(const CChainParams &chainparams)
             //
             // Search
             //
-            int64_t nStart = GetTime();
-            while (true)
+            MiningRound round;
+            round.header = pblock->GetBlockHeader();
+            round.pindexPrev = pindexPrev;
+            round.nTransactionsUpdatedLast = nTransactionsUpdatedLast;
+            round.nStart = GetTime();
+
+            boost::thread_group workers;
+            for (int i = 0; i < nThreads; i++)
+                workers.create_thread(boost::bind(&CMinerComponent::SbtcMinerWorker, this, boost::ref(round),
+                                                  pblock->nNonce + i, nThreads, boost::cref(chainparams)));
+            try
             {
-                if (CheckProofOfWork(pblock->GetHash(), pblock->nBits, Params().GetConsensus()))
-                {
-                    // Found a solution
-                    SetThreadPriority(THREAD_PRIORITY_NORMAL);
-                    ILogFormat("SbtcMiner:\n");
-                    ILogFormat("proof-of-work found  \n  hash: %s  \n", pblock->GetHash().GetHex());
-                    ProcessBlockFound(pblock, chainparams);
-                    SetThreadPriority(THREAD_PRIORITY_LOWEST);
-                    coinbaseScript->KeepScript();
-
-                    // In regression test mode, stop mining after a block is found.
-                    if (chainparams.MineBlocksOnDemand())
-                        throw boost::thread_interrupted();
-
-                    break;
-                }
+                workers.join_all();
+            }
+            catch (const boost::thread_interrupted &)
+            {
+                round.fStop = true;
+                workers.interrupt_all();
+                workers.join_all();
+                throw;
+            }
 
-                ++pblock->nNonce;
-                // Check for stop or if block needs to be rebuilt
-                boost::this_thread::interruption_point();
-                // Regtest mode doesn't require peers
-                if ((ifNetObj->GetNodeCount(CConnman::CONNECTIONS_ALL) == 0) && chainparams.MiningRequiresPeers())
-                    break;
-                if (pblock->nNonce >= 0xffff0000)
-                    break;
-                if (ifTxMempoolObj->GetMemPool().GetTransactionsUpdated() != nTransactionsUpdatedLast &&
-                    GetTime() - nStart > 60)
-                    break;
-                if (pindexPrev != ifChainObj->GetActiveChain().Tip())
-                    break;
-
-                // Update nTime every few seconds
-                if (UpdateTime(pblock, chainparams.GetConsensus(), pindexPrev) < 0)
-                    break; // Recreate the block if the clock has run backwards,
+            if (!round.fFound)
+                continue;
 
+            pblock->nTime = round.found.nTime;
+            pblock->nBits = round.found.nBits;
+            pblock->nNonce = round.found.nNonce;
+            if (!CheckProofOfWork(pblock->GetHash(), pblock->nBits, Params().GetConsensus()))
+            {
+                ELogFormat("SbtcMiner: midstate hash does not match block %s", pblock->GetHash().GetHex());
+                continue;
             }
+
+            // Found a solution
+            SetThreadPriority(THREAD_PRIORITY_NORMAL);
+            ILogFormat("SbtcMiner:\n");
+            ILogFormat("proof-of-work found  \n  hash: %s  \n", pblock->GetHash().GetHex());
+            ProcessBlockFound(pblock, chainparams);
+            SetThreadPriority(THREAD_PRIORITY_LOWEST);
+            coinbaseScript->KeepScript();
+
+            // In regression test mode, stop mining after a block is found.
+            if (chainparams.MineBlocksOnDemand())
+                throw boost::thread_interrupted();
         }
     }
     catch (const boost::thread_interrupted &)
@@ -203,6 +258,84 @@ void CMinerComponent::SbtcMiner(const CChainParams &chainparams)
     }
 }
 
+void CMinerComponent::SbtcMinerWorker(MiningRound &round, uint32_t nFirstNonce, uint32_t nStride,
+                                      const CChainParams &chainparams)
+{
+    SetThreadPriority(THREAD_PRIORITY_LOWEST);
+    RenameThread("sbtc-miner-worker");
+
+    GET_NET_INTERFACE(ifNetObj);
+    GET_CHAIN_INTERFACE(ifChainObj);
+    GET_TXMEMPOOL_INTERFACE(ifTxMempoolObj);
+
+    CBlockHeader header = round.header;
+    header.nNonce = nFirstNonce;
+
+    // The first 64 bytes of the header (version, previous block and most of the merkle root) do not
+    // change while scanning: hash them once and only run the last block of the first SHA-256 per nonce.
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << header;
+    assert(ss.size() == 80);
+    unsigned char data[80];
+    memcpy(data, ss.data(), 80);
+    CSHA256 midstate;
+    midstate.Write(data, 64);
+
+    arith_uint256 bnTarget;
+    bnTarget.SetCompact(header.nBits);
+
+    unsigned char buf[CSHA256::OUTPUT_SIZE];
+    uint256 hash;
+    while (!round.fStop)
+    {
+        uint32_t nHashes = 0;
+        for (; nHashes < MINER_STALE_CHECK_NONCES; ++nHashes)
+        {
+            WriteLE32(data + 76, header.nNonce);
+            CSHA256(midstate).Write(data + 64, 16).Finalize(buf);
+            CSHA256().Write(buf, sizeof(buf)).Finalize(hash.begin());
+            if (UintToArith256(hash) <= bnTarget)
+            {
+                CountHashes(nHashes + 1);
+                LOCK(round.cs);
+                if (!round.fFound)
+                {
+                    round.fFound = true;
+                    round.found = header;
+                }
+                round.fStop = true;
+                return;
+            }
+            if (header.nNonce >= 0xffff0000 - nStride)
+            {
+                round.fStop = true;
+                break;
+            }
+            header.nNonce += nStride;
+        }
+        CountHashes(nHashes);
+
+        // Check for stop or if block needs to be rebuilt
+        boost::this_thread::interruption_point();
+        // Regtest mode doesn't require peers
+        if ((ifNetObj->GetNodeCount(CConnman::CONNECTIONS_ALL) == 0) && chainparams.MiningRequiresPeers())
+            break;
+        if (ifTxMempoolObj->GetMemPool().GetTransactionsUpdated() != round.nTransactionsUpdatedLast &&
+            GetTime() - round.nStart > 60)
+            break;
+        if (round.pindexPrev != ifChainObj->GetActiveChain().Tip())
+            break;
+
+        // Update nTime every few seconds
+        if (UpdateTime(&header, chainparams.GetConsensus(), round.pindexPrev) < 0)
+            break; // Recreate the block if the clock has run backwards,
+        WriteLE32(data + 68, header.nTime);
+        WriteLE32(data + 72, header.nBits);
+        bnTarget.SetCompact(header.nBits);
+    }
+    round.fStop = true;
+}
+
 bool CMinerComponent::ProcessBlockFound(const CBlock *pblock, const CChainParams &chainparams)
 {
     ILogFormat("%s\n", pblock->ToString());
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 #include <log4cpp/Category.hh>
 #include "util.h"
 #include "interface/iminercomponent.h"
@@ -24,14 +25,28 @@ public:
 
     bool ComponentShutdown() override;
 
+    double GetHashesPerSec() override;
+
 private:
+    struct MiningRound;
 
     CCriticalSection cs;
 
+    /** Hash rate meter, guarded by cs */
+    uint64_t nHashesMetered = 0;
+    int64_t nHashMeterStart = 0;
+    double dHashesPerSec = 0;
+
     /** Run the miner threads */
     void GenerateBitcoins(bool fGenerate, int nThreads, const CChainParams &chainparams);
 
-    void SbtcMiner(const CChainParams &chainparams);
+    /** Builds the block templates and runs nThreads workers over each of them */
+    void SbtcMiner(const CChainParams &chainparams, int nThreads);
+
+    /** Scans the nonces nFirstNonce, nFirstNonce + nStride, ... of the round's template */
+    void SbtcMinerWorker(MiningRound &round, uint32_t nFirstNonce, uint32_t nStride, const CChainParams &chainparams);
+
+    void CountHashes(uint64_t nHashes);
 
     bool ProcessBlockFound(const CBlock *pblock, const CChainParams &chainparams);
 };
\ No newline at end of file
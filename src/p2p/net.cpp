@@ -32,9 +32,15 @@
 #else
 
 #include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/miniwget.h>
@@ -51,6 +57,12 @@
 // We add a random period time (0 to 1 seconds) to feeler connections to prevent synchronization.
 #define FEELER_SLEEP_WINDOW 1
 
+// Max number of header and payload buffers handed to a single scatter/gather send.
+#define MAX_SEND_SEGMENTS 64
+
+// Max number of readiness events taken from epoll per wakeup.
+#define MAX_EPOLL_EVENTS 1024
+
 #if !defined(HAVE_MSG_NOSIGNAL)
 #define MSG_NOSIGNAL 0
 #endif
@@ -375,7 +387,7 @@ CNode *CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
                                       &proxyConnectionFailed) :
         ConnectSocket(addrConnect, hSocket, nConnectTimeout, &proxyConnectionFailed))
     {
-        if (!IsSelectableSocket(hSocket))
+        if (!IsPollableSocket(hSocket))
         {
             WLogFormat("Cannot create connection: non-selectable socket created (fd >= FD_SETSIZE ?)");
             CloseSocket(hSocket);
@@ -687,6 +699,10 @@ void CNode::copyStats(CNodeStats &stats)
         X(mapRecvBytesPerMsgCmd);
         X(nRecvBytes);
     }
+    {
+        LOCK(cs_msgLatency);
+        X(mapLatencyPerMsgCmd);
+    }
     X(fWhitelisted);
 
     // It is common for nodes with good ping times to suddenly become lagged,
@@ -711,6 +727,19 @@ void CNode::copyStats(CNodeStats &stats)
     stats.addrLocal = addrLocalUnlocked.IsValid() ? addrLocalUnlocked.ToString() : "";
 }
 
+void CNode::RecordMessageLatency(const std::string &command, int64_t nWaitMicros, int64_t nMicros)
+{
+    LOCK(cs_msgLatency);
+    mapMsgCmdLatency::iterator i = mapLatencyPerMsgCmd.find(command);
+    if (i == mapLatencyPerMsgCmd.end())
+        i = mapLatencyPerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
+    assert(i != mapLatencyPerMsgCmd.end());
+    i->second.nCount++;
+    i->second.nTotalWaitMicros += nWaitMicros;
+    i->second.nTotalMicros += nMicros;
+    i->second.nMaxMicros = std::max(i->second.nMaxMicros, nMicros);
+}
+
 #undef X
 
 bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool &complete)
@@ -862,36 +891,86 @@ const uint256 &CNetMessage::GetMessageHash() const
 // requires LOCK(cs_vSend)
 size_t CConnman::SocketSendData(CNode *pnode) const
 {
+    struct SendSegment
+    {
+        const unsigned char *data;
+        size_t size;
+    };
+
     auto it = pnode->vSendMsg.begin();
     size_t nSentSize = 0;
 
     while (it != pnode->vSendMsg.end())
     {
-        const auto &data = *it;
-        assert(data.size() > pnode->nSendOffset);
+        // gather the unsent header and payload segments of as many queued messages as fit in one send
+        SendSegment segments[MAX_SEND_SEGMENTS];
+        size_t nSegments = 0;
+        size_t nGathered = 0;
+        size_t nOffset = pnode->nSendOffset;
+        for (auto itGather = it; itGather != pnode->vSendMsg.end() && nSegments + 2 <= MAX_SEND_SEGMENTS;
+             ++itGather, nOffset = 0)
+        {
+            const CNetMessageBuffer &msg = **itGather;
+            assert(msg.size() > nOffset);
+            if (nOffset < CMessageHeader::HEADER_SIZE)
+                segments[nSegments++] = {msg.GetHeader() + nOffset, CMessageHeader::HEADER_SIZE - nOffset};
+            size_t nPayloadOffset = nOffset > CMessageHeader::HEADER_SIZE ? nOffset - CMessageHeader::HEADER_SIZE : 0;
+            if (nPayloadOffset < msg.GetPayload().size())
+                segments[nSegments++] = {msg.GetPayload().data() + nPayloadOffset,
+                                         msg.GetPayload().size() - nPayloadOffset};
+            nGathered += msg.size() - nOffset;
+        }
+
         int nBytes = 0;
         {
             LOCK(pnode->cs_hSocket);
             if (pnode->hSocket == INVALID_SOCKET)
                 break;
-            nBytes = send(pnode->hSocket, reinterpret_cast<const char *>(data.data()) + pnode->nSendOffset,
-                          data.size() - pnode->nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+#ifdef WIN32
+            // no scatter/gather send here, write the segments one at a time
+            nGathered = segments[0].size;
+            nBytes = send(pnode->hSocket, reinterpret_cast<const char *>(segments[0].data), segments[0].size,
+                          MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+            struct iovec iov[MAX_SEND_SEGMENTS];
+            for (size_t i = 0; i < nSegments; i++)
+            {
+                iov[i].iov_base = const_cast<unsigned char *>(segments[i].data);
+                iov[i].iov_len = segments[i].size;
+            }
+            struct msghdr msghdr;
+            memset(&msghdr, 0, sizeof(msghdr));
+            msghdr.msg_iov = iov;
+            msghdr.msg_iovlen = nSegments;
+            nBytes = sendmsg(pnode->hSocket, &msghdr, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
         }
         if (nBytes > 0)
         {
             pnode->nLastSend = GetSystemTimeInSeconds();
             pnode->nSendBytes += nBytes;
-            pnode->nSendOffset += nBytes;
             nSentSize += nBytes;
-            if (pnode->nSendOffset == data.size())
+
+            // retire the messages that went out completely
+            size_t nLeft = nBytes;
+            while (nLeft > 0)
             {
+                size_t nMessageLeft = (*it)->size() - pnode->nSendOffset;
+                if (nLeft < nMessageLeft)
+                {
+                    pnode->nSendOffset += nLeft;
+                    break;
+                }
+                nLeft -= nMessageLeft;
                 pnode->nSendOffset = 0;
-                pnode->nSendSize -= data.size();
-                pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
+                pnode->nSendSize -= (*it)->size();
                 it++;
-            } else
+            }
+            pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
+
+            if ((size_t)nBytes < nGathered)
             {
-                // could not send full message; stop sending more
+                // could not send everything gathered; stop sending more
                 break;
             }
         } else
@@ -1129,7 +1208,7 @@ void CConnman::AcceptConnection(const ListenSocket &hListenSocket)
         return;
     }
 
-    if (!IsSelectableSocket(hSocket))
+    if (!IsPollableSocket(hSocket))
     {
         WLogFormat("connection from %s dropped: non-selectable socket", addr.ToString());
         CloseSocket(hSocket);
@@ -1176,6 +1255,7 @@ void CConnman::AcceptConnection(const ListenSocket &hListenSocket)
         vNodes.push_back(pnode);
         totalNodeCount = (int)vNodes.size();
     }
+    RegisterSocketEvents(pnode);
 
     GetApp()->GetEventManager().PostEvent(EID_NODE_CONNECTED, id, true, totalNodeCount);
 
@@ -1199,6 +1279,8 @@ void CConnman::ThreadSocketHandler()
                 {
                     // remove from vNodes
                     vNodes.erase(remove(vNodes.begin(), vNodes.end(), pnode), vNodes.end());
+                    vNodesPendingRecv.erase(remove(vNodesPendingRecv.begin(), vNodesPendingRecv.end(), pnode),
+                                            vNodesPendingRecv.end());
 
                     // release outbound grant (if any)
                     pnode->grantOutbound.Release();
@@ -1252,236 +1334,412 @@ void CConnman::ThreadSocketHandler()
                 clientInterface->NotifyNumConnectionsChanged(nPrevNodeCount);
         }
 
-        //
-        // Find which sockets have data to receive
-        //
-        struct timeval timeout;
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
+        if (!(hEpoll != -1 ? SocketHandlerEpoll() : SocketHandlerSelect()))
+            return;
+    }
+}
 
-        for (const ListenSocket &hListenSocket : vhListenSocket)
-        {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
-        }
+bool CConnman::SocketHandlerSelect()
+{
+    //
+    // Find which sockets have data to receive
+    //
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 50000; // frequency to poll pnode->vSend
 
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+
+    for (const ListenSocket &hListenSocket : vhListenSocket)
+    {
+        FD_SET(hListenSocket.socket, &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, hListenSocket.socket);
+        have_fds = true;
+    }
+
+    {
+        LOCK(cs_vNodes);
+        for (CNode *pnode : vNodes)
         {
-            LOCK(cs_vNodes);
-            for (CNode *pnode : vNodes)
+            // Implement the following logic:
+            // * If there is data to send, select() for sending data. As this only
+            //   happens when optimistic write failed, we choose to first drain the
+            //   write buffer in this case before receiving more. This avoids
+            //   needlessly queueing received data, if the remote peer is not themselves
+            //   receiving data. This means properly utilizing TCP flow control signalling.
+            // * Otherwise, if there is space left in the receive buffer, select() for
+            //   receiving data.
+            // * Hand off all complete messages to the processor, to be handled without
+            //   blocking here.
+
+            bool select_recv = !pnode->fPauseRecv;
+            bool select_send;
             {
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is space left in the receive buffer, select() for
-                //   receiving data.
-                // * Hand off all complete messages to the processor, to be handled without
-                //   blocking here.
-
-                bool select_recv = !pnode->fPauseRecv;
-                bool select_send;
-                {
-                    LOCK(pnode->cs_vSend);
-                    select_send = !pnode->vSendMsg.empty();
-                }
+                LOCK(pnode->cs_vSend);
+                select_send = !pnode->vSendMsg.empty();
+            }
 
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
 
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
+            FD_SET(pnode->hSocket, &fdsetError);
+            hSocketMax = std::max(hSocketMax, pnode->hSocket);
+            have_fds = true;
 
-                if (select_send)
-                {
-                    FD_SET(pnode->hSocket, &fdsetSend);
-                    continue;
-                }
-                if (select_recv)
-                {
-                    FD_SET(pnode->hSocket, &fdsetRecv);
-                }
+            if (select_send)
+            {
+                FD_SET(pnode->hSocket, &fdsetSend);
+                continue;
+            }
+            if (select_recv)
+            {
+                FD_SET(pnode->hSocket, &fdsetRecv);
             }
         }
+    }
 
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        if (interruptNet)
-            return;
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                         &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    if (interruptNet)
+        return false;
 
-        if (nSelect == SOCKET_ERROR)
+    if (nSelect == SOCKET_ERROR)
+    {
+        if (have_fds)
         {
-            if (have_fds)
-            {
-                int nErr = WSAGetLastError();
-                NLogFormat("socket select error %s", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec / 1000)))
-                return;
+            int nErr = WSAGetLastError();
+            NLogFormat("socket select error %s", NetworkErrorString(nErr));
+            for (unsigned int i = 0; i <= hSocketMax; i++)
+                FD_SET(i, &fdsetRecv);
         }
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec / 1000)))
+            return false;
+    }
+
+    //
+    // Accept new connections
+    //
+    for (const ListenSocket &hListenSocket : vhListenSocket)
+    {
+        if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
+        {
+            AcceptConnection(hListenSocket);
+        }
+    }
+
+    //
+    // Service each socket
+    //
+    std::vector<CNode *> vNodesCopy;
+    {
+        LOCK(cs_vNodes);
+        vNodesCopy = vNodes;
+        for (CNode *pnode : vNodesCopy)
+            pnode->AddRef();
+    }
+    for (CNode *pnode : vNodesCopy)
+    {
+        if (interruptNet)
+            return false;
 
         //
-        // Accept new connections
+        // Receive
         //
-        for (const ListenSocket &hListenSocket : vhListenSocket)
+        bool recvSet = false;
+        bool sendSet = false;
+        bool errorSet = false;
         {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
-            {
-                AcceptConnection(hListenSocket);
-            }
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+            recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
+            sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
+            errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
+        }
+        if (recvSet || errorSet)
+        {
+            SocketRecvData(pnode);
         }
 
         //
-        // Service each socket
+        // Send
         //
-        std::vector<CNode *> vNodesCopy;
+        if (sendSet)
         {
-            LOCK(cs_vNodes);
-            vNodesCopy = vNodes;
-            for (CNode *pnode : vNodesCopy)
-                pnode->AddRef();
+            LOCK(pnode->cs_vSend);
+            size_t nBytes = SocketSendData(pnode);
+            if (nBytes)
+            {
+                RecordBytesSent(nBytes);
+            }
         }
+
+        InactivityCheck(pnode);
+    }
+    {
+        LOCK(cs_vNodes);
         for (CNode *pnode : vNodesCopy)
+            pnode->Release();
+    }
+    return true;
+}
+
+bool CConnman::SocketHandlerEpoll()
+{
+#ifdef HAVE_SYS_EPOLL_H
+    // Sockets are registered edge-triggered, so a node that still holds unread data is not reported
+    // again until more arrives. Those nodes stay in vNodesPendingRecv and are serviced without waiting,
+    // unless their receive is paused or their send queue has to drain first.
+    int nTimeout = 50; // frequency to check for inactivity and paused receives
+    for (CNode *pnode : vNodesPendingRecv)
+    {
+        LOCK(pnode->cs_vSend);
+        if (!pnode->fPauseRecv && pnode->vSendMsg.empty())
         {
-            if (interruptNet)
-                return;
+            nTimeout = 0;
+            break;
+        }
+    }
+
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    int nEvents = epoll_wait(hEpoll, events, MAX_EPOLL_EVENTS, nTimeout);
+    if (interruptNet)
+        return false;
+
+    if (nEvents < 0)
+    {
+        int nErr = errno;
+        nEvents = 0;
+        if (nErr != EINTR)
+        {
+            NLogFormat("socket epoll_wait error %s", NetworkErrorString(nErr));
+            if (!interruptNet.sleep_for(std::chrono::milliseconds(nTimeout)))
+                return false;
+        }
+    }
 
-            //
-            // Receive
-            //
-            bool recvSet = false;
-            bool sendSet = false;
-            bool errorSet = false;
+    //
+    // Accept new connections and collect the nodes that reported readiness
+    //
+    std::vector<CNode *> vNodesReady;
+    for (int i = 0; i < nEvents; i++)
+    {
+        const ListenSocket *pListenSocket = nullptr;
+        for (const ListenSocket &hListenSocket : vhListenSocket)
+            if (events[i].data.ptr == &hListenSocket)
+                pListenSocket = &hListenSocket;
+        if (pListenSocket)
+        {
+            AcceptConnection(*pListenSocket);
+            continue;
+        }
+
+        // Nodes are deleted by this thread only, and a socket leaves the epoll set when it is closed,
+        // which happens before its node is deleted.
+        CNode *pnode = static_cast<CNode *>(events[i].data.ptr);
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+        {
+            // a closed or failed socket is reported through recv
+            if (!pnode->fPendingRecv)
             {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
-                sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
-                errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
-            }
-            if (recvSet || errorSet)
-            {
-                // typical socket buffer is 8K-64K
-                char pchBuf[0x10000];
-                int nBytes = 0;
-                {
-                    LOCK(pnode->cs_hSocket);
-                    if (pnode->hSocket == INVALID_SOCKET)
-                        continue;
-                    nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-                }
-                if (nBytes > 0)
-                {
-                    bool notify = false;
-                    if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
-                        pnode->CloseSocketDisconnect();
-                    RecordBytesRecv(nBytes);
-                    if (notify)
-                    {
-                        size_t nSizeAdded = 0;
-                        auto it(pnode->vRecvMsg.begin());
-                        for (; it != pnode->vRecvMsg.end(); ++it)
-                        {
-                            if (!it->complete())
-                                break;
-                            nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
-                        }
-                        {
-                            LOCK(pnode->cs_vProcessMsg);
-                            pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg,
-                                                      pnode->vRecvMsg.begin(), it);
-                            pnode->nProcessQueueSize += nSizeAdded;
-                            pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
-                        }
-                        WakeMessageHandler();
-                    }
-                } else if (nBytes == 0)
-                {
-                    // socket closed gracefully
-                    if (!pnode->fDisconnect)
-                    {
-                        NLogFormat("socket closed");
-                    }
-                    pnode->CloseSocketDisconnect();
-                } else if (nBytes < 0)
-                {
-                    // error
-                    int nErr = WSAGetLastError();
-                    if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                    {
-                        if (!pnode->fDisconnect)
-                            ELogFormat("socket recv error %s", NetworkErrorString(nErr));
-                        pnode->CloseSocketDisconnect();
-                    }
-                }
+                pnode->fPendingRecv = true;
+                vNodesPendingRecv.push_back(pnode);
             }
+        }
+        if (events[i].events & EPOLLOUT)
+            vNodesReady.push_back(pnode);
+    }
+    vNodesReady.insert(vNodesReady.end(), vNodesPendingRecv.begin(), vNodesPendingRecv.end());
+    std::sort(vNodesReady.begin(), vNodesReady.end());
+    vNodesReady.erase(std::unique(vNodesReady.begin(), vNodesReady.end()), vNodesReady.end());
+
+    //
+    // Service the ready sockets
+    //
+    {
+        LOCK(cs_vNodes);
+        for (CNode *pnode : vNodesReady)
+            pnode->AddRef();
+    }
+    for (CNode *pnode : vNodesReady)
+    {
+        if (interruptNet)
+            return false;
 
-            //
-            // Send
-            //
-            if (sendSet)
+        // Drain the send queue before receiving more, as the select() handler does
+        bool fSendPending;
+        {
+            LOCK(pnode->cs_vSend);
+            if (!pnode->vSendMsg.empty())
             {
-                LOCK(pnode->cs_vSend);
                 size_t nBytes = SocketSendData(pnode);
                 if (nBytes)
                 {
                     RecordBytesSent(nBytes);
                 }
             }
+            fSendPending = !pnode->vSendMsg.empty();
+        }
+
+        if (pnode->fPendingRecv && !fSendPending && !pnode->fPauseRecv)
+            pnode->fPendingRecv = SocketRecvData(pnode);
+    }
+    vNodesPendingRecv.erase(std::remove_if(vNodesPendingRecv.begin(), vNodesPendingRecv.end(),
+                                           [](const CNode *pnode) { return !pnode->fPendingRecv; }),
+                            vNodesPendingRecv.end());
+    {
+        LOCK(cs_vNodes);
+        for (CNode *pnode : vNodesReady)
+            pnode->Release();
+    }
+
+    //
+    // Inactivity checking, once a second across all nodes
+    //
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime != nLastInactivityCheck)
+    {
+        nLastInactivityCheck = nTime;
+        LOCK(cs_vNodes);
+        for (CNode *pnode : vNodes)
+            InactivityCheck(pnode);
+    }
+    return true;
+#else
+    return SocketHandlerSelect();
+#endif
+}
+
+void CConnman::RegisterSocketEvents(CNode *pnode)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    if (hEpoll == -1)
+        return;
+
+    int nErr = 0;
+    {
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET)
+            return;
 
-            //
-            // Inactivity checking
-            //
-            int64_t nTime = GetSystemTimeInSeconds();
-            if (nTime - pnode->nTimeConnected > 60)
+        // Edge-triggered: the registration lasts as long as the socket, and is never rearmed
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = pnode;
+        if (epoll_ctl(hEpoll, EPOLL_CTL_ADD, pnode->hSocket, &event) != 0)
+            nErr = errno;
+    }
+    if (nErr != 0)
+    {
+        ELogFormat("epoll_ctl failed for peer=%d: %s", pnode->GetId(), NetworkErrorString(nErr));
+        pnode->fDisconnect = true;
+    }
+#endif
+}
+
+bool CConnman::IsPollableSocket(const SOCKET &hSocket) const
+{
+    return hEpoll != -1 || IsSelectableSocket(hSocket);
+}
+
+bool CConnman::SocketRecvData(CNode *pnode)
+{
+    // typical socket buffer is 8K-64K
+    char pchBuf[0x10000];
+    int nBytes = 0;
+    {
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET)
+            return false;
+        nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+    }
+    if (nBytes > 0)
+    {
+        bool notify = false;
+        if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
+            pnode->CloseSocketDisconnect();
+        RecordBytesRecv(nBytes);
+        if (notify)
+        {
+            size_t nSizeAdded = 0;
+            auto it(pnode->vRecvMsg.begin());
+            for (; it != pnode->vRecvMsg.end(); ++it)
             {
-                if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
-                {
-                    NLogFormat("socket no message in first 60 seconds, %d %d from %d",
-                                pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->GetId());
-                    pnode->fDisconnect = true;
-                } else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
-                {
-                    NLogFormat("socket sending timeout: %is", nTime - pnode->nLastSend);
-                    pnode->fDisconnect = true;
-                } else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90 * 60))
-                {
-                    NLogFormat("socket receive timeout: %is", nTime - pnode->nLastRecv);
-                    pnode->fDisconnect = true;
-                } else if (pnode->nPingNonceSent &&
-                           pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
-                {
-                    NLogFormat("ping timeout: %fs", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
-                    pnode->fDisconnect = true;
-                } else if (!pnode->fSuccessfullyConnected)
-                {
-                    NLogFormat("version handshake timeout from %d", pnode->GetId());
-                    pnode->fDisconnect = true;
-                }
+                if (!it->complete())
+                    break;
+                nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
             }
+            {
+                LOCK(pnode->cs_vProcessMsg);
+                pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg,
+                                          pnode->vRecvMsg.begin(), it);
+                pnode->nProcessQueueSize += nSizeAdded;
+                pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+            }
+            WakeMessageHandler(pnode->GetId());
         }
+        return nBytes == (int)sizeof(pchBuf);
+    } else if (nBytes == 0)
+    {
+        // socket closed gracefully
+        if (!pnode->fDisconnect)
         {
-            LOCK(cs_vNodes);
-            for (CNode *pnode : vNodesCopy)
-                pnode->Release();
+            NLogFormat("socket closed");
+        }
+        pnode->CloseSocketDisconnect();
+    } else if (nBytes < 0)
+    {
+        // error
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
+        {
+            if (!pnode->fDisconnect)
+                ELogFormat("socket recv error %s", NetworkErrorString(nErr));
+            pnode->CloseSocketDisconnect();
+        }
+        // interrupted before anything was read
+        return nErr == WSAEINTR;
+    }
+    return false;
+}
+
+void CConnman::InactivityCheck(CNode *pnode)
+{
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime - pnode->nTimeConnected > 60)
+    {
+        if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
+        {
+            NLogFormat("socket no message in first 60 seconds, %d %d from %d",
+                        pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->GetId());
+            pnode->fDisconnect = true;
+        } else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
+        {
+            NLogFormat("socket sending timeout: %is", nTime - pnode->nLastSend);
+            pnode->fDisconnect = true;
+        } else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90 * 60))
+        {
+            NLogFormat("socket receive timeout: %is", nTime - pnode->nLastRecv);
+            pnode->fDisconnect = true;
+        } else if (pnode->nPingNonceSent &&
+                   pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
+        {
+            NLogFormat("ping timeout: %fs", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
+            pnode->fDisconnect = true;
+        } else if (!pnode->fSuccessfullyConnected)
+        {
+            NLogFormat("version handshake timeout from %d", pnode->GetId());
+            pnode->fDisconnect = true;
         }
     }
 }
@@ -1490,9 +1748,21 @@ void CConnman::WakeMessageHandler()
 {
     {
         std::lock_guard<std::mutex> lock(mutexMsgProc);
-        fMsgProcWake = true;
+        vMsgProcWake.assign(vMsgProcWake.size(), true);
     }
-    condMsgProc.notify_one();
+    condMsgProc.notify_all();
+}
+
+void CConnman::WakeMessageHandler(NodeId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexMsgProc);
+        if (vMsgProcWake.empty())
+            return;
+        vMsgProcWake[GetMessageHandlerShard(id)] = true;
+    }
+    // the shards share one condition variable, each waits for its own flag
+    condMsgProc.notify_all();
 }
 
 
@@ -2102,21 +2372,25 @@ bool CConnman::OpenNetworkConnection(const CAddress &addrConnect, bool fCountFai
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
     }
+    RegisterSocketEvents(pnode);
 
     return true;
 }
 
-void CConnman::ThreadMessageHandler()
+void CConnman::ThreadMessageHandler(int nShard)
 {
     while (!flagInterruptMsgProc)
     {
         std::vector<CNode *> vNodesCopy;
         {
             LOCK(cs_vNodes);
-            vNodesCopy = vNodes;
-            for (CNode *pnode : vNodesCopy)
+            for (CNode *pnode : vNodes)
             {
+                // A node is always handled by the same thread, which keeps its messages in order
+                if (GetMessageHandlerShard(pnode->GetId()) != nShard)
+                    continue;
                 pnode->AddRef();
+                vNodesCopy.push_back(pnode);
             }
         }
 
@@ -2151,10 +2425,10 @@ void CConnman::ThreadMessageHandler()
         std::unique_lock<std::mutex> lock(mutexMsgProc);
         if (!fMoreWork)
         {
-            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this]
-            { return fMsgProcWake; });
+            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this, nShard]
+            { return vMsgProcWake[nShard]; });
         }
-        fMsgProcWake = false;
+        vMsgProcWake[nShard] = false;
     }
 }
 
@@ -2352,6 +2626,9 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In)
     semOutbound = nullptr;
     semAddnode = nullptr;
     flagInterruptMsgProc = false;
+    nMessageHandlerThreads = 1;
+    hEpoll = -1;
+    nLastInactivityCheck = 0;
     SetTryNewOutboundPeer(false);
 
     Options connOptions;
@@ -2489,8 +2766,35 @@ bool CConnman::Start(CScheduler &scheduler, const Options &connOptions)
 
     {
         std::unique_lock<std::mutex> lock(mutexMsgProc);
-        fMsgProcWake = false;
+        vMsgProcWake.assign(nMessageHandlerThreads, false);
+    }
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (socketEventsMode == SOCKETEVENTS_EPOLL && hEpoll == -1)
+    {
+        hEpoll = epoll_create1(EPOLL_CLOEXEC);
+        if (hEpoll == -1)
+        {
+            WLogFormat("epoll_create1 failed: %s, falling back to select()", NetworkErrorString(errno));
+        }
+        for (const ListenSocket &hListenSocket : vhListenSocket)
+        {
+            if (hEpoll == -1)
+                break;
+            // level-triggered, one connection is accepted per wakeup as with select()
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = const_cast<ListenSocket *>(&hListenSocket);
+            if (epoll_ctl(hEpoll, EPOLL_CTL_ADD, hListenSocket.socket, &event) != 0)
+            {
+                WLogFormat("epoll_ctl failed for a listening socket: %s, falling back to select()",
+                           NetworkErrorString(errno));
+                close(hEpoll);
+                hEpoll = -1;
+            }
+        }
     }
+#endif
 
     // Send and receive from sockets, accept connections
     threadSocketHandler = std::thread(&TraceThread<std::function<void()> >, "net",
@@ -2513,8 +2817,16 @@ bool CConnman::Start(CScheduler &scheduler, const Options &connOptions)
                                             std::function<void()>(std::bind(&CConnman::ThreadOpenConnections, this)));
 
     // Process messages
-    threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand",
-                                       std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
+    vMessageHandlerNames.clear();
+    for (int i = 0; i < nMessageHandlerThreads; i++)
+    {
+        vMessageHandlerNames.push_back(i == 0 ? std::string("msghand") : strprintf("msghand.%d", i));
+    }
+    for (int i = 0; i < nMessageHandlerThreads; i++)
+    {
+        threadMessageHandlers.push_back(std::thread(&TraceThread<std::function<void()> >, vMessageHandlerNames[i].c_str(),
+                                                    std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this, i))));
+    }
 
     // Dump network addresses
     scheduler.scheduleEvery(std::bind(&CConnman::DumpData, this), DUMP_ADDRESSES_INTERVAL * 1000);
@@ -2568,8 +2880,12 @@ void CConnman::Interrupt()
 
 void CConnman::Stop()
 {
-    if (threadMessageHandler.joinable())
-        threadMessageHandler.join();
+    for (std::thread &threadMessageHandler : threadMessageHandlers)
+    {
+        if (threadMessageHandler.joinable())
+            threadMessageHandler.join();
+    }
+    threadMessageHandlers.clear();
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -2604,7 +2920,15 @@ void CConnman::Stop()
     }
     vNodes.clear();
     vNodesDisconnected.clear();
+    vNodesPendingRecv.clear();
     vhListenSocket.clear();
+#ifdef HAVE_SYS_EPOLL_H
+    if (hEpoll != -1)
+    {
+        close(hEpoll);
+        hEpoll = -1;
+    }
+#endif
     delete semOutbound;
     semOutbound = nullptr;
     delete semAddnode;
@@ -2939,11 +3263,16 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     nextSendTimeFeeFilter = 0;
     fPauseRecv = false;
     fPauseSend = false;
+    fPendingRecv = false;
     nProcessQueueSize = 0;
 
     for (const std::string &msg : getAllNetMessageTypes())
+    {
         mapRecvBytesPerMsgCmd[msg] = 0;
+        mapLatencyPerMsgCmd[msg];
+    }
     mapRecvBytesPerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = 0;
+    mapLatencyPerMsgCmd[NET_MESSAGE_COMMAND_OTHER];
 
     NLogFormat("Added connection to %s peer=%d", addrName, id);
 }
@@ -2996,25 +3325,38 @@ bool CConnman::NodeFullyConnected(const CNode *pnode)
     return pnode && pnode->fSuccessfullyConnected && !pnode->fDisconnect;
 }
 
+CNetMessageBuffer::CNetMessageBuffer(const std::string &commandIn, Payload payloadIn)
+        : command(commandIn), payload(std::move(payloadIn))
+{
+    size_t nMessageSize = payload->size();
+    uint256 hash = Hash(payload->data(), payload->data() + nMessageSize);
+    CMessageHeader hdr(Params().MessageStart(), command.c_str(), nMessageSize);
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+
+    std::vector<unsigned char> serializedHeader;
+    serializedHeader.reserve(CMessageHeader::HEADER_SIZE);
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, serializedHeader, 0, hdr};
+    assert(serializedHeader.size() == CMessageHeader::HEADER_SIZE);
+    memcpy(header, serializedHeader.data(), CMessageHeader::HEADER_SIZE);
+}
+
 void CConnman::PushMessage(CNode *pnode, CSerializedNetMsg &&msg)
 {
-    PushMessage(pnode, msg.command, msg.data);
+    PushMessage(pnode, std::make_shared<const CNetMessageBuffer>(
+            msg.command, std::make_shared<const std::vector<unsigned char>>(std::move(msg.data))));
 }
 
 void CConnman::PushMessage(CNode *pnode, const std::string &command, const std::vector<unsigned char> &data)
 {
-    size_t nMessageSize = data.size();
-    size_t nTotalSize = nMessageSize + CMessageHeader::HEADER_SIZE;
-    NLogFormat("sending %s (%d bytes) peer=%d", SanitizeString(command.c_str()), nMessageSize,
-             pnode->GetId());
-
-    std::vector<unsigned char> serializedHeader;
-    serializedHeader.reserve(CMessageHeader::HEADER_SIZE);
-    uint256 hash = Hash(data.data(), data.data() + nMessageSize);
-    CMessageHeader hdr(Params().MessageStart(), command.c_str(), nMessageSize);
-    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    PushMessage(pnode, std::make_shared<const CNetMessageBuffer>(
+            command, std::make_shared<const std::vector<unsigned char>>(data)));
+}
 
-    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, serializedHeader, 0, hdr};
+void CConnman::PushMessage(CNode *pnode, const CNetMessageBufferRef &msg)
+{
+    size_t nTotalSize = msg->size();
+    NLogFormat("sending %s (%d bytes) peer=%d", SanitizeString(msg->GetCommand().c_str()), msg->GetPayload().size(),
+             pnode->GetId());
 
     size_t nBytesSent = 0;
     {
@@ -3022,14 +3364,12 @@ void CConnman::PushMessage(CNode *pnode, const std::string &command, const std::
         bool optimisticSend(pnode->vSendMsg.empty());
 
         //log total amount of bytes per command
-        pnode->mapSendBytesPerMsgCmd[command] += nTotalSize;
+        pnode->mapSendBytesPerMsgCmd[msg->GetCommand()] += nTotalSize;
         pnode->nSendSize += nTotalSize;
 
         if (pnode->nSendSize > nSendBufferMaxSize)
             pnode->fPauseSend = true;
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
-        if (nMessageSize)
-            pnode->vSendMsg.push_back(std::move(data));
+        pnode->vSendMsg.push_back(msg);
 
         // If write queue empty, attempt "optimistic write"
         if (optimisticSend == true)
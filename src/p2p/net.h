@@ -88,6 +88,23 @@ static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER = 1 * 1000;
 
+/** Default number of message handler threads; each peer is pinned to one of them */
+static const int DEFAULT_MSGHANDLER_THREADS = 4;
+static const int MAX_MSGHANDLER_THREADS = 16;
+
+/** How the socket handler waits for socket readiness (-socketevents) */
+enum SocketEventsMode
+{
+    SOCKETEVENTS_SELECT = 0,
+    SOCKETEVENTS_EPOLL = 1,
+};
+
+#ifdef HAVE_SYS_EPOLL_H
+static const char *const DEFAULT_SOCKETEVENTS = "epoll";
+#else
+static const char *const DEFAULT_SOCKETEVENTS = "select";
+#endif
+
 static const ServiceFlags REQUIRED_SERVICES = NODE_NETWORK;
 
 // NOTE: When adjusting this, update rpcnet:setban's help ("24h")
@@ -124,6 +141,47 @@ struct CSerializedNetMsg
     std::string command;
 };
 
+/**
+ * An immutable, fully framed network message. The header and its checksum are computed once, and
+ * the payload is shared by reference, so a message broadcast to every peer is queued on each send
+ * queue without copying its bytes.
+ */
+class CNetMessageBuffer
+{
+public:
+    typedef std::shared_ptr<const std::vector<unsigned char>> Payload;
+
+    CNetMessageBuffer(const std::string &commandIn, Payload payloadIn);
+
+    const std::string &GetCommand() const
+    {
+        return command;
+    }
+
+    const unsigned char *GetHeader() const
+    {
+        return header;
+    }
+
+    const std::vector<unsigned char> &GetPayload() const
+    {
+        return *payload;
+    }
+
+    //! Header plus payload, as written to the socket
+    size_t size() const
+    {
+        return CMessageHeader::HEADER_SIZE + payload->size();
+    }
+
+private:
+    std::string command;
+    unsigned char header[CMessageHeader::HEADER_SIZE];
+    Payload payload;
+};
+
+typedef std::shared_ptr<const CNetMessageBuffer> CNetMessageBufferRef;
+
 class CChainParams;
 class NetEventsInterface;
 
@@ -152,6 +210,8 @@ public:
         NetEventsInterface *m_msgproc = nullptr;
         unsigned int nSendBufferMaxSize = 0;
         unsigned int nReceiveFloodSize = 0;
+        SocketEventsMode socketEventsMode = SOCKETEVENTS_SELECT;
+        int nMessageHandlerThreads = 1;
         uint64_t nMaxOutboundTimeframe = 0;
         uint64_t nMaxOutboundLimit = 0;
         std::vector<std::string> vSeedNodes;
@@ -172,6 +232,8 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        socketEventsMode = connOptions.socketEventsMode;
+        nMessageHandlerThreads = std::max(1, std::min(connOptions.nMessageHandlerThreads, MAX_MSGHANDLER_THREADS));
         nMaxOutboundTimeframe = connOptions.nMaxOutboundTimeframe;
         nMaxOutboundLimit = connOptions.nMaxOutboundLimit;
         vWhitelistedRange = connOptions.vWhitelistedRange;
@@ -206,6 +268,9 @@ public:
     void PushMessage(CNode *pnode, CSerializedNetMsg &&msg);
     void PushMessage(CNode *pnode, const std::string& command, const std::vector<unsigned char>& data);
 
+    //! Queues a shared message; the same buffer may be pushed to any number of nodes
+    void PushMessage(CNode *pnode, const CNetMessageBufferRef &msg);
+
     template<typename Callable>
     void ForEachNode(Callable &&func)
     {
@@ -362,8 +427,12 @@ public:
 
     unsigned int GetReceiveFloodSize() const;
 
+    //! Wakes every message handler thread
     void WakeMessageHandler();
 
+    //! Wakes the message handler thread the node is pinned to
+    void WakeMessageHandler(NodeId id);
+
 private:
     struct ListenSocket
     {
@@ -389,12 +458,35 @@ private:
 
     void ThreadOpenConnections();
 
-    void ThreadMessageHandler();
+    void ThreadMessageHandler(int nShard);
+
+    //! The message handler thread that processes every message of a node
+    int GetMessageHandlerShard(NodeId id) const
+    {
+        return (int)(id % nMessageHandlerThreads);
+    }
 
     void AcceptConnection(const ListenSocket &hListenSocket);
 
     void ThreadSocketHandler();
 
+    //! One select() round over every node. Returns false once interrupted
+    bool SocketHandlerSelect();
+
+    //! One epoll_wait() round over the nodes that reported readiness. Returns false once interrupted
+    bool SocketHandlerEpoll();
+
+    //! Adds the node's socket to the epoll set for the lifetime of the connection
+    void RegisterSocketEvents(CNode *pnode);
+
+    //! Whether the socket handler can wait on this socket
+    bool IsPollableSocket(const SOCKET &hSocket) const;
+
+    //! Reads once from the node's socket. Returns true if the read filled the buffer, so more data may be waiting
+    bool SocketRecvData(CNode *pnode);
+
+    void InactivityCheck(CNode *pnode);
+
     void ThreadDNSAddressSeed();
 
     uint64_t CalculateKeyedNetGroup(const CAddress &ad) const;
@@ -461,6 +553,13 @@ private:
     unsigned int nSendBufferMaxSize;
     unsigned int nReceiveFloodSize;
 
+    SocketEventsMode socketEventsMode;
+    //! epoll instance, -1 unless the epoll socket handler runs
+    int hEpoll;
+    //! Nodes with unread data on an edge-triggered socket, only used by the socket handler thread
+    std::vector<CNode *> vNodesPendingRecv;
+    int64_t nLastInactivityCheck;
+
     std::vector<ListenSocket> vhListenSocket;
     std::atomic<bool> fNetworkActive;
     banmap_t setBanned;
@@ -496,8 +595,8 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake;
+    /** flags for waking the message processor threads, one per shard. */
+    std::vector<bool> vMsgProcWake;
 
     std::condition_variable condMsgProc;
     std::mutex mutexMsgProc;
@@ -509,7 +608,9 @@ private:
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
-    std::thread threadMessageHandler;
+    int nMessageHandlerThreads;
+    std::vector<std::string> vMessageHandlerNames;
+    std::vector<std::thread> threadMessageHandlers;
 
     /** flag for deciding to connect to an extra outbound peer,
      *  in excess of nMaxOutbound
@@ -627,6 +728,16 @@ extern CCriticalSection cs_mapLocalHost;
 extern std::map<CNetAddr, LocalServiceInfo> mapLocalHost;
 typedef std::map<std::string, uint64_t> mapMsgCmdSize; //command, total bytes
 
+/** How long the messages of one command waited in the process queue and took to handle */
+struct CMsgLatencyStats
+{
+    uint64_t nCount = 0;
+    int64_t nTotalWaitMicros = 0;
+    int64_t nTotalMicros = 0;
+    int64_t nMaxMicros = 0;
+};
+typedef std::map<std::string, CMsgLatencyStats> mapMsgCmdLatency;
+
 class CNodeStats
 {
 public:
@@ -647,6 +758,7 @@ public:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdLatency mapLatencyPerMsgCmd;
     bool fWhitelisted;
     double dPingTime;
     double dPingWait;
@@ -721,7 +833,7 @@ public:
     size_t nSendSize; // total size of all vSendMsg entries
     size_t nSendOffset; // offset inside the first vSendMsg already sent
     uint64_t nSendBytes;
-    std::deque<std::vector<unsigned char>> vSendMsg;
+    std::deque<CNetMessageBufferRef> vSendMsg;
     CCriticalSection cs_vSend;
     CCriticalSection cs_hSocket;
     CCriticalSection cs_vRecv;
@@ -772,16 +884,22 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv;
     std::atomic_bool fPauseSend;
+    //! The edge-triggered socket may hold unread data; only used by the socket handler thread
+    bool fPendingRecv;
 protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    CCriticalSection cs_msgLatency;
+    mapMsgCmdLatency mapLatencyPerMsgCmd;
 
 public:
     uint256 hashContinue;
     std::atomic<int> nStartingHeight;
 
     // flood relay
+    // vAddrToSend and addrKnown are filled by the message handler threads of other peers
+    CCriticalSection cs_addrSend;
     std::vector<CAddress> vAddrToSend;
     CRollingBloomFilter addrKnown;
     bool fGetAddr;
@@ -917,11 +1035,13 @@ public:
 
     void AddAddressKnown(const CAddress &_addr)
     {
+        LOCK(cs_addrSend);
         addrKnown.insert(_addr.GetKey());
     }
 
     void PushAddress(const CAddress &_addr, FastRandomContext &insecure_rand)
     {
+        LOCK(cs_addrSend);
         // Known checking here is only to save space from duplicates.
         // SendMessages will filter it again for knowns that were added
         // after addresses were pushed.
@@ -973,6 +1093,9 @@ public:
 
     void copyStats(CNodeStats &stats);
 
+    //! Accounts one handled message: nWaitMicros in the process queue, nMicros in its handler
+    void RecordMessageLatency(const std::string &command, int64_t nWaitMicros, int64_t nMicros);
+
     ServiceFlags GetLocalServices() const
     {
         return nLocalServices;
@@ -1232,7 +1232,10 @@ bool PeerLogicValidation::ProcessMessages(CNode *pfrom, std::atomic<bool> &inter
     bool fRet = false;
     try
     {
+        int64_t nProcessStart = GetTimeMicros();
         fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, interruptMsgProc);
+        int64_t nProcessEnd = GetTimeMicros();
+        pfrom->RecordMessageLatency(strCommand, nProcessStart - msg.nTime, nProcessEnd - nProcessStart);
         if (interruptMsgProc)
             return false;
         if (!pfrom->vRecvGetData.empty())
@@ -1356,28 +1359,37 @@ bool PeerLogicValidation::SendMessages(CNode *pto, std::atomic<bool> &interruptM
         if (pto->nNextAddrSend < nNow)
         {
             pto->nNextAddrSend = PoissonNextSend(nNow, AVG_ADDRESS_BROADCAST_INTERVAL);
-            std::vector<CAddress> vAddr;
-            vAddr.reserve(pto->vAddrToSend.size());
-            for (const CAddress &addr : pto->vAddrToSend)
+            std::vector<CAddress> vAddrToSend;
             {
-                if (!pto->addrKnown.contains(addr.GetKey()))
+                // other message handler threads relay addresses into this node
+                LOCK(pto->cs_addrSend);
+                for (const CAddress &addr : pto->vAddrToSend)
                 {
-                    pto->addrKnown.insert(addr.GetKey());
-                    vAddr.push_back(addr);
-                    // receiver rejects addr messages larger than 1000
-                    if (vAddr.size() >= 1000)
+                    if (!pto->addrKnown.contains(addr.GetKey()))
                     {
-                        connman->PushMessage(pto, msgMaker.Make(NetMsgType::ADDR, vAddr));
-                        vAddr.clear();
+                        pto->addrKnown.insert(addr.GetKey());
+                        vAddrToSend.push_back(addr);
                     }
                 }
+                pto->vAddrToSend.clear();
+                // we only send the big addr message once
+                if (pto->vAddrToSend.capacity() > 40)
+                    pto->vAddrToSend.shrink_to_fit();
+            }
+            std::vector<CAddress> vAddr;
+            vAddr.reserve(std::min(vAddrToSend.size(), (size_t)1000));
+            for (const CAddress &addr : vAddrToSend)
+            {
+                vAddr.push_back(addr);
+                // receiver rejects addr messages larger than 1000
+                if (vAddr.size() >= 1000)
+                {
+                    connman->PushMessage(pto, msgMaker.Make(NetMsgType::ADDR, vAddr));
+                    vAddr.clear();
+                }
             }
-            pto->vAddrToSend.clear();
             if (!vAddr.empty())
                 connman->PushMessage(pto, msgMaker.Make(NetMsgType::ADDR, vAddr));
-            // we only send the big addr message once
-            if (pto->vAddrToSend.capacity() > 40)
-                pto->vAddrToSend.shrink_to_fit();
         }
 
         CBlockIndex *pindexBestHeader = ifChainObj->GetIndexBestHeader();
@@ -1998,7 +2010,7 @@ bool PeerLogicValidation::ProcessMessage(CNode *pfrom, const std::string &strCom
     }
 
     GET_CHAIN_INTERFACE(ifChainObj);
-    if ((ifChainObj->GetActiveChain().Tip()->nHeight > Params().GetConsensus().SBTCContractForkHeight) &&
+    if ((ifChainObj->GetActiveChainView()->Height() > Params().GetConsensus().SBTCContractForkHeight) &&
         (pfrom->nVersion != 0) && (pfrom->nVersion < SBTC_CONTRACT_VERSION))
     {
         // disconnect from peers older than this proto version
@@ -2289,7 +2301,7 @@ bool PeerLogicValidation::ProcessVersionMsg(CNode *pfrom, CDataStream &vRecv)
     }
 
     int minVer = MIN_PEER_PROTO_VERSION;
-    if (ifChainObj->GetActiveChain().Tip()->nVersion & (((uint32_t)1) << VERSIONBITS_SBTC_CONTRACT))
+    if (ifChainObj->GetActiveChainView()->Tip()->nVersion & (((uint32_t)1) << VERSIONBITS_SBTC_CONTRACT))
     {
         minVer = SBTC_CONTRACT_VERSION;
     }
@@ -2492,7 +2504,10 @@ bool PeerLogicValidation::ProcessGetAddrMsg(CNode *pfrom, CDataStream &vRecv)
     }
     pfrom->fSentAddr = true;
 
-    pfrom->vAddrToSend.clear();
+    {
+        LOCK(pfrom->cs_addrSend);
+        pfrom->vAddrToSend.clear();
+    }
     std::vector<CAddress> vAddr = connman->GetAddresses();
     FastRandomContext insecure_rand;
     for (const CAddress &addr : vAddr)
@@ -3416,7 +3431,6 @@ void PeerLogicValidation::ProcessGetData(CNode *pfrom, const std::atomic<bool> &
 {
     std::vector<CInv> vNotFound;
     const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
-    LOCK(cs_main);
 
     std::deque<CInv>::iterator it = pfrom->vRecvGetData.begin();
     while (it != pfrom->vRecvGetData.end())
@@ -3471,7 +3485,10 @@ void PeerLogicValidation::ProcessGetData(CNode *pfrom, const std::atomic<bool> &
                         // wait for other stuff first.
                         std::vector<CInv> vInv;
                         uint256 tipHash;
-                        ifChainObj->GetActiveChainTipHash(tipHash);
+                        {
+                            LOCK(cs_main);
+                            ifChainObj->GetActiveChainTipHash(tipHash);
+                        }
                         vInv.push_back(CInv(MSG_BLOCK, tipHash));
                         connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::INV, vInv));
                         pfrom->hashContinue.SetNull();
@@ -3488,6 +3505,7 @@ void PeerLogicValidation::ProcessGetData(CNode *pfrom, const std::atomic<bool> &
                 NodeExchangeInfo xnode = FromCNode(pfrom);
 
                 GET_TXMEMPOOL_INTERFACE(ifTxMempoolObj);
+                LOCK(cs_main);
                 if (!ifTxMempoolObj->NetRequestTxData(&xnode, inv.hash, inv.type == MSG_WITNESS_TX,
                                                       pfrom->timeLastMempoolReq))
                 {
@@ -3496,7 +3514,10 @@ void PeerLogicValidation::ProcessGetData(CNode *pfrom, const std::atomic<bool> &
             }
 
             // Track requests for our stuff.
-            GetMainSignals().Inventory(inv.hash);
+            {
+                LOCK(cs_main);
+                GetMainSignals().Inventory(inv.hash);
+            }
 
             // why process just one block getdata msg here?
             if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK ||
@@ -23,6 +23,7 @@
 #ifndef WIN32
 
 #include <fcntl.h>
+#include <poll.h>
 
 #endif
 
@@ -202,6 +203,28 @@ struct timeval MillisToTimeval(int64_t nTimeout)
     return timeout;
 }
 
+/**
+ * Waits up to nTimeout milliseconds for a single socket to become readable or writable.
+ * Returns like select(): >0 when ready, 0 on timeout and SOCKET_ERROR on failure. Outside
+ * Windows this uses poll(), which unlike select() accepts descriptors beyond FD_SETSIZE.
+ */
+static int WaitOnSocket(SOCKET hSocket, bool fWrite, int64_t nTimeout)
+{
+#ifdef WIN32
+    struct timeval timeout = MillisToTimeval(nTimeout);
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    FD_SET(hSocket, &fdset);
+    return select(hSocket + 1, fWrite ? nullptr : &fdset, fWrite ? &fdset : nullptr, nullptr, &timeout);
+#else
+    struct pollfd pollfd;
+    pollfd.fd = hSocket;
+    pollfd.events = fWrite ? POLLOUT : POLLIN;
+    pollfd.revents = 0;
+    return poll(&pollfd, 1, (int)nTimeout);
+#endif
+}
+
 /** SOCKS version */
 enum SOCKSVersion : uint8_t
 {
@@ -291,15 +314,7 @@ static IntrRecvError InterruptibleRecv(uint8_t *data, size_t len, int timeout, c
             int nErr = WSAGetLastError();
             if (nErr == WSAEINPROGRESS || nErr == WSAEWOULDBLOCK || nErr == WSAEINVAL)
             {
-                if (!IsSelectableSocket(hSocket))
-                {
-                    return IntrRecvError::NetworkError;
-                }
-                struct timeval tval = MillisToTimeval(std::min(endTime - curTime, maxWait));
-                fd_set fdset;
-                FD_ZERO(&fdset);
-                FD_SET(hSocket, &fdset);
-                int nRet = select(hSocket + 1, &fdset, nullptr, nullptr, &tval);
+                int nRet = WaitOnSocket(hSocket, false, std::min(endTime - curTime, maxWait));
                 if (nRet == SOCKET_ERROR)
                 {
                     return IntrRecvError::NetworkError;
@@ -554,11 +569,7 @@ bool static ConnectSocketDirectly(const CService &addrConnect, SOCKET &hSocketRe
         // WSAEINVAL is here because some legacy version of winsock uses it
         if (nErr == WSAEINPROGRESS || nErr == WSAEWOULDBLOCK || nErr == WSAEINVAL)
         {
-            struct timeval timeout = MillisToTimeval(nTimeout);
-            fd_set fdset;
-            FD_ZERO(&fdset);
-            FD_SET(hSocket, &fdset);
-            int nRet = select(hSocket + 1, nullptr, &fdset, nullptr, &timeout);
+            int nRet = WaitOnSocket(hSocket, true, nTimeout);
             if (nRet == 0)
             {
                 CloseSocket(hSocket);
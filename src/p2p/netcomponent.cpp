@@ -218,10 +218,27 @@ bool CNetComponent::ComponentStartup()
 # define MIN_CORE_FILEDESCRIPTORS 150
 #endif
 
+    std::string strSocketEvents = Args().GetArg<std::string>("-socketevents", DEFAULT_SOCKETEVENTS);
+    if (strSocketEvents == "select")
+    {
+        netConnOptions.socketEventsMode = SOCKETEVENTS_SELECT;
+#ifdef HAVE_SYS_EPOLL_H
+    } else if (strSocketEvents == "epoll")
+    {
+        netConnOptions.socketEventsMode = SOCKETEVENTS_EPOLL;
+#endif
+    } else
+    {
+        return rLogError("Invalid -socketevents ('%s') specified", strSocketEvents);
+    }
+
     // Trim requested connection counts, to fit into system limitations
-    nMaxConnections = std::max(
-            std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS)),
-            0);
+    if (netConnOptions.socketEventsMode == SOCKETEVENTS_SELECT)
+    {
+        nMaxConnections = std::max(
+                std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS)),
+                0);
+    }
     int nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS + MAX_ADDNODE_CONNECTIONS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
     {
@@ -251,6 +268,7 @@ bool CNetComponent::ComponentStartup()
     netConnOptions.m_msgproc = peerLogic.get();
     netConnOptions.nSendBufferMaxSize = 1000 * Args().GetArg("-maxsendbuffer", DEFAULT_MAXSENDBUFFER);
     netConnOptions.nReceiveFloodSize = 1000 * Args().GetArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
+    netConnOptions.nMessageHandlerThreads = Args().GetArg("-msghandlerthreads", DEFAULT_MSGHANDLER_THREADS);
 
     for (const std::string &strBind : Args().GetArgs("-bind"))
     {
@@ -330,20 +348,22 @@ bool CNetComponent::ComponentShutdown()
 
 
 
-bool CNetComponent::SendNetMessage(int64_t nodeID, const std::string &command, const std::vector<unsigned char> &data)
+bool CNetComponent::SendNetMessage(int64_t nodeID, const std::string &command,
+                                   std::shared_ptr<const std::vector<unsigned char>> data)
 {
     if (netConnMgr)
     {
+        CNetMessageBufferRef msg = std::make_shared<const CNetMessageBuffer>(command, std::move(data));
         if (nodeID == -1) // means any node, broadcast.
         {
             netConnMgr->ForEachNode([&](CNode *pnode)
-                                    { netConnMgr->PushMessage(pnode, command, data); });
+                                    { netConnMgr->PushMessage(pnode, msg); });
             return true;
         }
 
         if (CNode *node = netConnMgr->QueryNode(nodeID))
         {
-            netConnMgr->PushMessage(node, command, data);
+            netConnMgr->PushMessage(node, msg);
             return true;
         }
     }
@@ -17,7 +17,8 @@ public:
     const char* whoru() const override { return "I am CNetComponent\n";}
 
 
-    bool SendNetMessage(int64_t nodeID, const std::string& command, const std::vector<unsigned char>& data) override;
+    bool SendNetMessage(int64_t nodeID, const std::string& command,
+                        std::shared_ptr<const std::vector<unsigned char>> data) override;
 
     bool BroadcastTransaction(uint256 txHash) override;
 
@@ -27,6 +27,7 @@
 #include "utils/util.h"
 #include "utils/utilstrencodings.h"
 #include "hash.h"
+#include "contract-api/contractsnapshot.h"
 
 #include <stdint.h>
 
@@ -34,6 +35,8 @@
 
 #include <boost/thread/thread.hpp> // boost::thread::interrupt
 
+#include <algorithm>
+#include <limits>
 #include <mutex>
 #include <condition_variable>
 #include <utils/base58.h>
@@ -199,11 +202,8 @@ UniValue getblockcount(const JSONRPCRequest &request)
                 + HelpExampleRpc("getblockcount", "")
         );
 
-    LOCK(cs_main);
     GET_CHAIN_INTERFACE(ifChainObj);
-    CChain &chainActive = ifChainObj->GetActiveChain();
-
-    return chainActive.Height();
+    return ifChainObj->GetActiveChainView()->Height();
 }
 
 UniValue getbestblockhash(const JSONRPCRequest &request)
@@ -219,11 +219,8 @@ UniValue getbestblockhash(const JSONRPCRequest &request)
                 + HelpExampleRpc("getbestblockhash", "")
         );
 
-    LOCK(cs_main);
     GET_CHAIN_INTERFACE(ifChainObj);
-    CChain &chainActive = ifChainObj->GetActiveChain();
-
-    return chainActive.Tip()->GetBlockHash().GetHex();
+    return ifChainObj->GetActiveChainView()->Tip()->GetBlockHash().GetHex();
 }
 
 void RPCNotifyBlockChange(bool ibd, const CBlockIndex *pindex)
@@ -697,15 +694,14 @@ UniValue getblockhash(const JSONRPCRequest &request)
                 + HelpExampleRpc("getblockhash", "1000")
         );
 
-    LOCK(cs_main);
     GET_CHAIN_INTERFACE(ifChainObj);
-    CChain &chainActive = ifChainObj->GetActiveChain();
+    std::shared_ptr<const CChainView> chainView = ifChainObj->GetActiveChainView();
 
     int nHeight = request.params[0].get_int();
-    if (nHeight < 0 || nHeight > chainActive.Height())
+    if (nHeight < 0 || nHeight > chainView->Height())
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
 
-    CBlockIndex *pblockindex = chainActive[nHeight];
+    CBlockIndex *pblockindex = (*chainView)[nHeight];
     return pblockindex->GetBlockHash().GetHex();
 }
 
@@ -865,12 +861,42 @@ UniValue getblock(const JSONRPCRequest &request)
 }
 
 /////////////////////////////////////////////////////sbtc-vm
+//! Snapshot of the contract state after the block at nHeight, the tip if -1. cs_main is only held to read
+//! the roots of the block, the state is then read from the snapshot.
+static std::shared_ptr<CContractStateSnapshot> GetContractStateSnapshot(int nHeight,
+                                                                        const CBlockIndex **ppindex = nullptr)
+{
+    // the vm state roots of a block in the active chain are set once it is connected
+    GET_CHAIN_INTERFACE(ifChainObj);
+    std::shared_ptr<const CChainView> chainView = ifChainObj->GetActiveChainView();
+    if (nHeight < -1 || nHeight > chainView->Height())
+        throw JSONRPCError(RPC_INVALID_PARAMS, "Incorrect block number");
+    const CBlockIndex *pindex = nHeight == -1 ? chainView->Tip() : (*chainView)[nHeight];
+    uint256 hashStateRoot;
+    uint256 hashUTXORoot;
+    if (ReadVMStateFromIndex(pindex, hashStateRoot, hashUTXORoot, Params().GetConsensus()) != RET_VM_STATE_OK)
+    {
+        std::ostringstream stringStream;
+        stringStream << "Incorrect GetVMState at hegiht " << pindex->nHeight << " hash: " << pindex->GetBlockHash().ToString();
+        throw JSONRPCError(RPC_INVALID_PARAMS, stringStream.str());
+    }
+
+    GET_CONTRACT_INTERFACE(ifContractObj);
+    std::shared_ptr<CContractStateSnapshot> snapshot = ifContractObj->GetStateSnapshot(hashStateRoot, hashUTXORoot);
+    if (!snapshot)
+        throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("Contract state of block %s is not available",
+                                                         pindex->GetBlockHash().ToString()));
+    if (ppindex)
+        *ppindex = pindex;
+    return snapshot;
+}
+
 UniValue getaccountinfo(const JSONRPCRequest &request)
 {
     bool IsEnabled =  [&]()->bool{
         GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+        const CBlockIndex *pTip = ifChainObj->GetActiveChainView()->Tip();
+        return pTip != nullptr && pTip->IsSBTCContractEnabled();
     }();
     if (!IsEnabled)
     {
@@ -884,25 +910,23 @@ UniValue getaccountinfo(const JSONRPCRequest &request)
                         "1. \"address\"          (string, required) The account address\n"
         );
 
-    LOCK(cs_main);
-
     std::string strAddr = request.params[0].get_str();
     if (strAddr.size() != 40 || !IsHex(strAddr))
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Incorrect address");
 
-    GET_CONTRACT_INTERFACE(ifContractObj);
-    if (!ifContractObj->AddressInUse(strAddr))
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Address does not exist");
+    std::shared_ptr<CContractStateSnapshot> snapshot = GetContractStateSnapshot(-1);
 
     dev::Address addrAccount(strAddr);
+    if (!snapshot->AddressInUse(addrAccount))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Address does not exist");
 
     UniValue result(UniValue::VOBJ);
 
     result.push_back(Pair("address", strAddr));
-    result.push_back(Pair("balance", ifContractObj->GetContractBalance(addrAccount)));
-    std::vector<uint8_t> code = ifContractObj->GetContractCode(addrAccount);
+    result.push_back(Pair("balance", CAmount(snapshot->GetBalance(addrAccount))));
+    std::vector<uint8_t> code = snapshot->GetCode(addrAccount);
 
-    std::map<dev::h256, std::pair<dev::u256, dev::u256>> storage = ifContractObj->GetStorageByAddress(strAddr);
+    std::map<dev::h256, std::pair<dev::u256, dev::u256>> storage = snapshot->GetStorage(addrAccount);
 
     UniValue storageUV(UniValue::VOBJ);
     for (auto j: storage)
@@ -916,18 +940,15 @@ UniValue getaccountinfo(const JSONRPCRequest &request)
 
     result.push_back(Pair("code", HexStr(code.begin(), code.end())));
 
-    dev::h256 hash;
-    uint32_t nVout;
-    dev::u256 value;
-    uint8_t alive;
-    if (ifContractObj->GetContractVin(addrAccount, hash, nVout, value, alive))
+    Vin contractVin;
+    if (snapshot->GetVin(addrAccount, contractVin))
     {
         UniValue vin(UniValue::VOBJ);
-        valtype vchHash(hash.asBytes());
+        valtype vchHash(contractVin.hash.asBytes());
         vin.push_back(Pair("hash", HexStr(vchHash.rbegin(), vchHash.rend())));
-        vin.push_back(Pair("nVout", uint64_t(nVout)));
-        vin.push_back(Pair("value", uint64_t(value)));
-        vin.push_back(Pair("alive", uint8_t(alive)));
+        vin.push_back(Pair("nVout", uint64_t(contractVin.nVout)));
+        vin.push_back(Pair("value", uint64_t(contractVin.value)));
+        vin.push_back(Pair("alive", uint8_t(contractVin.alive)));
         result.push_back(Pair("vin", vin));
     }
     return result;
@@ -937,8 +958,8 @@ UniValue getstorage(const JSONRPCRequest &request)
 {
     bool IsEnabled =  [&]()->bool{
         GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+        const CBlockIndex *pTip = ifChainObj->GetActiveChainView()->Tip();
+        return pTip != nullptr && pTip->IsSBTCContractEnabled();
     }();
     if (!IsEnabled)
     {
@@ -954,50 +975,25 @@ UniValue getstorage(const JSONRPCRequest &request)
                         "3. \"index\"            (number, optional) Zero-based index position of the storage\n"
         );
 
-    LOCK(cs_main);
-
     std::string strAddr = request.params[0].get_str();
     if (strAddr.size() != 40 || !IsHex(strAddr))
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Incorrect address");
-    GET_CHAIN_INTERFACE(ifChainObj);
-    CChain chainActive = ifChainObj->GetActiveChain();
 
-    GET_CONTRACT_INTERFACE(ifContractObj);
+    int blockNum = -1;
     if (request.params.size() > 1)
     {
         if (request.params[1].isNum())
         {
-            auto blockNum = request.params[1].get_int();
-            if ((blockNum < 0 && blockNum != -1) || blockNum > chainActive.Height())
-                throw JSONRPCError(RPC_INVALID_PARAMS, "Incorrect block number");
-
-            if (blockNum != -1)
-            {
-                uint256 hashStateRoot;
-                uint256 hashUTXORoot;
-                CBlock block;
-                if (!ReadBlockFromDisk(block, chainActive[blockNum], Params().GetConsensus()))
-                {
-                    std::ostringstream stringStream;
-                    stringStream << "ReadBlockFromDisk failed at hegiht " << chainActive[blockNum]->nHeight << " hash: " << chainActive[blockNum]->GetBlockHash().ToString();
-                    throw JSONRPCError(RPC_INVALID_PARAMS, stringStream.str());
-                } else
-                {
-                    if(block.GetVMState(hashStateRoot, hashUTXORoot) == RET_VM_STATE_ERR){
-                        throw JSONRPCError(RPC_INVALID_PARAMS, "Incorrect GetVMState");
-                    }
-                }
-                ifContractObj->SetTemporaryState(hashStateRoot, hashUTXORoot);
-                //                ifContractObj->SetTemporaryState(chainActive[blockNum]->hashStateRoot,
-                //                                                 chainActive[blockNum]->hashUTXORoot);
-            }
+            blockNum = request.params[1].get_int();
         } else
         {
             throw JSONRPCError(RPC_INVALID_PARAMS, "Incorrect block number");
         }
     }
+    std::shared_ptr<CContractStateSnapshot> snapshot = GetContractStateSnapshot(blockNum);
 
-    if (!ifContractObj->AddressInUse(strAddr))
+    dev::Address addrAccount(strAddr);
+    if (!snapshot->AddressInUse(addrAccount))
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Address does not exist");
 
     UniValue result(UniValue::VOBJ);
@@ -1007,7 +1003,7 @@ UniValue getstorage(const JSONRPCRequest &request)
     if (onlyIndex)
         index = request.params[2].get_int();
 
-    std::map<dev::h256, std::pair<dev::u256, dev::u256>> storage = ifContractObj->GetStorageByAddress(strAddr);
+    std::map<dev::h256, std::pair<dev::u256, dev::u256>> storage = snapshot->GetStorage(addrAccount);
     if (onlyIndex)
     {
         if (index >= storage.size())
@@ -1034,8 +1030,8 @@ UniValue callcontract(const JSONRPCRequest &request)
 {
     bool IsEnabled =  [&]()->bool{
         GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+        const CBlockIndex *pTip = ifChainObj->GetActiveChainView()->Tip();
+        return pTip != nullptr && pTip->IsSBTCContractEnabled();
     }();
     if (!IsEnabled)
     {
@@ -1054,8 +1050,6 @@ UniValue callcontract(const JSONRPCRequest &request)
                 //                        "4. gasLimit             (string, optional) The gas limit for executing the contract\n"
         );
 
-    LOCK(cs_main);
-
     std::string strAddr = request.params[0].get_str();
     std::string data = request.params[1].get_str();
 
@@ -1065,9 +1059,10 @@ UniValue callcontract(const JSONRPCRequest &request)
     if (strAddr.size() != 40 || !IsHex(strAddr))
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Incorrect address");
 
-    GET_CONTRACT_INTERFACE(ifContractObj);
+    const CBlockIndex *pTip;
+    std::shared_ptr<CContractStateSnapshot> snapshot = GetContractStateSnapshot(-1, &pTip);
 
-    if (!ifContractObj->AddressInUse(strAddr))
+    if (!snapshot->AddressInUse(dev::Address(strAddr)))
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Address does not exist");
 
     string sender = "";
@@ -1110,7 +1105,8 @@ UniValue callcontract(const JSONRPCRequest &request)
 
     UniValue result(UniValue::VOBJ);
     result.push_back(Pair("address", strAddr));
-    ifContractObj->RPCCallContract(result, strAddr, ParseHex(data), sender, gasLimit);
+    GET_CONTRACT_INTERFACE(ifContractObj);
+    ifContractObj->RPCCallContract(result, *snapshot, pTip, strAddr, ParseHex(data), sender, gasLimit);
 
     return result;
 }
@@ -1182,15 +1178,20 @@ size_t parseUInt(const UniValue &val, size_t defaultVal)
     }
 }
 
-int parseBlockHeight(const UniValue &val)
+int parseBlockHeight(const UniValue &val, int latestHeight)
 {
+    if (val.isNull())
+    {
+        return latestHeight;
+    }
+
     if (val.isStr())
     {
         auto blockKey = val.get_str();
 
         if (blockKey == "latest")
         {
-            return latestblock.height;
+            return latestHeight;
         } else
         {
             throw JSONRPCError(RPC_INVALID_PARAMS, "invalid block number");
@@ -1203,7 +1204,7 @@ int parseBlockHeight(const UniValue &val)
 
         if (blockHeight < 0)
         {
-            return latestblock.height;
+            return latestHeight;
         }
 
         return blockHeight;
@@ -1212,17 +1213,6 @@ int parseBlockHeight(const UniValue &val)
     throw JSONRPCError(RPC_INVALID_PARAMS, "invalid block number");
 }
 
-int parseBlockHeight(const UniValue &val, int defaultVal)
-{
-    if (val.isNull())
-    {
-        return defaultVal;
-    } else
-    {
-        return parseBlockHeight(val);
-    }
-}
-
 dev::h160 parseParamH160(const UniValue &val)
 {
     if (!val.isStr())
@@ -1324,48 +1314,29 @@ public:
 
     SearchLogsParams(const UniValue &params)
     {
-        std::unique_lock<std::mutex> lock(cs_blockchange);
+        // both ends are resolved against the same latest block
+        int latestHeight;
+        {
+            std::lock_guard<std::mutex> lock(cs_blockchange);
+            latestHeight = latestblock.height;
+        }
 
-        setFromBlock(params[0]);
-        setToBlock(params[1]);
+        fromBlock = parseBlockHeight(params[0], latestHeight);
+        toBlock = parseBlockHeight(params[1], latestHeight);
 
         parseParam(params[2]["addresses"], addresses);
         parseParam(params[3]["topics"], topics);
 
         minconf = parseUInt(params[4], 0);
     }
-
-private:
-    void setFromBlock(const UniValue &val)
-    {
-        if (!val.isNull())
-        {
-            fromBlock = parseBlockHeight(val);
-        } else
-        {
-            fromBlock = latestblock.height;
-        }
-    }
-
-    void setToBlock(const UniValue &val)
-    {
-        if (!val.isNull())
-        {
-            toBlock = parseBlockHeight(val);
-        } else
-        {
-            toBlock = latestblock.height;
-        }
-    }
-
 };
 
 UniValue searchlogs(const JSONRPCRequest &request)
 {
     bool IsEnabled =  [&]()->bool{
         GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+        const CBlockIndex *pTip = ifChainObj->GetActiveChainView()->Tip();
+        return pTip != nullptr && pTip->IsSBTCContractEnabled();
     }();
     if (!IsEnabled)
     {
@@ -1394,14 +1365,70 @@ UniValue searchlogs(const JSONRPCRequest &request)
 
     int curheight = 0;
 
-    LOCK(cs_main);
-
+    // the block tree db and the results db are leveldb stores, safe to read without cs_main
     SearchLogsParams params(request.params);
+    CBlockTreeDB *pblocktree = ifChainObj->GetBlockTreeDB();
+
+    auto topics = params.topics;
+    std::vector<dev::h256> filterTopics;
+    for (const auto &tc : topics)
+    {
+        if (tc)
+            filterTopics.push_back(tc.get());
+    }
+
+    int nLogIndexStart = 0;
+    bool fLogIndex = pblocktree->ReadLogIndexStart(nLogIndexStart);
 
     std::vector<std::vector<uint256>> hashesToBlock;
-    curheight = ifChainObj->GetBlockTreeDB()->ReadHeightIndex(params.fromBlock, params.toBlock, params.minconf,
-                                                              hashesToBlock,
-                                                              params.addresses);
+    if (fLogIndex && (int)params.fromBlock >= nLogIndexStart && !params.addresses.empty() && !topics.empty() &&
+        topics[0] && filterTopics.size() == 1)
+    {
+        // only the first topic is filtered on: the postings of each address give the candidate transactions
+        curheight = pblocktree->ReadLogTopicIndex(params.fromBlock, params.toBlock, params.minconf, hashesToBlock,
+                                                  params.addresses, filterTopics[0]);
+    } else
+    {
+        std::function<bool(unsigned int)> filterHeight;
+        if (fLogIndex && !filterTopics.empty())
+        {
+            auto mayMatch = [&](dev::h2048 &bloom) -> bool
+            {
+                if (!params.addresses.empty() &&
+                    std::none_of(params.addresses.begin(), params.addresses.end(), [&](const dev::h160 &address)
+                    {
+                        return bloom.containsBloom<3>(dev::sha3(address.ref()));
+                    }))
+                    return false;
+                return std::any_of(filterTopics.begin(), filterTopics.end(), [&](const dev::h256 &topic)
+                {
+                    return bloom.containsBloom<3>(dev::sha3(topic.ref()));
+                });
+            };
+
+            // blocks indexed without a bloom have no logs, so they can't match either
+            unsigned int nRange = std::numeric_limits<unsigned int>::max();
+            bool fRangeMayMatch = true;
+            filterHeight = [&](unsigned int height) -> bool
+            {
+                if ((int)height < nLogIndexStart)
+                    return true;
+                if (height / LOG_BLOOM_RANGE != nRange)
+                {
+                    nRange = height / LOG_BLOOM_RANGE;
+                    dev::h2048 rangeBloom;
+                    fRangeMayMatch = (int)(nRange * LOG_BLOOM_RANGE) < nLogIndexStart ||
+                                     (pblocktree->ReadLogRangeBloom(nRange, rangeBloom) && mayMatch(rangeBloom));
+                }
+                if (!fRangeMayMatch)
+                    return false;
+                dev::h2048 bloom;
+                return pblocktree->ReadLogBloom(height, bloom) && mayMatch(bloom);
+            };
+        }
+        curheight = pblocktree->ReadHeightIndex(params.fromBlock, params.toBlock, params.minconf, hashesToBlock,
+                                                params.addresses, filterHeight);
+    }
 
     if (curheight == -1)
     {
@@ -1411,13 +1438,11 @@ UniValue searchlogs(const JSONRPCRequest &request)
     UniValue result(UniValue::VARR);
     GET_CONTRACT_INTERFACE(ifContractObj);
 
-    auto topics = params.topics;
-
     for (const auto &hashesTx : hashesToBlock)
     {
         for (const auto &e : hashesTx)
         {
-            std::vector<TransactionReceiptInfo> receipts = ifContractObj->GetResult(e);
+            std::vector<TransactionReceiptInfo> receipts = ifContractObj->GetCommittedResult(e);
 
             for (const auto &receipt : receipts)
             {
@@ -1473,8 +1498,8 @@ UniValue gettransactionreceipt(const JSONRPCRequest &request)
 {
     bool IsEnabled =  [&]()->bool{
         GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+        const CBlockIndex *pTip = ifChainObj->GetActiveChainView()->Tip();
+        return pTip != nullptr && pTip->IsSBTCContractEnabled();
     }();
     if (!IsEnabled)
     {
@@ -1518,8 +1543,8 @@ UniValue listcontracts(const JSONRPCRequest &request)
 {
     bool IsEnabled =  [&]()->bool{
         GET_CHAIN_INTERFACE(ifChainObj);
-        if(ifChainObj->GetActiveChain().Tip()== nullptr) return false;
-        return ifChainObj->GetActiveChain().Tip()->IsSBTCContractEnabled();
+        const CBlockIndex *pTip = ifChainObj->GetActiveChainView()->Tip();
+        return pTip != nullptr && pTip->IsSBTCContractEnabled();
     }();
     if (!IsEnabled)
     {
@@ -1528,14 +1553,35 @@ UniValue listcontracts(const JSONRPCRequest &request)
 
     if (request.fHelp)
         throw std::runtime_error(
-                "listcontracts (start maxDisplay)\n"
+                "listcontracts (start maxDisplay \"after\" verbose)\n"
+                        "\nLists the contracts in creation order.\n"
                         "\nArgument:\n"
                         "1. start     (numeric or string, optional) The starting account index, default 1\n"
                         "2. maxDisplay       (numeric or string, optional) Max accounts to list, default 20\n"
+                        "3. \"after\"     (string, optional) Count start from the contract after this one, the last address\n"
+                        "                   of the previous page. Pages from a contract address cost the same at any depth\n"
+                        "4. verbose     (bool, optional, default=false) Also return the creation height, txid and code hash\n"
+                        "\nResult (verbose=false):\n"
+                        "{\n"
+                        "  \"address\": balance,   (numeric) The balance of the contract at the tip\n"
+                        "  ...\n"
+                        "}\n"
+                        "\nResult (verbose=true):\n"
+                        "{\n"
+                        "  \"address\": {\n"
+                        "    \"balance\": n,       (numeric) The balance of the contract at the tip\n"
+                        "    \"height\": n,        (numeric) The height of the block that created the contract,\n"
+                        "                         0 for the contracts found in the state when the registry was built\n"
+                        "    \"txid\": \"hash\",     (string, optional) The transaction that created the contract\n"
+                        "    \"codehash\": \"hash\"  (string) The hash of the contract code\n"
+                        "  },\n"
+                        "  ...\n"
+                        "}\n"
+                        "\nExamples:\n"
+                        + HelpExampleCli("listcontracts", "1 20")
+                        + HelpExampleCli("listcontracts", "1 20 \"c4c1d7375918557df2ef8f1d1f0b2329cb248a15\" true")
         );
 
-    LOCK(cs_main);
-
     int start = 1;
     if (request.params.size() > 0)
     {
@@ -1552,26 +1598,72 @@ UniValue listcontracts(const JSONRPCRequest &request)
             throw JSONRPCError(RPC_TYPE_ERROR, "Invalid maxDisplay");
     }
 
-    UniValue result(UniValue::VOBJ);
+    GET_CHAIN_INTERFACE(ifChainObj);
+    CBlockTreeDB *pblocktree = ifChainObj->GetBlockTreeDB();
 
-    GET_CONTRACT_INTERFACE(ifContractObj);
-    std::unordered_map<dev::h160, dev::u256> map = ifContractObj->GetContractList();
-    int contractsCount = (int)map.size();
+    CContractRegistryKey keyAfter;
+    bool fAfter = false;
+    if (request.params.size() > 2 && !request.params[2].isNull())
+    {
+        std::string strAddr = request.params[2].get_str();
+        if (strAddr.size() != 40 || !IsHex(strAddr))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Incorrect address");
+        if (!pblocktree->ReadContractRegistryKey(dev::Address(strAddr), keyAfter))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Address is not a registered contract");
+        fAfter = true;
+    }
 
-    if (contractsCount > 0 && start > contractsCount)
-        throw JSONRPCError(RPC_TYPE_ERROR, "start greater than max index " + itostr(contractsCount));
+    bool fVerbose = false;
+    if (request.params.size() > 3)
+        fVerbose = request.params[3].get_bool();
 
-    int itStartPos = std::min(start - 1, contractsCount);
-    int i = 0;
+    // the balances, and whether a registered contract still exists, come from the state at the tip
+    std::shared_ptr<CContractStateSnapshot> snapshot = GetContractStateSnapshot(-1);
 
-    for (auto it = std::next(map.begin(), itStartPos); it != map.end(); it++)
+    UniValue result(UniValue::VOBJ);
+    int nSkip = start - 1;
+    int i = 0;
+    std::vector<std::pair<CContractRegistryKey, CContractRegistryEntry>> contracts;
+    do
     {
-        CAmount balance = ifContractObj->GetContractBalance(it->first);
-        result.push_back(Pair(it->first.hex(), ValueFromAmount(balance)));
-        i++;
-        if (i == maxDisplay)
-            break;
-    }
+        contracts.clear();
+        if (!pblocktree->ReadContractRegistry(fAfter ? &keyAfter : nullptr, maxDisplay, contracts))
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the contract registry");
+
+        for (const auto &e : contracts)
+        {
+            if (i == maxDisplay)
+                break;
+            keyAfter = e.first;
+            fAfter = true;
+            if (!snapshot->AddressInUse(e.first.address))
+                continue;
+            if (nSkip > 0)
+            {
+                nSkip--;
+                continue;
+            }
+
+            CAmount balance = CAmount(snapshot->GetBalance(e.first.address));
+            if (fVerbose)
+            {
+                UniValue contract(UniValue::VOBJ);
+                contract.push_back(Pair("balance", ValueFromAmount(balance)));
+                contract.push_back(Pair("height", (int)e.first.height));
+                if (!e.second.txid.IsNull())
+                    contract.push_back(Pair("txid", e.second.txid.GetHex()));
+                contract.push_back(Pair("codehash", e.second.hashCode.GetHex()));
+                result.push_back(Pair(e.first.address.hex(), contract));
+            } else
+            {
+                result.push_back(Pair(e.first.address.hex(), ValueFromAmount(balance)));
+            }
+            i++;
+        }
+    } while (i < maxDisplay && (int)contracts.size() == maxDisplay);
+
+    if (i == 0 && start > 1)
+        throw JSONRPCError(RPC_TYPE_ERROR, "start greater than max index");
 
     return result;
 }
@@ -2311,6 +2403,52 @@ UniValue reconsiderblock(const JSONRPCRequest &request)
     return NullUniValue;
 }
 
+UniValue getimportinfo(const JSONRPCRequest &request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+                "getimportinfo\n"
+                        "\nReturns the progress of the -reindex or -loadblock import running in the background.\n"
+                        "\nResult:\n"
+                        "{\n"
+                        "  \"importing\": true|false,  (boolean) if an import is running\n"
+                        "  \"reindex\": true|false,    (boolean) if the import started by rebuilding the block index from the blk files\n"
+                        "  \"file\": \"xxxx\",          (string) the file being imported\n"
+                        "  \"fileindex\": n,          (numeric) 1-based index of that file among the files to import, 0 before the first\n"
+                        "  \"files\": n,              (numeric) number of files to import: the blk files of a reindex, bootstrap.dat and the -loadblock files\n"
+                        "  \"filebytesread\": n,      (numeric) bytes of the file read so far\n"
+                        "  \"filesize\": n,           (numeric) size of the file in bytes\n"
+                        "  \"blocksread\": n,         (numeric) blocks read from the files so far\n"
+                        "  \"blocksloaded\": n,       (numeric) blocks of the finished files that were new to the block index\n"
+                        "  \"blocks\": n,             (numeric) the current number of blocks of the active chain\n"
+                        "  \"elapsed\": n             (numeric) seconds since the import started\n"
+                        "}\n"
+                        "\nExamples:\n"
+                + HelpExampleCli("getimportinfo", "")
+                + HelpExampleRpc("getimportinfo", "")
+        );
+
+    GET_CHAIN_INTERFACE(ifChainObj);
+    CImportProgress progress = ifChainObj->GetImportProgress();
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("importing", progress.fActive));
+    obj.push_back(Pair("reindex", progress.fReindex));
+    obj.push_back(Pair("file", progress.strFile));
+    obj.push_back(Pair("fileindex", progress.nFile));
+    obj.push_back(Pair("files", progress.nFiles));
+    obj.push_back(Pair("filebytesread", progress.nFileBytesRead));
+    obj.push_back(Pair("filesize", progress.nFileSize));
+    obj.push_back(Pair("blocksread", progress.nBlocksRead));
+    obj.push_back(Pair("blocksloaded", progress.nBlocksLoaded));
+    {
+        LOCK(cs_main);
+        obj.push_back(Pair("blocks", (int)ifChainObj->GetActiveChain().Height()));
+    }
+    obj.push_back(Pair("elapsed", progress.nStartTime ? GetTime() - progress.nStartTime : 0));
+    return obj;
+}
+
 UniValue getchaintxstats(const JSONRPCRequest &request)
 {
     if (request.fHelp || request.params.size() > 2)
@@ -2389,6 +2527,7 @@ static const CRPCCommand commands[] =
                 //  --------------------- ---------------------- --  -----------------------  ------ ----------
                 {"blockchain", "getblockchaininfo",     &getblockchaininfo,     true, {}},
                 {"blockchain", "getchaintxstats",       &getchaintxstats,       true, {"nblocks",    "blockhash"}},
+                {"blockchain", "getimportinfo",         &getimportinfo,         true, {}},
                 {"blockchain", "getbestblockhash",      &getbestblockhash,      true, {}},
                 {"blockchain", "getblockcount",         &getblockcount,         true, {}},
                 {"blockchain", "getblock",              &getblock,              true, {"blockhash",  "verbosity|verbose"}},
@@ -2418,7 +2557,7 @@ static const CRPCCommand commands[] =
                 {"blockchain", "getaccountinfo",        &getaccountinfo,        true, {"contract_address"}},
                 {"blockchain", "getstorage",            &getstorage,            true, {"address, index, blockNum"}},
                 {"blockchain", "callcontract",          &callcontract,          true, {"address",    "data"}},
-                {"blockchain", "listcontracts",         &listcontracts,         true, {"start",      "maxDisplay"}},
+                {"blockchain", "listcontracts",         &listcontracts,         true, {"start",      "maxDisplay", "after", "verbose"}},
                 {"blockchain", "gettransactionreceipt", &gettransactionreceipt, true, {"hash"}},
                 {"blockchain", "searchlogs",            &searchlogs,            true, {"fromBlock",  "toBlock", "address", "topics"}},
 
@@ -142,6 +142,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
 
                 { "listcontracts", 0, "start" },
                 { "listcontracts", 1, "maxDisplay" },
+                { "listcontracts", 3, "verbose" },
                 { "getstorage", 2, "index" },
                 { "getstorage", 1, "blockNum" },
                 { "callcontract", 3, "gasLimit" },
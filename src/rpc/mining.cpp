@@ -26,6 +26,7 @@
 #include "framework/warnings.h"
 #include "sbtcd/baseimpl.hpp"
 #include "interface/ichaincomponent.h"
+#include "interface/iminercomponent.h"
 
 #include <memory>
 #include <stdint.h>
@@ -220,6 +221,7 @@ UniValue getmininginfo(const JSONRPCRequest &request)
                         "  \"difficulty\": xxx.xxxxx    (numeric) The current difficulty\n"
                         "  \"errors\": \"...\"            (string) Current errors\n"
                         "  \"networkhashps\": nnn,      (numeric) The network hashes per second\n"
+                        "  \"hashespersec\": nnn,       (numeric) The hashes per second of the internal miner (-gen)\n"
                         "  \"pooledtx\": n              (numeric) The size of the mempool\n"
                         "  \"chain\": \"xxxx\",           (string) current network name as defined in BIP70 (main, test, regtest)\n"
                         "}\n"
@@ -242,6 +244,8 @@ UniValue getmininginfo(const JSONRPCRequest &request)
     obj.push_back(Pair("difficulty", (double)GetDifficulty()));
     obj.push_back(Pair("errors", GetWarnings("statusbar")));
     obj.push_back(Pair("networkhashps", getnetworkhashps(request)));
+    GET_MINER_INTERFACE(ifMinerObj);
+    obj.push_back(Pair("hashespersec", ifMinerObj->GetHashesPerSec()));
     obj.push_back(Pair("pooledtx", (uint64_t)mempool.size()));
     obj.push_back(Pair("chain", Params().NetworkIDString()));
     return obj;
@@ -9,6 +9,8 @@
 #include "sbtccore/core_io.h"
 #include "base/base.hpp"
 #include "interface/ichaincomponent.h"
+#include "interface/icontractcomponent.h"
+#include "contract/libevm/VMAnalysisCache.h"
 #include "block/validation.h"
 #include "utils/net/httpserver.h"
 #include "p2p/net.h"
@@ -545,6 +547,34 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCContractNodeCacheInfo()
+{
+    GET_CONTRACT_INTERFACE(ifContractObj);
+    dev::NodeCache::Stats stats = ifContractObj->GetNodeCacheStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("entries", uint64_t(stats.entries)));
+    obj.push_back(Pair("usage", uint64_t(stats.memoryUsage)));
+    obj.push_back(Pair("max", uint64_t(stats.maxMemoryUsage)));
+    obj.push_back(Pair("hits", stats.hits));
+    obj.push_back(Pair("misses", stats.misses));
+    uint64_t lookups = stats.hits + stats.misses;
+    obj.push_back(Pair("hitrate", lookups ? (double)stats.hits / lookups : 0.0));
+    return obj;
+}
+
+static UniValue RPCEVMAnalysisCacheInfo()
+{
+    dev::eth::VMAnalysisCache &cache = dev::eth::VMAnalysisCache::instance();
+    uint64_t hits = cache.hits();
+    uint64_t misses = cache.misses();
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("entries", uint64_t(cache.size())));
+    obj.push_back(Pair("hits", hits));
+    obj.push_back(Pair("misses", misses));
+    obj.push_back(Pair("hitrate", hits + misses ? (double)hits / (hits + misses) : 0.0));
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 
 static std::string RPCMallocInfo()
@@ -590,6 +620,20 @@ UniValue getmemoryinfo(const JSONRPCRequest &request)
                         "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
                         "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
                         "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+                        "  },\n"
+                        "  \"contractnodes\": {        (json object) Cache of contract state trie nodes read from disk\n"
+                        "    \"entries\": xxxxx,       (numeric) Number of cached nodes\n"
+                        "    \"usage\": xxxxx,         (numeric) Number of bytes used\n"
+                        "    \"max\": xxxxx,           (numeric) Number of bytes the cache may use\n"
+                        "    \"hits\": xxxxx,          (numeric) Lookups answered from the cache\n"
+                        "    \"misses\": xxxxx,        (numeric) Lookups that went to disk\n"
+                        "    \"hitrate\": x.xxx,       (numeric) Fraction of the lookups answered from the cache\n"
+                        "  },\n"
+                        "  \"evmanalysis\": {          (json object) Cache of the EVM analysis of contract code, by code hash\n"
+                        "    \"entries\": xxxxx,       (numeric) Number of cached analyses\n"
+                        "    \"hits\": xxxxx,          (numeric) Executions that reused a cached analysis\n"
+                        "    \"misses\": xxxxx,        (numeric) Executions that analysed their code\n"
+                        "    \"hitrate\": x.xxx,       (numeric) Fraction of the lookups answered from the cache\n"
                         "  }\n"
                         "}\n"
                         "\nResult (mode \"mallocinfo\"):\n"
@@ -605,6 +649,8 @@ UniValue getmemoryinfo(const JSONRPCRequest &request)
     {
         UniValue obj(UniValue::VOBJ);
         obj.push_back(Pair("locked", RPCLockedMemoryInfo()));
+        obj.push_back(Pair("contractnodes", RPCContractNodeCacheInfo()));
+        obj.push_back(Pair("evmanalysis", RPCEVMAnalysisCacheInfo()));
         return obj;
     } else if (mode == "mallocinfo")
     {
@@ -852,6 +898,7 @@ UniValue listcheckpoint(const JSONRPCRequest &request)
 
     const CChainParams &chainParams = Params();
     UniValue retArray(UniValue::VARR);
+    LOCK(cs_main);
     const MapCheckpoints &checkpoints = chainParams.Checkpoints().mapCheckpoints;
     for (const MapCheckpoints::value_type &i : reverse_iterate(checkpoints))
     {
@@ -110,6 +110,15 @@ UniValue getpeerinfo(const JSONRPCRequest &request)
                         "    \"bytesrecv_per_msg\": {\n"
                         "       \"addr\": n,              (numeric) The total bytes received aggregated by message type\n"
                         "       ...\n"
+                        "    },\n"
+                        "    \"latency_per_msg\": {\n"
+                        "       \"addr\": {             (json object) Processing of the received messages of this type\n"
+                        "         \"count\": n,           (numeric) The number of messages processed\n"
+                        "         \"avgwait_us\": n,      (numeric) Average microseconds between receiving and processing a message\n"
+                        "         \"avg_us\": n,          (numeric) Average microseconds spent processing a message\n"
+                        "         \"max_us\": n           (numeric) The longest time spent processing a message, in microseconds\n"
+                        "       },\n"
+                        "       ...\n"
                         "    }\n"
                         "  }\n"
                         "  ,...\n"
@@ -190,6 +199,21 @@ UniValue getpeerinfo(const JSONRPCRequest &request)
         }
         obj.push_back(Pair("bytesrecv_per_msg", recvPerMsgCmd));
 
+        UniValue latencyPerMsgCmd(UniValue::VOBJ);
+        for (const mapMsgCmdLatency::value_type &i : stats.mapLatencyPerMsgCmd)
+        {
+            if (i.second.nCount > 0)
+            {
+                UniValue latency(UniValue::VOBJ);
+                latency.push_back(Pair("count", i.second.nCount));
+                latency.push_back(Pair("avgwait_us", i.second.nTotalWaitMicros / (int64_t)i.second.nCount));
+                latency.push_back(Pair("avg_us", i.second.nTotalMicros / (int64_t)i.second.nCount));
+                latency.push_back(Pair("max_us", i.second.nMaxMicros));
+                latencyPerMsgCmd.push_back(Pair(i.first, latency));
+            }
+        }
+        obj.push_back(Pair("latency_per_msg", latencyPerMsgCmd));
+
         ret.push_back(obj);
     }
 
@@ -35,11 +35,68 @@ std::string CBlock::ToString() const
     return s.str();
 }
 
+/** Fast path for the "<hashStateRoot> <hashUTXORoot> OP_VM_STATE" layout the miner writes.
+ *  The roots are pushed as GetHex() bytes, i.e. in reversed byte order. */
+static bool DecodeVMStateScriptRaw(const CScript &script, uint256 &hashStateRoot, uint256 &hashUTXORoot)
+{
+    static const size_t HASH_SIZE = 32;
+    if (script.size() != 2 * (HASH_SIZE + 1) + 1 || script[0] != HASH_SIZE || script[HASH_SIZE + 1] != HASH_SIZE ||
+        script[2 * (HASH_SIZE + 1)] != OP_VM_STATE)
+    {
+        return false;
+    }
+
+    const unsigned char *pState = &script[1];
+    const unsigned char *pUTXO = &script[HASH_SIZE + 2];
+    unsigned char *pStateOut = hashStateRoot.begin();
+    unsigned char *pUTXOOut = hashUTXORoot.begin();
+    for (size_t i = 0; i < HASH_SIZE; i++)
+    {
+        pStateOut[i] = pState[HASH_SIZE - 1 - i];
+        pUTXOOut[i] = pUTXO[HASH_SIZE - 1 - i];
+    }
+    return true;
+}
+
+bool DecodeVMStateScript(const CScript &script, uint256 &hashStateRoot, uint256 &hashUTXORoot)
+{
+    if (DecodeVMStateScriptRaw(script, hashStateRoot, hashUTXORoot))
+    {
+        return true;
+    }
+
+    // any other encoding goes through the script interpreter
+    std::vector<std::vector<unsigned char> > stack;
+    EvalScript(stack, script, SCRIPT_EXEC_BYTE_CODE, BaseSignatureChecker(), SIGVERSION_BASE, nullptr);
+    if (stack.size() < 3)
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> code(stack.back());
+    stack.pop_back();
+
+    std::vector<unsigned char> vechashUTXORoot(stack.back());
+    stack.pop_back();
+    hashUTXORoot = uint256S(HexStr(vechashUTXORoot));
+
+    std::vector<unsigned char> vechashStateRoot(stack.back());
+    stack.pop_back();
+    hashStateRoot = uint256S(HexStr(vechashStateRoot));
+    return true;
+}
+
 VM_STATE_ROOT CBlock::GetVMState(uint256 &hashStateRoot, uint256 &hashUTXORoot) const
 {
     if (this->nVersion & (((uint32_t) 1) << VERSIONBITS_SBTC_CONTRACT))
     {
         assert(vtx.size() > 1);
+        // transactions are immutable, so the cached result holds as long as coinbase2 is the same object
+        if (vmStateCache.Lookup(vtx[1], hashStateRoot, hashUTXORoot))
+        {
+            return RET_VM_STATE_OK;
+        }
+
         const CTransaction &tx = *(vtx[1]);  // 0
         assert(tx.IsCoinBase2() == true);
 
@@ -61,10 +118,7 @@ VM_STATE_ROOT CBlock::GetVMState(uint256 &hashStateRoot, uint256 &hashUTXORoot)
             return RET_VM_STATE_ERR;
         }
         // have VmHashState vout
-        std::vector<std::vector<unsigned char> > stack;
-        EvalScript(stack, tx.vout[index].scriptPubKey, SCRIPT_EXEC_BYTE_CODE, BaseSignatureChecker(),
-                   SIGVERSION_BASE, nullptr);
-        if (stack.empty())
+        if (!DecodeVMStateScript(tx.vout[index].scriptPubKey, hashStateRoot, hashUTXORoot))
         {
             // VmHashState vout script err
             assert(0);
@@ -72,24 +126,9 @@ VM_STATE_ROOT CBlock::GetVMState(uint256 &hashStateRoot, uint256 &hashUTXORoot)
             return RET_VM_STATE_ERR;
         }
 
-        std::vector<unsigned char> code(stack.back());
-        stack.pop_back();
-
-        std::vector<unsigned char> vechashUTXORoot(stack.back());
-        stack.pop_back();
-
-        std::string strUTXO;
-        strUTXO = HexStr(vechashUTXORoot);
-        hashUTXORoot = uint256S(strUTXO);
-
-        std::vector<unsigned char> vechashStateRoot(stack.back());
-        stack.pop_back();
-
-        std::string strHASH;
-        strHASH = HexStr(vechashStateRoot);
-        hashStateRoot = uint256S(strHASH);
+        vmStateCache.Set(vtx[1], hashStateRoot, hashUTXORoot);
         return RET_VM_STATE_OK;
     }else {
         return RET_CONTRACT_UNENBALE;
     }
-}
\ No newline at end of file
+}
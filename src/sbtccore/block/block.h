@@ -6,6 +6,7 @@
 #ifndef BITCOIN_PRIMITIVES_BLOCK_H
 #define BITCOIN_PRIMITIVES_BLOCK_H
 
+#include <mutex>
 #include <contract-api/contractconfig.h>
 #include "transaction/transaction.h"
 #include "sbtccore/serialize.h"
@@ -86,6 +87,71 @@ public:
 };
 
 
+/** GetVMState() result for the coinbase2 it was decoded from. Blocks are shared between threads as const,
+ * so it is filled under a lock of its own; copies get their own lock. */
+class CVMStateCache
+{
+public:
+    CVMStateCache()
+    {
+    }
+
+    CVMStateCache(const CVMStateCache &other)
+    {
+        other.Get(tx, hashStateRoot, hashUTXORoot);
+    }
+
+    CVMStateCache &operator=(const CVMStateCache &other)
+    {
+        if (this != &other)
+        {
+            CTransactionRef txOther;
+            uint256 hashStateRootOther, hashUTXORootOther;
+            other.Get(txOther, hashStateRootOther, hashUTXORootOther);
+            Set(txOther, hashStateRootOther, hashUTXORootOther);
+        }
+        return *this;
+    }
+
+    /** The roots, if they were decoded from txIn */
+    bool Lookup(const CTransactionRef &txIn, uint256 &hashStateRootOut, uint256 &hashUTXORootOut) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!tx || tx != txIn)
+            return false;
+        hashStateRootOut = hashStateRoot;
+        hashUTXORootOut = hashUTXORoot;
+        return true;
+    }
+
+    void Set(const CTransactionRef &txIn, const uint256 &hashStateRootIn, const uint256 &hashUTXORootIn)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tx = txIn;
+        hashStateRoot = hashStateRootIn;
+        hashUTXORoot = hashUTXORootIn;
+    }
+
+    void Clear()
+    {
+        Set(CTransactionRef(), uint256(), uint256());
+    }
+
+private:
+    void Get(CTransactionRef &txOut, uint256 &hashStateRootOut, uint256 &hashUTXORootOut) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        txOut = tx;
+        hashStateRootOut = hashStateRoot;
+        hashUTXORootOut = hashUTXORoot;
+    }
+
+    mutable std::mutex mutex;
+    CTransactionRef tx;
+    uint256 hashStateRoot;
+    uint256 hashUTXORoot;
+};
+
 class CBlock : public CBlockHeader
 {
 public:
@@ -94,6 +160,8 @@ public:
 
     // memory only
     mutable bool fChecked;
+    // memory only
+    mutable CVMStateCache vmStateCache;
 
     CBlock()
     {
@@ -120,6 +188,7 @@ public:
         CBlockHeader::SetNull();
         vtx.clear();
         fChecked = false;
+        vmStateCache.Clear();
     }
 
     CBlockHeader GetBlockHeader() const
@@ -139,6 +208,9 @@ public:
     std::string ToString() const;
 };
 
+/** Decode hashStateRoot/hashUTXORoot from an OP_VM_STATE output script */
+bool DecodeVMStateScript(const CScript &script, uint256 &hashStateRoot, uint256 &hashUTXORoot);
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
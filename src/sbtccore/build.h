@@ -0,0 +1 @@
+#define BUILD_SUFFIX 0eb6193
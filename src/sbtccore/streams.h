@@ -760,6 +760,16 @@ public:
         }
     }
 
+    /** Get wrapped FILE* with transfer of ownership, the buffered bytes are dropped.
+     * @note The position of the returned FILE* is past the bytes read so far, seek it before reading again.
+     */
+    FILE *release()
+    {
+        FILE *ret = src;
+        src = nullptr;
+        return ret;
+    }
+
     // check whether we're at the end of the source file
     bool eof() const
     {
@@ -31,6 +31,12 @@ static const char DB_BLOCK_INDEX = 'b';
 
 ////////////////////////////////////////// // sbtc-vm
 static const char DB_HEIGHTINDEX = 'h';
+static const char DB_LOGBLOOM = 'L';
+static const char DB_LOGRANGEBLOOM = 'M';
+static const char DB_LOGTOPICINDEX = 'T';
+static const char DB_LOGINDEXSTART = 'S';
+static const char DB_CONTRACTREGISTRY = 'K';
+static const char DB_CONTRACTORDER = 'O';
 //////////////////////////////////////////
 
 static const char DB_BEST_BLOCK = 'B';
@@ -320,7 +326,8 @@ bool CBlockTreeDB::WriteHeightIndex(const CHeightTxIndexKey &heightIndex, const
 
 int CBlockTreeDB::ReadHeightIndex(int low, int high, int minconf,
                                   std::vector<std::vector<uint256>> &blocksOfHashes,
-                                  std::set<dev::h160> const &addresses) {
+                                  std::set<dev::h160> const &addresses,
+                                  std::function<bool(unsigned int)> const &filterHeight) {
 
     if ((high < low && high > -1) || (high == 0 && low == 0) || (high < -1 || low < 0)) {
         return -1;
@@ -331,6 +338,15 @@ int CBlockTreeDB::ReadHeightIndex(int low, int high, int minconf,
     pcursor->Seek(std::make_pair(DB_HEIGHTINDEX, CHeightTxIndexIteratorKey(low)));
 
     int curheight = 0;
+    int filteredHeight = -1;
+    bool filterPassed = true;
+
+    // searchlogs calls this without cs_main, the published view is safe to read
+    int chainHeight = -1;
+    if (minconf > 0) {
+        GET_CHAIN_INTERFACE(ifChainObj);
+        chainHeight = ifChainObj->GetActiveChainView()->Height();
+    }
 
     for (size_t count = 0; pcursor->Valid(); pcursor->Next()) {
 
@@ -346,8 +362,7 @@ int CBlockTreeDB::ReadHeightIndex(int low, int high, int minconf,
         }
 
         if (minconf > 0) {
-            GET_CHAIN_INTERFACE(ifChainObj);
-            int conf = ifChainObj->GetActiveChain().Height() - nextHeight;
+            int conf = chainHeight - nextHeight;
             if (conf < minconf) {
                 break;
             }
@@ -360,6 +375,14 @@ int CBlockTreeDB::ReadHeightIndex(int low, int high, int minconf,
             continue;
         }
 
+        if (filterHeight && filteredHeight != nextHeight) {
+            filteredHeight = nextHeight;
+            filterPassed = filterHeight(nextHeight);
+        }
+        if (!filterPassed) {
+            continue;
+        }
+
         std::vector<uint256> hashesTx;
 
         if (!pcursor->GetValue(hashesTx)) {
@@ -416,6 +439,212 @@ bool CBlockTreeDB::WipeHeightIndex() {
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::WriteLogIndex(unsigned int height, const CBlockLogIndex &logIndex) {
+    CDBBatch batch(*this);
+
+    std::vector<CLogTopicIndexKey> keys;
+    for (const auto &e : logIndex.topics) {
+        CLogTopicIndexKey key(e.first.first, e.first.second, height);
+        batch.Write(std::make_pair(DB_LOGTOPICINDEX, key), e.second);
+        keys.push_back(key);
+    }
+    batch.Write(std::make_pair(DB_LOGBLOOM, CHeightTxIndexIteratorKey(height)),
+                std::make_pair(logIndex.bloom.asBytes(), keys));
+
+    int start;
+    if (!ReadLogIndexStart(start)) {
+        batch.Write(DB_LOGINDEXSTART, (int)height);
+    }
+
+    dev::h2048 rangeBloom;
+    ReadLogRangeBloom(height / LOG_BLOOM_RANGE, rangeBloom);
+    rangeBloom |= logIndex.bloom;
+    batch.Write(std::make_pair(DB_LOGRANGEBLOOM, CHeightTxIndexIteratorKey(height / LOG_BLOOM_RANGE)),
+                rangeBloom.asBytes());
+
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadLogIndexStart(int &height) {
+    return Read(DB_LOGINDEXSTART, height);
+}
+
+bool CBlockTreeDB::ReadLogBloom(unsigned int height, dev::h2048 &bloom) {
+    std::pair<std::vector<unsigned char>, std::vector<CLogTopicIndexKey>> value;
+    if (!Read(std::make_pair(DB_LOGBLOOM, CHeightTxIndexIteratorKey(height)), value) ||
+        value.first.size() != dev::h2048::size) {
+        return false;
+    }
+    bloom = dev::h2048(value.first);
+    return true;
+}
+
+bool CBlockTreeDB::ReadLogRangeBloom(unsigned int range, dev::h2048 &bloom) {
+    std::vector<unsigned char> value;
+    if (!Read(std::make_pair(DB_LOGRANGEBLOOM, CHeightTxIndexIteratorKey(range)), value) ||
+        value.size() != dev::h2048::size) {
+        return false;
+    }
+    bloom = dev::h2048(value);
+    return true;
+}
+
+int CBlockTreeDB::ReadLogTopicIndex(int low, int high, int minconf,
+                                    std::vector<std::vector<uint256>> &blocksOfHashes,
+                                    std::set<dev::h160> const &addresses, dev::h256 const &topic) {
+
+    if ((high < low && high > -1) || (high == 0 && low == 0) || (high < -1 || low < 0)) {
+        return -1;
+    }
+
+    int maxHeight = high;
+    if (minconf > 0) {
+        GET_CHAIN_INTERFACE(ifChainObj);
+        int confirmedHeight = ifChainObj->GetActiveChainView()->Height() - minconf;
+        if (maxHeight < 0 || maxHeight > confirmedHeight) {
+            maxHeight = confirmedHeight;
+        }
+        if (maxHeight < low) {
+            return 0;
+        }
+    }
+
+    // the postings are per address, put them back in the (height, address) order of the height index
+    std::map<std::pair<unsigned int, dev::h160>, std::vector<uint256>> postings;
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    for (const dev::h160 &address : addresses) {
+        pcursor->Seek(std::make_pair(DB_LOGTOPICINDEX, CLogTopicIndexKey(address, topic, low)));
+        for (; pcursor->Valid(); pcursor->Next()) {
+            std::pair<char, CLogTopicIndexKey> key;
+            if (!pcursor->GetKey(key) || key.first != DB_LOGTOPICINDEX || key.second.address != address ||
+                key.second.topic != topic) {
+                break;
+            }
+            if (maxHeight > -1 && (int)key.second.height > maxHeight) {
+                break;
+            }
+            std::vector<uint256> hashesTx;
+            if (!pcursor->GetValue(hashesTx)) {
+                break;
+            }
+            postings[std::make_pair(key.second.height, address)] = std::move(hashesTx);
+        }
+    }
+
+    int curheight = 0;
+    for (auto &e : postings) {
+        curheight = e.first.first;
+        blocksOfHashes.push_back(std::move(e.second));
+    }
+    return curheight;
+}
+
+bool CBlockTreeDB::EraseLogIndex(unsigned int height) {
+    std::pair<std::vector<unsigned char>, std::vector<CLogTopicIndexKey>> value;
+    if (!Read(std::make_pair(DB_LOGBLOOM, CHeightTxIndexIteratorKey(height)), value)) {
+        return true;
+    }
+
+    CDBBatch batch(*this);
+    for (const CLogTopicIndexKey &key : value.second) {
+        batch.Erase(std::make_pair(DB_LOGTOPICINDEX, key));
+    }
+    batch.Erase(std::make_pair(DB_LOGBLOOM, CHeightTxIndexIteratorKey(height)));
+    return WriteBatch(batch);
+}
+
+template<typename K>
+static void EraseAllWithPrefix(CDBIterator *pcursor, CDBBatch &batch, char prefix) {
+    pcursor->Seek(prefix);
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, K> key;
+        if (pcursor->GetKey(key) && key.first == prefix) {
+            batch.Erase(key);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+}
+
+bool CBlockTreeDB::WipeLogIndex() {
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+
+    EraseAllWithPrefix<CHeightTxIndexIteratorKey>(pcursor.get(), batch, DB_LOGBLOOM);
+    EraseAllWithPrefix<CHeightTxIndexIteratorKey>(pcursor.get(), batch, DB_LOGRANGEBLOOM);
+    EraseAllWithPrefix<CLogTopicIndexKey>(pcursor.get(), batch, DB_LOGTOPICINDEX);
+    batch.Erase(DB_LOGINDEXSTART);
+
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::WriteContractRegistry(unsigned int height,
+                                         const std::vector<std::pair<dev::h160, CContractRegistryEntry>> &contracts) {
+    CDBBatch batch(*this);
+    for (size_t i = 0; i < contracts.size(); i++) {
+        const dev::h160 &address = contracts[i].first;
+        // a contract registered from the state it was found in is moved to the block creating it again
+        CContractRegistryKey keyOld;
+        if (ReadContractRegistryKey(address, keyOld)) {
+            batch.Erase(std::make_pair(DB_CONTRACTORDER, keyOld));
+        }
+        CContractRegistryKey key(height, (unsigned int)i, address);
+        batch.Write(std::make_pair(DB_CONTRACTREGISTRY, address.asBytes()), key);
+        batch.Write(std::make_pair(DB_CONTRACTORDER, key), contracts[i].second);
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadContractRegistryKey(const dev::h160 &address, CContractRegistryKey &key) {
+    return Read(std::make_pair(DB_CONTRACTREGISTRY, address.asBytes()), key);
+}
+
+bool CBlockTreeDB::ReadContractRegistry(const CContractRegistryKey *pafter, size_t nCount,
+                                        std::vector<std::pair<CContractRegistryKey, CContractRegistryEntry>> &contracts) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    if (pafter) {
+        pcursor->Seek(std::make_pair(DB_CONTRACTORDER, *pafter));
+    } else {
+        pcursor->Seek(DB_CONTRACTORDER);
+    }
+
+    for (; pcursor->Valid() && contracts.size() < nCount; pcursor->Next()) {
+        std::pair<char, CContractRegistryKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_CONTRACTORDER) {
+            break;
+        }
+        if (pafter && key.second.height == pafter->height && key.second.order == pafter->order &&
+            key.second.address == pafter->address) {
+            continue;
+        }
+        CContractRegistryEntry entry;
+        if (!pcursor->GetValue(entry)) {
+            return rLogError("%s: failed to read value", __func__);
+        }
+        contracts.push_back(std::make_pair(key.second, entry));
+    }
+    return true;
+}
+
+bool CBlockTreeDB::EraseContractRegistry(unsigned int height) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+
+    pcursor->Seek(std::make_pair(DB_CONTRACTORDER, CContractRegistryKey(height, 0, dev::h160())));
+    for (; pcursor->Valid(); pcursor->Next()) {
+        std::pair<char, CContractRegistryKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_CONTRACTORDER || key.second.height != height) {
+            break;
+        }
+        batch.Erase(std::make_pair(DB_CONTRACTREGISTRY, key.second.address.asBytes()));
+        batch.Erase(key);
+    }
+    return WriteBatch(batch);
+}
+
 ///////////////////////////////////////////////////////
 
 bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params &consensusParams,
@@ -449,6 +678,8 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params &consensusParams,
                 pindexNew->nNonce = diskindex.nNonce;
                 pindexNew->nStatus = diskindex.nStatus;
                 pindexNew->nTx = diskindex.nTx;
+                pindexNew->hashStateRoot = diskindex.hashStateRoot;
+                pindexNew->hashUTXORoot = diskindex.hashUTXORoot;
 
                 if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
                 {
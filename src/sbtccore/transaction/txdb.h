@@ -10,6 +10,7 @@
 #include "dbwrapper.h"
 #include "chaincontrol/chain.h"
 
+#include <functional>
 #include <map>
 #include <string>
 #include <utility>
@@ -38,6 +39,8 @@ static const int64_t nMaxBlockDBCache = 2;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
+//! Blocks covered by one range bloom of the log index
+static const unsigned int LOG_BLOOM_RANGE = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -180,10 +183,46 @@ public:
      */
     int ReadHeightIndex(int low, int high, int minconf,
                         std::vector<std::vector<uint256>> &blocksOfHashes,
-                        std::set<dev::h160> const &addresses);
+                        std::set<dev::h160> const &addresses,
+                        std::function<bool(unsigned int)> const &filterHeight = nullptr);
     bool EraseHeightIndex(const unsigned int &height);
     bool WipeHeightIndex();
 
+    /** Writes the log bloom and topic postings of a block, and merges the bloom into its range bloom */
+    bool WriteLogIndex(unsigned int height, const CBlockLogIndex &logIndex);
+
+    /** Height of the first block written to the log index. Blocks from there on without a log bloom have no logs */
+    bool ReadLogIndexStart(int &height);
+
+    bool ReadLogBloom(unsigned int height, dev::h2048 &bloom);
+
+    /** Bloom of all the blocks in [range * LOG_BLOOM_RANGE, (range + 1) * LOG_BLOOM_RANGE) */
+    bool ReadLogRangeBloom(unsigned int range, dev::h2048 &bloom);
+
+    /**
+     * Like ReadHeightIndex, restricted to the transactions of the given addresses that emitted
+     * a log whose first topic is topic. Blocks come in height order, then address order.
+     */
+    int ReadLogTopicIndex(int low, int high, int minconf,
+                          std::vector<std::vector<uint256>> &blocksOfHashes,
+                          std::set<dev::h160> const &addresses, dev::h256 const &topic);
+
+    /** Range blooms are left as they are: a disconnected block only makes them less selective */
+    bool EraseLogIndex(unsigned int height);
+    bool WipeLogIndex();
+
+    /** Registers the contracts created by the block at height, in creation order */
+    bool WriteContractRegistry(unsigned int height,
+                               const std::vector<std::pair<dev::h160, CContractRegistryEntry>> &contracts);
+
+    bool ReadContractRegistryKey(const dev::h160 &address, CContractRegistryKey &key);
+
+    /** Up to nCount registered contracts in creation order, from the first one or the one after *pafter */
+    bool ReadContractRegistry(const CContractRegistryKey *pafter, size_t nCount,
+                              std::vector<std::pair<CContractRegistryKey, CContractRegistryEntry>> &contracts);
+
+    bool EraseContractRegistry(unsigned int height);
+
     //////////////////////////////////////////////////////////////////////////////
 };
 
@@ -3,6 +3,8 @@
 #include <thread>
 #include <chrono>
 #include <functional>
+#include <mutex>
+#include <condition_variable>
 #include <signal.h>
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <log4cpp/PropertyConfigurator.hh>
@@ -32,6 +34,9 @@
 #include "config/consensus.h"
 #include "framework/validationinterface.h"
 #include "wallet/wallet.h"
+#include "interface/componentid.h"
+#include "contract-api/contractconfig.h"
+#include "contract/libdevcore/SHA3.h"
 
 void CApp::InitOptionMap()
 {
@@ -97,6 +102,12 @@ void CApp::InitOptionMap()
                     _("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
                     -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS).c_str()},
 
+            {
+                    "parallelinit", bpo::value<string>(), strprintf(
+                    "Initialize and start the components concurrently where they do not depend on each other (parameters: n, no, y, yes, default: %u)",
+                    DEFAULT_PARALLEL_INIT).c_str()
+            },
+
 #ifndef WIN32
             {"pid", bpo::value<string>(), "Specify pid file"},
 #endif
@@ -163,6 +174,9 @@ void CApp::InitOptionMap()
             {"maxsendbuffer", bpo::value<size_t>(), "Maximum per-connection send buffer, <n>*1000 bytes"},
             {"maxtimeadjustment", bpo::value<int64_t>(),
              "Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount."},
+            {"msghandlerthreads", bpo::value<int>(),
+             strprintf(_("Number of threads processing peer messages, peers are spread over them by id (1 to %d, default: %d)"),
+                       MAX_MSGHANDLER_THREADS, DEFAULT_MSGHANDLER_THREADS).c_str()},
             {"onion", bpo::value<string>(),
              strprintf(_("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"),
                        "-proxy").c_str()},
@@ -180,6 +194,9 @@ void CApp::InitOptionMap()
              "Randomize credentials for every proxy connection. This enables Tor stream isolation(parameters: n, no, y, yes)"},
             {"seednode", bpo::value<vector<string> >()->multitoken(),
              "Connect to a node to retrieve peer addresses, and disconnect"},
+            {"socketevents", bpo::value<string>(),
+             strprintf(_("Socket events mode, which must be one of: select, epoll (default: %s)"),
+                       DEFAULT_SOCKETEVENTS).c_str()},
             {"timeout", bpo::value<int>(),
              strprintf(_("Specify connection timeout in milliseconds (minimum: 1, default: %d)"),
                        DEFAULT_CONNECT_TIMEOUT).c_str()},
@@ -423,6 +440,15 @@ void CApp::InitOptionMap()
     item = {
             {"logevents", bpo::value<string>(), "Maintain a full EVM log index, used by searchlogs and gettransactionreceipt rpc calls"},
             {"record-log-opcodes", bpo::value<string>(), "Logs all EVM LOG opcode operations to the file vmExecLogs.json"},
+            {"contractdbcache", bpo::value<int64_t>(), strprintf(
+                    "Maximum contract state in megabytes kept in memory between flushes of the chain state (minimum %d, default: %d)",
+                    MIN_CONTRACT_DB_CACHE, DEFAULT_CONTRACT_DB_CACHE).c_str()},
+            {"contractnodecache", bpo::value<int64_t>(), strprintf(
+                    "Memory in megabytes for contract state trie nodes read from disk (default: %d)",
+                    DEFAULT_CONTRACT_NODE_CACHE).c_str()},
+            {"prunecontractstate", bpo::value<int>(), strprintf(
+                    "Delete the contract state of blocks more than <n> blocks below the tip. Reorganizations deeper than <n> blocks are no longer possible (default: %d = keep all contract state, otherwise at least %u)",
+                    DEFAULT_PRUNE_CONTRACT_STATE, MIN_BLOCKS_TO_KEEP).c_str()},
             {"dgpstorage", bpo::value<string>(), "Receiving data from DGP via storage (default: -dgpstorage)"},
             {"dgpevm", bpo::value<string>(), "Receiving data from DGP via a contract call (default: -dgpevm)"},
     };
@@ -920,6 +946,8 @@ bool CApp::AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     NLogFormat("Using the '%s' SHA256 implementation.", sha256_algo);
+    std::string sha3_algo = dev::sha3AutoDetect();
+    NLogFormat("Using the '%s' Keccak-256 implementation.", sha3_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1018,7 +1046,7 @@ bool CApp::Initialize(int argc, char **argv)
     GetMainSignals().RegisterBackgroundSignalScheduler(GetScheduler());
 
     // Components initialized.
-    return ForEachComponent(true, [](IComponent *component)
+    return RunComponentPhase(IComponent::initialized, [](IComponent *component)
     {
         return component->Initialize();
     });
@@ -1026,12 +1054,158 @@ bool CApp::Initialize(int argc, char **argv)
 
 bool CApp::Startup()
 {
-    return ForEachComponent(true, [](IComponent *component)
+    return RunComponentPhase(IComponent::started, [](IComponent *component)
     {
         return component->Startup();
     });
 }
 
+static const char *GetComponentName(int id)
+{
+    switch (id)
+    {
+        case CID_BLOCK_CHAIN:
+            return "chain";
+        case CID_CONTRACT:
+            return "contract";
+        case CID_TX_MEMPOOL:
+            return "mempool";
+        case CID_HTTP_RPC:
+            return "rpc";
+        case CID_P2P_NET:
+            return "net";
+        case CID_WALLET:
+            return "wallet";
+        case CID_MINER:
+            return "miner";
+        default:
+            return "component";
+    }
+}
+
+bool CApp::RunComponentPhase(IComponent::state phase, const std::function<bool(IComponent *)> &func)
+{
+    const char *strPhase = phase == IComponent::initialized ? "init" : "startup";
+
+    // only the dependencies on registered components are waited for
+    int nRegistered = 0;
+    for (const auto &entry : m_mapComponents)
+    {
+        nRegistered |= entry.first;
+    }
+    std::map<int, int> mapDependencies;
+    for (const auto &entry : m_mapComponents)
+    {
+        mapDependencies[entry.first] = entry.second->GetDependencies(phase) & nRegistered & ~entry.first;
+    }
+
+    // components in dependency order, ties in id order
+    std::vector<int> vOrder;
+    int nOrdered = 0;
+    while (vOrder.size() < mapDependencies.size())
+    {
+        bool fProgress = false;
+        for (const auto &entry : mapDependencies)
+        {
+            if (!(nOrdered & entry.first) && (entry.second & ~nOrdered) == 0)
+            {
+                vOrder.push_back(entry.first);
+                nOrdered |= entry.first;
+                fProgress = true;
+            }
+        }
+        if (!fProgress)
+        {
+            return rLogError("%s: the dependencies of the components form a cycle", __func__);
+        }
+    }
+
+    // id -> (ms waited for the dependencies, ms taken by the component)
+    std::map<int, std::pair<int64_t, int64_t>> mapTimes;
+    bool fFailed = false;
+    int64_t nPhaseStart = GetTimeMillis();
+
+    auto runComponent = [&](int id) -> bool
+    {
+        IComponent *component = m_mapComponents.at(id).get();
+        try
+        {
+            return func(component);
+        } catch (const std::exception &e)
+        {
+            return rLogError("%s %s: %s", GetComponentName(id), strPhase, e.what());
+        }
+    };
+
+    if (!pArgs->GetArg<bool>("-parallelinit", DEFAULT_PARALLEL_INIT))
+    {
+        for (int id : vOrder)
+        {
+            int64_t nStart = GetTimeMillis();
+            bool fOk = runComponent(id);
+            mapTimes[id] = std::make_pair(int64_t(0), GetTimeMillis() - nStart);
+            if (!fOk)
+            {
+                fFailed = true;
+                break;
+            }
+        }
+    } else
+    {
+        std::mutex mutex;
+        std::condition_variable condDone;
+        int nDone = 0;
+        std::vector<std::thread> threads;
+        for (int id : vOrder)
+        {
+            threads.emplace_back([&, id]()
+            {
+                RenameThread(strprintf("sbtc-%s-%s", strPhase, GetComponentName(id)).c_str());
+                int64_t nWaitStart = GetTimeMillis();
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    condDone.wait(lock, [&]
+                    { return fFailed || (mapDependencies.at(id) & ~nDone) == 0; });
+                    if (fFailed)
+                    {
+                        return;
+                    }
+                }
+                int64_t nStart = GetTimeMillis();
+                bool fOk = runComponent(id);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    mapTimes[id] = std::make_pair(nStart - nWaitStart, GetTimeMillis() - nStart);
+                    if (fOk)
+                    {
+                        nDone |= id;
+                    } else
+                    {
+                        fFailed = true;
+                    }
+                }
+                condDone.notify_all();
+            });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    NLogFormat("Components %s %s in %dms:", strPhase, fFailed ? "failed" : "done", GetTimeMillis() - nPhaseStart);
+    for (int id : vOrder)
+    {
+        auto it = mapTimes.find(id);
+        if (it != mapTimes.end())
+        {
+            NLogFormat("  %-8s %8dms, waited %dms for its dependencies", GetComponentName(id), it->second.second,
+                       it->second.first);
+        }
+    }
+    return !fFailed;
+}
+
 bool CApp::Run()
 {
     while (!bShutdown)
@@ -1073,6 +1247,11 @@ bool CApp::Shutdown()
 
     UnregisterAllValidationInterfaces();
     GetMainSignals().UnregisterBackgroundSignalScheduler();
+    // empty the slots first, a destructor looking up another component gets nullptr rather than a freed one
+    for (int id = 1; ComponentSlot(id) < MAX_COMPONENT_SLOTS; id <<= 1)
+    {
+        SetComponentSlot(id, nullptr);
+    }
     m_mapComponents.clear();
     globalVerifyHandle.reset();
     ECC_Stop();
@@ -1101,7 +1280,7 @@ bool CApp::RegisterComponent(IComponent *component)
     if (component)
     {
         int id = component->GetID();
-        if (m_mapComponents.find(id) == m_mapComponents.end())
+        if (m_mapComponents.find(id) == m_mapComponents.end() && SetComponentSlot(id, component))
         {
             m_mapComponents.emplace(id, component);
             return true;
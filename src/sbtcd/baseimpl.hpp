@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <map>
 #include <memory>
 #include <thread>
@@ -10,6 +11,9 @@
 
 using namespace appbase;
 
+//! Run the component phases concurrently, as far as the dependencies between components allow
+static const bool DEFAULT_PARALLEL_INIT = true;
+
 class ECCVerifyHandle;
 
 class CApp : public IBaseApp
@@ -53,6 +57,12 @@ private:
 
     bool AppInitLockDataDirectory();
 
+    /**
+     * Runs func, the Initialize or Startup phase of every component, in dependency order and logs how
+     * long each component took. Stops starting components once one of them has failed.
+     */
+    bool RunComponentPhase(IComponent::state phase, const std::function<bool(IComponent *)> &func);
+
 
     template<typename F, template<typename C> class CI = ContainerIterator>
     bool ForEachComponent(bool breakIfFailed, F &&func)
@@ -0,0 +1,2 @@
+namespace json_tests{
+static unsigned const char tx_valid[] = {
@@ -0,0 +1,186 @@
+// Copyright (c) 2018 The Super Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "contract-api/sbtcDGP.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(dgp_tests, BasicTestingSetup)
+
+    static const dev::Address templateAddress("00000000000000000000000000000000000000a0");
+
+    // The proposals of a DGP contract: their count at slot 0, then a (height, template address) pair per
+    // proposal from slot sha3(0) on
+    static void SetProposal(SbtcState &state, const dev::Address &dgp, unsigned int height,
+                            const dev::Address &addrTemplate)
+    {
+        state.createContract(dgp);
+        state.setStorage(dgp, 0, 1);
+        dev::h256 slot = dev::sha3(dev::h256());
+        state.setStorage(dgp, dev::u256(slot), height);
+        ++slot;
+        state.setStorage(dgp, dev::u256(slot), dev::u256(dev::u160(addrTemplate)));
+    }
+
+    // What the schedule getter of a template returns: the 39 values of SbtcDGP::createEVMSchedule, a word each
+    static std::vector<unsigned char> ScheduleOutput(const std::vector<uint32_t> &values)
+    {
+        std::vector<unsigned char> output;
+        for (uint32_t value : values)
+        {
+            dev::bytes word = dev::h256(value).asBytes();
+            output.insert(output.end(), word.begin(), word.end());
+        }
+        return output;
+    }
+
+    // The defaults in the order of ScheduleOutput times nFactor, and 1 for the ones that are 0: the values are
+    // checked against the defaults
+    static std::vector<uint32_t> ScheduleValues(uint32_t nFactor)
+    {
+        const dev::eth::EVMSchedule &schedule = dev::eth::EIP158Schedule;
+        std::vector<uint32_t> values = {schedule.tierStepGas[0], schedule.tierStepGas[1], schedule.tierStepGas[2],
+                                        schedule.tierStepGas[3], schedule.tierStepGas[4], schedule.tierStepGas[5],
+                                        schedule.tierStepGas[6], schedule.tierStepGas[7], schedule.expGas,
+                                        schedule.expByteGas, schedule.sha3Gas, schedule.sha3WordGas, schedule.sloadGas,
+                                        schedule.sstoreSetGas, schedule.sstoreResetGas, schedule.sstoreRefundGas,
+                                        schedule.jumpdestGas, schedule.logGas, schedule.logDataGas,
+                                        schedule.logTopicGas, schedule.createGas, schedule.callGas,
+                                        schedule.callStipend, schedule.callValueTransferGas,
+                                        schedule.callNewAccountGas, schedule.suicideRefundGas, schedule.memoryGas,
+                                        schedule.quadCoeffDiv, schedule.createDataGas, schedule.txGas,
+                                        schedule.txCreateGas, schedule.txDataZeroGas, schedule.txDataNonZeroGas,
+                                        schedule.copyGas, schedule.extcodesizeGas, schedule.extcodecopyGas,
+                                        schedule.balanceGas, schedule.suicideGas, schedule.maxCodeSize};
+        for (uint32_t &value : values)
+            value = value ? nFactor * value : 1;
+        BOOST_REQUIRE_EQUAL(values.size(), 39U);
+        return values;
+    }
+
+    BOOST_AUTO_TEST_CASE(dgp_evm_gas_schedule)
+    {
+        const dev::eth::EVMSchedule &schedule = dev::eth::EIP158Schedule;
+        std::vector<uint32_t> values = ScheduleValues(2);
+
+        fs::path ph = fs::temp_directory_path() / fs::unique_path();
+        {
+            SbtcState state(dev::u256(0),
+                            SbtcState::openDB(ph.string(), dev::sha3(dev::rlp("")), dev::WithExisting::Kill),
+                            ph.string(), dev::eth::BaseState::Empty);
+            SetProposal(state, GasScheduleDGP, 100, templateAddress);
+
+            int nCalls = 0;
+            SbtcDGP dgp(&state, true, [&](const dev::Address &addr, const std::vector<unsigned char> &data)
+            {
+                nCalls++;
+                BOOST_CHECK(addr == templateAddress);
+                BOOST_CHECK(data == ParseHex("26fadbe2"));
+                return ScheduleOutput(values);
+            });
+
+            // before the proposal takes effect the template is not called
+            dev::eth::EVMSchedule before = dgp.getGasSchedule(99);
+            BOOST_CHECK_EQUAL(nCalls, 0);
+            BOOST_CHECK_EQUAL(before.sstoreSetGas, schedule.sstoreSetGas);
+
+            dev::eth::EVMSchedule after = dgp.getGasSchedule(100);
+            BOOST_CHECK_EQUAL(nCalls, 1);
+            BOOST_CHECK_EQUAL(after.tierStepGas[0], 1U);
+            BOOST_CHECK_EQUAL(after.tierStepGas[1], 2 * schedule.tierStepGas[1]);
+            BOOST_CHECK_EQUAL(after.sstoreSetGas, 2 * schedule.sstoreSetGas);
+            BOOST_CHECK_EQUAL(after.txGas, 2 * schedule.txGas);
+            BOOST_CHECK_EQUAL(after.maxCodeSize, 2 * schedule.maxCodeSize);
+
+            // the other parameters have no proposal, they keep their defaults without running any template:
+            // reading the block gas limit must not call back into the templates
+            BOOST_CHECK_EQUAL(dgp.getBlockGasLimit(100), DEFAULT_BLOCK_GAS_LIMIT_DGP);
+            BOOST_CHECK_EQUAL(dgp.getMinGasPrice(100), DEFAULT_MIN_GAS_PRICE_DGP);
+            BOOST_CHECK_EQUAL(nCalls, 1);
+
+            // a schedule outside of the limits around the defaults is ignored
+            values[13] = 1000 * schedule.sstoreSetGas + 1;
+            BOOST_CHECK_EQUAL(dgp.getGasSchedule(100).sstoreSetGas, schedule.sstoreSetGas);
+            BOOST_CHECK_EQUAL(nCalls, 2);
+        }
+        fs::remove_all(ph);
+    }
+
+    BOOST_AUTO_TEST_CASE(dgp_cache)
+    {
+        const dev::eth::EVMSchedule &schedule = dev::eth::EIP158Schedule;
+        // the defaults but for sstoreSetGas, doubled
+        std::vector<uint32_t> values = ScheduleValues(1);
+        values[13] = 2 * schedule.sstoreSetGas;
+
+        fs::path ph = fs::temp_directory_path() / fs::unique_path();
+        {
+            SbtcState state(dev::u256(0),
+                            SbtcState::openDB(ph.string(), dev::sha3(dev::rlp("")), dev::WithExisting::Kill),
+                            ph.string(), dev::eth::BaseState::Empty);
+            state.commit(dev::eth::State::CommitBehaviour::KeepEmptyAccounts);
+
+            // what GetDGPParams computes, counted
+            int nComputed = 0;
+            auto compute = [&](int height)
+            {
+                return [&, height]()
+                {
+                    nComputed++;
+                    SbtcDGP dgp(&state, true, [&](const dev::Address &, const std::vector<unsigned char> &)
+                    {
+                        return ScheduleOutput(values);
+                    });
+                    DGPParams params;
+                    params.schedule = dgp.getGasSchedule(height);
+                    params.minGasPrice = dgp.getMinGasPrice(height);
+                    params.blockGasLimit = dgp.getBlockGasLimit(height);
+                    return params;
+                };
+            };
+
+            CDGPCache cache;
+            const dev::h256 rootBefore = state.rootHash();
+            BOOST_CHECK_EQUAL(cache.Get(100, rootBefore, compute(100)).schedule.sstoreSetGas,
+                              schedule.sstoreSetGas);
+            BOOST_CHECK_EQUAL(nComputed, 1);
+            BOOST_CHECK_EQUAL(cache.Get(100, rootBefore, compute(100)).schedule.sstoreSetGas,
+                              schedule.sstoreSetGas);
+            BOOST_CHECK_EQUAL(nComputed, 1);
+
+            // a proposal changes the root at the same height: the entry of the old root is not used
+            SetProposal(state, GasScheduleDGP, 100, templateAddress);
+            state.commit(dev::eth::State::CommitBehaviour::KeepEmptyAccounts);
+            const dev::h256 rootAfter = state.rootHash();
+            BOOST_REQUIRE(rootAfter != rootBefore);
+            BOOST_CHECK_EQUAL(cache.Get(100, rootAfter, compute(100)).schedule.sstoreSetGas,
+                              2 * schedule.sstoreSetGas);
+            BOOST_CHECK_EQUAL(nComputed, 2);
+            BOOST_CHECK_EQUAL(cache.Size(), 2U);
+
+            // past the limit the lowest heights go first
+            cache.Clear();
+            for (int height = 101; height <= 109; height++)
+                cache.Get(height, rootAfter, compute(height));
+            BOOST_CHECK_EQUAL(cache.Size(), MAX_DGP_CACHE_ENTRIES);
+            nComputed = 0;
+            for (int height = 102; height <= 109; height++)
+                cache.Get(height, rootAfter, compute(height));
+            BOOST_CHECK_EQUAL(nComputed, 0);
+            cache.Get(101, rootAfter, compute(101));
+            BOOST_CHECK_EQUAL(nComputed, 1);
+
+            // a disconnect back to height 104 keeps the parameters of the next block
+            cache.EraseAbove(105);
+            BOOST_CHECK_EQUAL(cache.Size(), 4U);
+            cache.Get(105, rootAfter, compute(105));
+            BOOST_CHECK_EQUAL(nComputed, 1);
+            cache.Get(106, rootAfter, compute(106));
+            BOOST_CHECK_EQUAL(nComputed, 2);
+        }
+        fs::remove_all(ph);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
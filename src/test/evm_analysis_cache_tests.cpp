@@ -0,0 +1,90 @@
+// Copyright (c) 2018 The Super Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "contract/libdevcore/SHA3.h"
+#include "contract/libevm/VMAnalysisCache.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace dev;
+using namespace dev::eth;
+
+BOOST_FIXTURE_TEST_SUITE(evm_analysis_cache_tests, BasicTestingSetup)
+
+    static std::shared_ptr<VMCodeAnalysis const> MakeAnalysis(const bytes &code)
+    {
+        std::shared_ptr<VMCodeAnalysis> analysis = std::make_shared<VMCodeAnalysis>();
+        analysis->codeSize = code.size();
+        analysis->code = code;
+        return analysis;
+    }
+
+    BOOST_AUTO_TEST_CASE(evm_analysis_cache_hit)
+    {
+        VMAnalysisCache cache;
+        const bytes codeA(100, 0xa1);
+        const h256 hashA = sha3(codeA);
+
+        BOOST_CHECK(!cache.get(hashA, codeA.size()));
+        BOOST_CHECK_EQUAL(cache.misses(), 1U);
+
+        std::shared_ptr<VMCodeAnalysis const> analysisA = MakeAnalysis(codeA);
+        cache.store(hashA, analysisA);
+        BOOST_CHECK_EQUAL(cache.size(), 1U);
+        BOOST_CHECK(cache.get(hashA, codeA.size()) == analysisA);
+        BOOST_CHECK(cache.get(hashA, codeA.size()) == analysisA);
+        BOOST_CHECK_EQUAL(cache.hits(), 2U);
+        BOOST_CHECK_EQUAL(cache.misses(), 1U);
+    }
+
+    BOOST_AUTO_TEST_CASE(evm_analysis_cache_keyed_by_code_hash)
+    {
+        VMAnalysisCache cache;
+        const bytes codeA(100, 0xa1), codeB(100, 0xb1);
+        const h256 hashA = sha3(codeA), hashB = sha3(codeB);
+        std::shared_ptr<VMCodeAnalysis const> analysisA = MakeAnalysis(codeA), analysisB = MakeAnalysis(codeB);
+
+        // code of the same size under another hash is not answered with the analysis of the first
+        cache.store(hashA, analysisA);
+        BOOST_CHECK(!cache.get(hashB, codeB.size()));
+        cache.store(hashB, analysisB);
+        BOOST_CHECK_EQUAL(cache.size(), 2U);
+        BOOST_CHECK(cache.get(hashA, codeA.size()) == analysisA);
+        BOOST_CHECK(cache.get(hashB, codeB.size()) == analysisB);
+
+        // an entry whose size does not match the code is not used
+        BOOST_CHECK(!cache.get(hashA, codeA.size() + 1));
+        BOOST_CHECK_EQUAL(cache.hits(), 2U);
+        BOOST_CHECK_EQUAL(cache.misses(), 2U);
+    }
+
+    BOOST_AUTO_TEST_CASE(evm_analysis_cache_eviction)
+    {
+        VMAnalysisCache cache;
+        const size_t nMax = 512;
+        std::vector<h256> vHashes;
+        for (size_t i = 0; i <= nMax; i++)
+        {
+            bytes code(32, 0);
+            code[0] = i & 0xff;
+            code[1] = i >> 8;
+            vHashes.push_back(sha3(code));
+            cache.store(vHashes.back(), MakeAnalysis(code));
+            BOOST_CHECK_EQUAL(cache.size(), std::min(i + 1, nMax));
+        }
+
+        // storing past the limit evicted exactly one of the earlier entries, and kept the new one
+        BOOST_CHECK(cache.get(vHashes.back(), 32));
+        size_t nEvicted = 0;
+        for (size_t i = 0; i < nMax; i++)
+        {
+            if (!cache.get(vHashes[i], 32))
+                nEvicted++;
+        }
+        BOOST_CHECK_EQUAL(nEvicted, 1U);
+        BOOST_CHECK_EQUAL(cache.hits() + cache.misses(), nMax + 1);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
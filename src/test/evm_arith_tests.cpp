@@ -0,0 +1,114 @@
+// Copyright (c) 2018 The Super Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "contract/libevm/VMArith.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace dev;
+using namespace dev::eth;
+
+BOOST_FIXTURE_TEST_SUITE(evm_arith_tests, BasicTestingSetup)
+
+    static uint64_t RandLimb()
+    {
+        switch (InsecureRandRange(5))
+        {
+            case 0:
+                return 0;
+            case 1:
+                return ~uint64_t(0);
+            case 2:
+                return InsecureRandRange(16);
+            case 3:
+                return uint64_t(1) << InsecureRandRange(64);
+            default:
+                return InsecureRandBits(64);
+        }
+    }
+
+    /// Random word biased towards the limb patterns where carries, borrows and signs change.
+    static u256 RandWord()
+    {
+        int limbs = 1 + InsecureRandRange(4);
+        u256 r = 0;
+        for (int i = 0; i < limbs; ++i)
+            r = (r << 64) | RandLimb();
+        return r;
+    }
+
+    static const u256 c_max = ~u256(0);
+    static const u256 c_minSigned = u256(1) << 255;
+
+    static std::vector<u256> EdgeWords()
+    {
+        return {0, 1, 2, 3, 7, 64, 255, 256, u256(~uint64_t(0)), u256(1) << 64, (u256(1) << 64) + 1,
+                (u256(1) << 128) - 1, c_minSigned - 1, c_minSigned, c_minSigned + 1, c_max - 1, c_max};
+    }
+
+    static void CheckBinary(u256 const &a, u256 const &b)
+    {
+        BOOST_CHECK_EQUAL(arith::add(a, b), a + b);
+        BOOST_CHECK_EQUAL(arith::sub(a, b), a - b);
+        BOOST_CHECK_EQUAL(arith::mul(a, b), a * b);
+        BOOST_CHECK_EQUAL(arith::div(a, b), arith::divRef(a, b));
+        BOOST_CHECK_EQUAL(arith::mod(a, b), arith::modRef(a, b));
+        BOOST_CHECK_EQUAL(arith::sdiv(a, b), arith::sdivRef(a, b));
+        BOOST_CHECK_EQUAL(arith::smod(a, b), arith::smodRef(a, b));
+    }
+
+    static void CheckTernary(u256 const &a, u256 const &b, u256 const &m)
+    {
+        BOOST_CHECK_EQUAL(arith::addmod(a, b, m), arith::addmodRef(a, b, m));
+        BOOST_CHECK_EQUAL(arith::mulmod(a, b, m), arith::mulmodRef(a, b, m));
+    }
+
+    BOOST_AUTO_TEST_CASE(edge_values)
+    {
+        std::vector<u256> edges = EdgeWords();
+        for (u256 const &a : edges)
+            for (u256 const &b : edges)
+            {
+                CheckBinary(a, b);
+                for (u256 const &m : edges)
+                    CheckTernary(a, b, m);
+            }
+
+        BOOST_CHECK_EQUAL(arith::sdiv(c_minSigned, c_max), c_minSigned);
+        BOOST_CHECK_EQUAL(arith::smod(c_minSigned, c_max), 0);
+        BOOST_CHECK_EQUAL(arith::div(c_max, 0), 0);
+        BOOST_CHECK_EQUAL(arith::addmod(c_max, c_max, 0), 0);
+    }
+
+    BOOST_AUTO_TEST_CASE(random_values)
+    {
+        for (int i = 0; i < 20000; ++i)
+        {
+            u256 a = RandWord();
+            u256 b = RandWord();
+            CheckBinary(a, b);
+            CheckTernary(a, b, RandWord());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(exp_values)
+    {
+        std::vector<u256> edges = EdgeWords();
+        for (u256 const &a : edges)
+            for (u256 const &b : edges)
+                BOOST_CHECK_EQUAL(arith::exp(a, b), arith::expRef(a, b));
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            u256 a = RandWord();
+            u256 b = RandWord();
+            BOOST_CHECK_EQUAL(arith::exp(a, b), arith::expRef(a, b));
+        }
+        BOOST_CHECK_EQUAL(arith::exp(2, 255), c_minSigned);
+        BOOST_CHECK_EQUAL(arith::exp(2, 256), 0);
+        BOOST_CHECK_EQUAL(arith::exp(0, 0), 1);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
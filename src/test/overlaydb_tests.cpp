@@ -0,0 +1,169 @@
+// Copyright (c) 2018 The Super Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "contract/libdevcore/NodeCache.h"
+#include "contract/libdevcore/OverlayDB.h"
+#include "contract/libdevcore/SHA3.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace dev;
+
+struct OverlayDBTestingSetup : public BasicTestingSetup
+{
+    fs::path ph;
+    ldb::DB *db;
+    OverlayDB odb;
+
+    OverlayDBTestingSetup() : ph(fs::temp_directory_path() / fs::unique_path()), db(nullptr)
+    {
+        ldb::Options options;
+        options.create_if_missing = true;
+        BOOST_REQUIRE(ldb::DB::Open(options, ph.string(), &db).ok());
+        odb = OverlayDB(db);
+    }
+
+    ~OverlayDBTestingSetup()
+    {
+        // closes the database before its files go
+        odb = OverlayDB();
+        fs::remove_all(ph);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(overlaydb_tests, OverlayDBTestingSetup)
+
+    static std::string DiskGet(ldb::DB *db, const h256 &key)
+    {
+        std::string value;
+        db->Get(ldb::ReadOptions(), ldb::Slice((char const *)key.data(), key.size), &value);
+        return value;
+    }
+
+    BOOST_AUTO_TEST_CASE(overlaydb_stage_flush)
+    {
+        OverlayDB view = odb.diskView();
+
+        std::string kept = "kept node";
+        std::string dropped = "dropped node";
+        h256 hashKept = sha3(kept);
+        h256 hashDropped = sha3(dropped);
+        odb.insert(hashKept, bytesConstRef(kept));
+        odb.insert(hashDropped, bytesConstRef(dropped));
+        odb.kill(hashDropped);
+        BOOST_CHECK(view.lookup(hashKept).empty());
+
+        // a node staged inside a layer stays in the layer
+        odb.pushLayer();
+        odb.stage();
+        BOOST_CHECK_EQUAL(odb.stagedMemoryUsage(), 0U);
+        odb.mergeLayer();
+
+        // staged nodes are readable through the views, but not on disk yet
+        odb.stage();
+        BOOST_CHECK(odb.stagedMemoryUsage() > 0);
+        BOOST_CHECK_EQUAL(view.lookup(hashKept), kept);
+        BOOST_CHECK(view.exists(hashKept));
+        BOOST_CHECK(!view.exists(hashDropped));
+        BOOST_CHECK(DiskGet(db, hashKept).empty());
+
+        // staging the same node again does not count it twice
+        size_t usage = odb.stagedMemoryUsage();
+        odb.insert(hashKept, bytesConstRef(kept));
+        odb.stage();
+        BOOST_CHECK_EQUAL(odb.stagedMemoryUsage(), usage);
+
+        odb.flush();
+        BOOST_CHECK_EQUAL(odb.stagedMemoryUsage(), 0U);
+        BOOST_CHECK_EQUAL(DiskGet(db, hashKept), kept);
+        BOOST_CHECK(DiskGet(db, hashDropped).empty());
+        BOOST_CHECK_EQUAL(view.lookup(hashKept), kept);
+
+        // commit still writes through
+        std::string other = "other node";
+        odb.insert(sha3(other), bytesConstRef(other));
+        odb.commit();
+        BOOST_CHECK_EQUAL(odb.stagedMemoryUsage(), 0U);
+        BOOST_CHECK_EQUAL(DiskGet(db, sha3(other)), other);
+    }
+
+    BOOST_AUTO_TEST_CASE(nodecache_lru)
+    {
+        std::vector<std::string> nodes;
+        for (int i = 0; i < 4; i++)
+            nodes.push_back(std::string(100, 'a' + i));
+        // room for three of them
+        NodeCache cache(3 * (100 + 32 + 128));
+        for (int i = 0; i < 3; i++)
+            cache.insert(sha3(nodes[i]), nodes[i]);
+        BOOST_CHECK_EQUAL(cache.stats().entries, 3U);
+
+        // touching the oldest keeps it, the next oldest goes
+        BOOST_CHECK_EQUAL(cache.lookup(sha3(nodes[0])), nodes[0]);
+        cache.insert(sha3(nodes[3]), nodes[3]);
+        BOOST_CHECK_EQUAL(cache.stats().entries, 3U);
+        BOOST_CHECK(cache.lookup(sha3(nodes[1])).empty());
+        BOOST_CHECK_EQUAL(cache.lookup(sha3(nodes[0])), nodes[0]);
+        BOOST_CHECK_EQUAL(cache.lookup(sha3(nodes[3])), nodes[3]);
+
+        cache.erase(sha3(nodes[3]));
+        BOOST_CHECK(cache.lookup(sha3(nodes[3])).empty());
+
+        NodeCache::Stats stats = cache.stats();
+        BOOST_CHECK_EQUAL(stats.hits, 3U);
+        BOOST_CHECK_EQUAL(stats.misses, 2U);
+        BOOST_CHECK_EQUAL(stats.entries, 2U);
+        BOOST_CHECK(stats.memoryUsage <= stats.maxMemoryUsage);
+    }
+
+    BOOST_AUTO_TEST_CASE(overlaydb_nodecache)
+    {
+        std::shared_ptr<NodeCache> cache = std::make_shared<NodeCache>(1 << 20);
+        odb.setNodeCache(cache);
+        OverlayDB view = odb.diskView();
+
+        std::string node = "cached node";
+        odb.insert(sha3(node), bytesConstRef(node));
+        odb.commit();
+
+        // the first read goes to disk, the next ones of any overlay sharing the cache do not
+        BOOST_CHECK_EQUAL(odb.lookup(sha3(node)), node);
+        BOOST_CHECK_EQUAL(view.lookup(sha3(node)), node);
+        BOOST_CHECK_EQUAL(cache->stats().misses, 1U);
+        BOOST_CHECK_EQUAL(cache->stats().hits, 1U);
+
+        // a node taken off the disk is taken out of the cache
+        odb.deepkill(sha3(node));
+        BOOST_CHECK(view.lookup(sha3(node)).empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(overlaydb_sweep)
+    {
+        OverlayDB view = odb.diskView();
+        std::string stale = "stale node";
+        std::string rewritten = "rewritten node";
+        odb.insert(sha3(stale), bytesConstRef(stale));
+        odb.insert(sha3(rewritten), bytesConstRef(rewritten));
+        odb.commit();
+
+        // a node written again while the sweep runs stays on disk
+        view.beginSweep();
+        odb.insert(sha3(rewritten), bytesConstRef(rewritten));
+        odb.commit();
+        BOOST_CHECK_EQUAL(view.sweep({sha3(stale), sha3(rewritten)}), 1U);
+        view.endSweep();
+        BOOST_CHECK(DiskGet(db, sha3(stale)).empty());
+        BOOST_CHECK_EQUAL(DiskGet(db, sha3(rewritten)), rewritten);
+
+        // outside of a sweep nothing is remembered
+        odb.insert(sha3(stale), bytesConstRef(stale));
+        odb.commit();
+        view.beginSweep();
+        BOOST_CHECK_EQUAL(view.sweep({sha3(stale)}), 1U);
+        view.endSweep();
+        BOOST_CHECK(odb.lookup(sha3(stale)).empty());
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
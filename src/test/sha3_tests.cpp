@@ -0,0 +1,95 @@
+// Copyright (c) 2018 The Super Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "contract/libdevcore/RLP.h"
+#include "contract/libdevcore/SHA3.h"
+#include "contract/libdevcore/TrieHash.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace dev;
+
+BOOST_FIXTURE_TEST_SUITE(sha3_tests, BasicTestingSetup)
+
+    static bytes Counting(size_t size)
+    {
+        bytes data(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = (byte)i;
+        return data;
+    }
+
+    // Keccak-256 as Ethereum uses it, padding 0x01 rather than the 0x06 of FIPS 202 SHA3-256
+    static const struct
+    {
+        bytes input;
+        std::string hash;
+    } vectors[] = {
+            {bytes(), "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470"},
+            {asBytes("abc"), "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45"},
+            {asBytes("The quick brown fox jumps over the lazy dog"),
+             "4d741b6f1eb29cb2a9b9911c82f56fa8d73b04959d3d9d222895df6c0b28aa15"},
+            // around the 136 byte rate, the last one taking a third block
+            {Counting(135), "cbdfd9dee5faad3818d6b06f95a219fd290b0e1706f6a82e5a595b9ce9faca62"},
+            {Counting(136), "7ce759f1ab7f9ce437719970c26b0a66ff11fe3e38e17df89cf5d29c7d7f807e"},
+            {Counting(137), "ac73d4fae68b8453f764007c1a20ce95994187861f0c3227a3a8e99a73a3b1db"},
+            {bytes(200, 0xa3), "3a57666b048777f2c953dc4456f45a2588e1cb6f2da760122d530ac2ce607d4a"},
+            {Counting(272), "fdf2ec49e749960d3c8521a0219af8d03e30e2b3bf19bd16150ee0eaf133d66e"},
+    };
+
+    static const char *implementations[] = {"standard", "unrolled", "bmi2", "avx2"};
+
+    BOOST_AUTO_TEST_CASE(sha3_known_answers)
+    {
+        for (const char *implementation : implementations)
+        {
+            if (!sha3UseImplementation(implementation))
+                continue;
+            for (const auto &v : vectors)
+                BOOST_CHECK_MESSAGE(sha3(v.input) == h256(v.hash), implementation << " " << v.hash);
+        }
+        BOOST_CHECK(!sha3UseImplementation("unknown"));
+        sha3AutoDetect();
+    }
+
+    BOOST_AUTO_TEST_CASE(sha3_batch)
+    {
+        // batches of every length, and inputs of different block counts side by side
+        std::vector<bytesConstRef> inputs;
+        for (size_t i = 0; i < 3; i++)
+            for (const auto &v : vectors)
+                inputs.push_back(bytesConstRef(&v.input));
+        for (const char *implementation : implementations)
+        {
+            if (!sha3UseImplementation(implementation))
+                continue;
+            for (size_t count = 0; count <= inputs.size(); count++)
+            {
+                std::vector<h256> outputs(count);
+                sha3(inputs.data(), outputs.data(), count);
+                for (size_t i = 0; i < count; i++)
+                    BOOST_CHECK_MESSAGE(outputs[i] == h256(vectors[i % (sizeof(vectors) / sizeof(vectors[0]))].hash),
+                                        implementation << " " << count << " " << i);
+            }
+        }
+        sha3AutoDetect();
+    }
+
+    BOOST_AUTO_TEST_CASE(sha3_trie_root)
+    {
+        std::vector<bytes> receipts;
+        for (unsigned i = 0; i < 300; i++)
+            receipts.push_back(rlpList(i, bytes(i % 70, (byte)i)));
+        sha3UseImplementation("standard");
+        h256 root = orderedTrieRoot(receipts);
+        for (const char *implementation : implementations)
+        {
+            if (sha3UseImplementation(implementation))
+                BOOST_CHECK_MESSAGE(orderedTrieRoot(receipts) == root, implementation);
+        }
+        sha3AutoDetect();
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
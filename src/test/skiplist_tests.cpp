@@ -198,4 +198,79 @@ BOOST_FIXTURE_TEST_SUITE(skiplist_tests, BasicTestingSetup)
         BOOST_CHECK(!chain.FindEarliestAtLeast(int64_t(std::numeric_limits<unsigned int>::max()) + 1));
     }
 
+    BOOST_AUTO_TEST_CASE(chainview_test)
+    {
+        // a main branch over several chunks, and a side branch forking inside the last one
+        const int nMain = CChainView::CHUNK_SIZE * 3 + 100;
+        const int nForkHeight = CChainView::CHUNK_SIZE * 3 + 10;
+        std::vector<uint256> vHashMain(nMain);
+        std::vector<CBlockIndex> vBlocksMain(nMain);
+        for (int i = 0; i < nMain; i++)
+        {
+            vHashMain[i] = ArithToUint256(i);
+            vBlocksMain[i].nHeight = i;
+            vBlocksMain[i].pprev = i ? &vBlocksMain[i - 1] : nullptr;
+            vBlocksMain[i].phashBlock = &vHashMain[i];
+            vBlocksMain[i].BuildSkip();
+        }
+        std::vector<uint256> vHashSide(200);
+        std::vector<CBlockIndex> vBlocksSide(200);
+        for (unsigned int i = 0; i < vBlocksSide.size(); i++)
+        {
+            vHashSide[i] = ArithToUint256(nMain + i);
+            vBlocksSide[i].nHeight = nForkHeight + 1 + i;
+            vBlocksSide[i].pprev = i ? &vBlocksSide[i - 1] : &vBlocksMain[nForkHeight];
+            vBlocksSide[i].phashBlock = &vHashSide[i];
+            vBlocksSide[i].BuildSkip();
+        }
+
+        CChain chain;
+        CChainViewPublisher publisher;
+        BOOST_CHECK(publisher.GetView()->Tip() == nullptr);
+        BOOST_CHECK_EQUAL(publisher.GetView()->Height(), -1);
+
+        // extend one block at a time, every view keeps its own tip
+        std::vector<std::shared_ptr<const CChainView>> vViews;
+        for (int i = 0; i < nMain; i++)
+        {
+            chain.SetTip(&vBlocksMain[i]);
+            publisher.Publish(chain);
+            if (i % 1000 == 0 || i == nMain - 1)
+                vViews.push_back(publisher.GetView());
+        }
+        std::shared_ptr<const CChainView> mainView = publisher.GetView();
+        BOOST_CHECK(mainView->Tip() == &vBlocksMain.back());
+        BOOST_CHECK(mainView->Genesis() == &vBlocksMain[0]);
+        for (const auto &view : vViews)
+        {
+            BOOST_CHECK(view->Tip() == &vBlocksMain[view->Height()]);
+            for (int h = 0; h <= view->Height(); h += 97)
+                BOOST_CHECK((*view)[h] == &vBlocksMain[h]);
+            BOOST_CHECK((*view)[view->Height() + 1] == nullptr);
+        }
+
+        // reorganize to the side branch: the views of the main branch do not change
+        chain.SetTip(&vBlocksSide.back());
+        publisher.Publish(chain);
+        std::shared_ptr<const CChainView> sideView = publisher.GetView();
+        BOOST_CHECK(sideView->GetVersion() > mainView->GetVersion());
+        BOOST_CHECK(sideView->Tip() == &vBlocksSide.back());
+        BOOST_CHECK((*sideView)[nForkHeight] == &vBlocksMain[nForkHeight]);
+        BOOST_CHECK((*sideView)[nForkHeight + 1] == &vBlocksSide[0]);
+        BOOST_CHECK(!sideView->Contains(&vBlocksMain[nForkHeight + 1]));
+        BOOST_CHECK(sideView->FindFork(&vBlocksMain.back()) == &vBlocksMain[nForkHeight]);
+        for (int h = nForkHeight + 1; h < nMain; h++)
+            BOOST_CHECK((*mainView)[h] == &vBlocksMain[h]);
+
+        // and back, through a shorter tip
+        chain.SetTip(&vBlocksMain[nForkHeight - 5]);
+        publisher.Publish(chain);
+        chain.SetTip(&vBlocksMain.back());
+        publisher.Publish(chain);
+        for (int h = nForkHeight + 1; h < nForkHeight + 1 + (int)vBlocksSide.size(); h++)
+            BOOST_CHECK((*sideView)[h] == &vBlocksSide[h - nForkHeight - 1]);
+        BOOST_CHECK(publisher.GetView()->Tip() == &vBlocksMain.back());
+        BOOST_CHECK(publisher.GetView()->GetLocator().vHave == chain.GetLocator().vHave);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+// Copyright (c) 2018 The Super Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "contract-api/sbtcstate.h"
+#include "contract-api/statepruner.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace dev;
+
+struct StatePrunerTestingSetup : public BasicTestingSetup
+{
+    fs::path pathState;
+    std::unique_ptr<SbtcState> state;
+    eth::SecureTrieDB<Address, OverlayDB> utxo;
+
+    StatePrunerTestingSetup() : pathState(fs::temp_directory_path() / fs::unique_path())
+    {
+        state.reset(new SbtcState(u256(0), SbtcState::openDB(pathState.string(), sha3(rlp("")), WithExisting::Kill),
+                                  pathState.string(), eth::BaseState::Empty));
+        utxo = eth::SecureTrieDB<Address, OverlayDB>(&state->dbUtxo());
+        utxo.init();
+    }
+
+    ~StatePrunerTestingSetup()
+    {
+        state.reset();
+        fs::remove_all(pathState);
+    }
+
+    /** Writes the state and the UTXO trie to disk like a connected block, returns their roots */
+    std::pair<h256, h256> ConnectBlock(const std::unordered_map<Address, Vin> &vins)
+    {
+        state->commit(eth::State::CommitBehaviour::KeepEmptyAccounts);
+        sbtc::commit(vins, utxo, std::unordered_map<Address, eth::Account>());
+        state->db().commit();
+        state->dbUtxo().commit();
+        return std::make_pair(state->rootHash(), utxo.root());
+    }
+
+    /** Prunes the nodes the given blocks do not reach */
+    bool Prune(const std::vector<std::pair<h256, h256>> &vRoots, size_t &nDeleted)
+    {
+        std::vector<h256> vStateRoots, vUTXORoots;
+        for (const auto &roots : vRoots)
+        {
+            vStateRoots.push_back(roots.first);
+            vUTXORoots.push_back(roots.second);
+        }
+        CStatePruner pruner(state->db(), state->dbUtxo(), (int)vRoots.size());
+        state->db().beginSweep();
+        state->dbUtxo().beginSweep();
+        size_t nKept = 0;
+        return pruner.MarkAndSweep(vStateRoots, vUTXORoots, nDeleted, nKept);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(statepruner_tests, StatePrunerTestingSetup)
+
+    static std::set<h256> DiskNodes(const OverlayDB &db)
+    {
+        std::set<h256> nodes;
+        std::unique_ptr<ldb::Iterator> it(db.db()->NewIterator(ldb::ReadOptions()));
+        for (it->SeekToFirst(); it->Valid(); it->Next())
+        {
+            if (it->key().size() == h256::size)
+                nodes.insert(h256((byte const *)it->key().data(), h256::ConstructFromPointer));
+        }
+        return nodes;
+    }
+
+    static Vin MakeVin(uint8_t n)
+    {
+        Vin vin;
+        vin.hash = sha3(bytes(1, n));
+        vin.nVout = n;
+        vin.value = 1000 * n;
+        vin.alive = 1;
+        return vin;
+    }
+
+    BOOST_AUTO_TEST_CASE(statepruner_mark_sweep)
+    {
+        const Address a("00000000000000000000000000000000000000a1");
+        const Address b("00000000000000000000000000000000000000b1");
+        const Address c("00000000000000000000000000000000000000c1");
+        const bytes codeA(100, 0xa1), codeB(100, 0xb1), codeC(40, 0xc1);
+
+        // block 1: a and b, with storage and code
+        state->createContract(a);
+        state->setNewCode(a, bytes(codeA));
+        state->setStorage(a, 1, 11);
+        state->setStorage(a, 2, 12);
+        state->createContract(b);
+        state->setNewCode(b, bytes(codeB));
+        state->setStorage(b, 1, 21);
+        state->setStorage(b, 2, 22);
+        std::pair<h256, h256> roots1 = ConnectBlock({{a, MakeVin(1)}, {b, MakeVin(2)}});
+
+        // block 2: b is gone, a's storage changes, c comes
+        static_cast<eth::State &>(*state).kill(b);
+        state->setStorage(a, 2, 13);
+        state->createContract(c);
+        state->setNewCode(c, bytes(codeC));
+        state->setStorage(c, 5, 31);
+        Vin vinB = MakeVin(2);
+        vinB.alive = 0;
+        std::pair<h256, h256> roots2 = ConnectBlock({{b, vinB}, {c, MakeVin(3)}});
+
+        // block 3: a's storage changes again
+        state->setStorage(a, 1, 14);
+        std::pair<h256, h256> roots3 = ConnectBlock({{a, MakeVin(4)}});
+
+        std::set<h256> nodesBefore = DiskNodes(state->db());
+        std::set<h256> utxoNodesBefore = DiskNodes(state->dbUtxo());
+        BOOST_CHECK(nodesBefore.count(roots1.first));
+        BOOST_CHECK(nodesBefore.count(sha3(codeB)));
+        BOOST_CHECK(utxoNodesBefore.count(roots1.second));
+
+        // a root that is not on disk: nothing is deleted
+        size_t nDeleted = 0;
+        BOOST_CHECK(!Prune({roots2, std::make_pair(sha3(std::string("missing")), roots2.second)}, nDeleted));
+        BOOST_CHECK(DiskNodes(state->db()) == nodesBefore);
+        BOOST_CHECK(DiskNodes(state->dbUtxo()) == utxoNodesBefore);
+
+        BOOST_CHECK(Prune({roots2, roots3}, nDeleted));
+        BOOST_CHECK(nDeleted > 0);
+
+        // the retained blocks read whole: accounts, storage, code and UTXO entries
+        for (const auto &roots : {roots2, roots3})
+        {
+            SbtcState retained(u256(0), state->db(), state->dbUtxo(), roots.first, roots.second);
+            BOOST_CHECK_EQUAL(retained.addresses().size(), 2U);
+            BOOST_CHECK(!retained.addressInUse(b));
+            BOOST_CHECK(retained.code(a) == codeA);
+            BOOST_CHECK(retained.code(c) == codeC);
+            BOOST_CHECK_EQUAL(retained.storage(a).size(), 2U);
+            BOOST_CHECK_EQUAL(retained.storage(a, 1), u256(roots == roots3 ? 14 : 11));
+            BOOST_CHECK_EQUAL(retained.storage(a, 2), u256(13));
+            BOOST_CHECK_EQUAL(retained.storage(c, 5), u256(31));
+
+            eth::SecureTrieDB<Address, OverlayDB> retainedUTXO(&state->dbUtxo(), roots.second);
+            size_t nEntries = 0;
+            for (auto it = retainedUTXO.begin(); it != retainedUTXO.end(); ++it)
+                nEntries++;
+            BOOST_CHECK_EQUAL(nEntries, 2U);
+            BOOST_CHECK(retainedUTXO.at(b).empty());
+        }
+
+        // what only block 1 reached is gone: its roots, b's code and storage, a's former storage
+        std::set<h256> nodesAfter = DiskNodes(state->db());
+        std::set<h256> utxoNodesAfter = DiskNodes(state->dbUtxo());
+        BOOST_CHECK(!nodesAfter.count(roots1.first));
+        BOOST_CHECK(!utxoNodesAfter.count(roots1.second));
+        BOOST_CHECK(!nodesAfter.count(sha3(codeB)));
+        BOOST_CHECK(nodesAfter.count(sha3(codeA)));
+        BOOST_CHECK_EQUAL(nodesBefore.size() + utxoNodesBefore.size() - nodesAfter.size() - utxoNodesAfter.size(),
+                          nDeleted);
+        BOOST_CHECK_THROW(SbtcState(u256(0), state->db(), state->dbUtxo(), roots1.first, roots1.second),
+                          RootNotFound);
+
+        // everything left is reachable, a second pass deletes nothing
+        BOOST_CHECK(Prune({roots2, roots3}, nDeleted));
+        BOOST_CHECK_EQUAL(nDeleted, 0U);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
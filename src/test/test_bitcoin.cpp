@@ -8,6 +8,7 @@
 #include "config/consensus.h"
 #include "chaincontrol/validation.h"
 #include "crypto/sha256.h"
+#include "contract/libdevcore/SHA3.h"
 #include "fs.h"
 #include "wallet/key.h"
 #include "block/validation.h"
@@ -46,6 +47,7 @@ extern void noui_connect();
 BasicTestingSetup::BasicTestingSetup(const std::string &chainName)
 {
     SHA256AutoDetect();
+    dev::sha3AutoDetect();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
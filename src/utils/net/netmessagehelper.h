@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "sbtccore/streams.h"
@@ -9,11 +10,11 @@
 template<typename... TArgs>
 bool SendNetMessage(int64_t nodeID, const std::string& command, int version, int flags, TArgs&& ... args)
 {
-    std::vector<unsigned char> msgData;
+    std::shared_ptr<std::vector<unsigned char>> msgData = std::make_shared<std::vector<unsigned char>>();
     {
-        CVectorWriter{SER_NETWORK, version | flags, msgData, 0, std::forward<TArgs>(args)...};
+        CVectorWriter{SER_NETWORK, version | flags, *msgData, 0, std::forward<TArgs>(args)...};
     }
     GET_NET_INTERFACE(ifNetObj);
-    return ifNetObj->SendNetMessage(nodeID, command, msgData);
+    return ifNetObj->SendNetMessage(nodeID, command, std::move(msgData));
 }
 